@@ -1,4 +1,5 @@
 #include "Entity.h"
+#include "Tilemap.h"
 
 Entity::Entity() {
   position = glm::vec3(0);
@@ -22,45 +23,77 @@ bool Entity::checkCollision(Entity *other) {
   return false;
 }
 
-void Entity::checkCollisionsY(Entity *objects, int objCount) {
-  for (int i = 0; i < objCount; i++) {
-    Entity *object = &objects[i];
-
-    if (checkCollision(object)) {
-      float ydist = std::fabs(position.y - object->position.y);
-      float penetrationY = std::fabs(ydist - (height / 2.0f) - (object->height / 2.0f));
-      if (velocity.y > 0) {
-        position.y -= penetrationY;
-        collidedTop = true;
-      } else if (velocity.y < 0) {
-        position.y += penetrationY;
-        collidedBottom = true;
+//checkCollision against the platform filling a cell of the map
+bool Entity::checkTile(const Tilemap *tiles, int column, int row) {
+  EntityType kind = tiles->At(column, row);
+  if (isActive == false || kind == NONE) { return false; }
+
+  glm::vec3 center = tiles->Center(column, row);
+  float xdist = std::fabs(position.x - center.x) - ((width + tiles->cellSize)/2);
+  float ydist = std::fabs(position.y - center.y) - ((height + tiles->cellSize)/2);
+
+  if (xdist < 0 && ydist < 0) {
+    lastCollision = kind;
+    return true;
+  }
+  return false;
+}
+
+//only the cells under us are looked at, nearest first in the way we are moving so the first hit
+//pushes us all the way out
+void Entity::checkCollisionsY(const Tilemap *tiles) {
+  int column0, row0, column1, row1;
+  if (tiles == NULL || tiles->Overlap(position, width / 2.0f, height / 2.0f, &column0, &row0, &column1, &row1) == false) {
+    return;
+  }
+
+  int rowCount = row1 - row0 + 1;
+  for (int r = 0; r < rowCount; r++) {
+    int row = velocity.y > 0 ? row0 + r : row1 - r;
+    for (int column = column0; column <= column1; column++) {
+      if (checkTile(tiles, column, row)) {
+        float ydist = std::fabs(position.y - tiles->Center(column, row).y);
+        float penetrationY = std::fabs(ydist - (height / 2.0f) - (tiles->cellSize / 2.0f));
+        if (velocity.y > 0) {
+          position.y -= penetrationY;
+          collidedTop = true;
+        } else if (velocity.y < 0) {
+          position.y += penetrationY;
+          collidedBottom = true;
+        }
+        velocity.y = 0;
       }
-      velocity.y = 0;
     }
   }
 }
 
-void Entity::checkCollisionsX(Entity *objects, int objCount) {
-  for (int i = 0; i < objCount; i++) {
-    Entity *object = &objects[i];
-
-    if (checkCollision(object)) {
-      float xdist = std::fabs(position.x - object->position.x);
-      float penetrationX = std::fabs(xdist - (width / 2.0f) - (object->width / 2.0f));
-      if (velocity.x > 0) {
-        position.x -= penetrationX;
-        collidedRight = true;
-      } else if (velocity.x < 0) {
-        position.x += penetrationX;
-        collidedLeft = true;
+void Entity::checkCollisionsX(const Tilemap *tiles) {
+  int column0, row0, column1, row1;
+  if (tiles == NULL || tiles->Overlap(position, width / 2.0f, height / 2.0f, &column0, &row0, &column1, &row1) == false) {
+    return;
+  }
+
+  int columnCount = column1 - column0 + 1;
+  for (int c = 0; c < columnCount; c++) {
+    int column = velocity.x > 0 ? column0 + c : column1 - c;
+    for (int row = row0; row <= row1; row++) {
+      if (checkTile(tiles, column, row)) {
+        float xdist = std::fabs(position.x - tiles->Center(column, row).x);
+        float penetrationX = std::fabs(xdist - (width / 2.0f) - (tiles->cellSize / 2.0f));
+        if (velocity.x > 0) {
+          position.x -= penetrationX;
+          collidedRight = true;
+        } else if (velocity.x < 0) {
+          position.x += penetrationX;
+          collidedLeft = true;
+        }
+        velocity.x = 0;
       }
-      velocity.x = 0;
     }
   }
 }
 
-void Entity::Update(float deltaTime, Entity *platforms, int platformCount) {
+void Entity::Update(float deltaTime, const Tilemap *tiles) {
   if (isActive == false) { return; }
 
   collidedTop = false;
@@ -77,10 +110,10 @@ void Entity::Update(float deltaTime, Entity *platforms, int platformCount) {
   velocity += acceleration * deltaTime;
 
   position.y += velocity.y * deltaTime;       //move on Y
-  checkCollisionsY(platforms, platformCount);  //fix if needed
+  checkCollisionsY(tiles);  //fix if needed
 
   position.x += velocity.x * deltaTime;       //move on X
-  checkCollisionsX(platforms, platformCount);  //fix if needed
+  checkCollisionsX(tiles);  //fix if needed
 
 
   modelMatrix = glm::mat4(1.0f);
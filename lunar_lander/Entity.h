@@ -11,10 +11,13 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "ParticleSystem.h"
 
 
 enum EntityType { PLAYER, WIN_PLATFORM, LOSE_PLATFORM, NONE };
 
+class Tilemap;
+
 class Entity {
 public:
     EntityType entityType;
@@ -40,14 +43,19 @@ public:
 
     GLuint textureID;
 
+    //effects played by the game when these happen, NULL for none
+    ParticleEmitter *onLand = NULL;
+    ParticleEmitter *onDeath = NULL;
+
     glm::mat4 modelMatrix;
 
     Entity();
 
     bool checkCollision(Entity *other);
-    void checkCollisionsY(Entity *objects, int objCount);
-    void checkCollisionsX(Entity *objects, int objCount);
-    void Update(float deltaTime, Entity *platforms, int platformCount);
+    bool checkTile(const Tilemap *tiles, int column, int row);
+    void checkCollisionsY(const Tilemap *tiles);
+    void checkCollisionsX(const Tilemap *tiles);
+    void Update(float deltaTime, const Tilemap *tiles);
     void Render(ShaderProgram *program);
     void DrawSpriteFromTextureAtlas(ShaderProgram *program, GLuint textureID, int index);
 };
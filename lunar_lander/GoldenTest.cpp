@@ -0,0 +1,271 @@
+#include "GoldenTest.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+struct GoldenKey {
+    const char *name;
+    SDL_Scancode scancode;
+    SDL_Keycode keycode;
+};
+
+static const GoldenKey GOLDEN_KEYS[] = {
+  { "LEFT", SDL_SCANCODE_LEFT, SDLK_LEFT },
+  { "RIGHT", SDL_SCANCODE_RIGHT, SDLK_RIGHT },
+  { "UP", SDL_SCANCODE_UP, SDLK_UP },
+  { "DOWN", SDL_SCANCODE_DOWN, SDLK_DOWN },
+  { "SPACE", SDL_SCANCODE_SPACE, SDLK_SPACE },
+};
+
+bool GoldenTest::Start(const char *scriptPath, const char *referenceDir, bool update, int width, int height) {
+  if (LoadScript(scriptPath) == false) { return false; }
+
+  this->referenceDir = referenceDir;
+  this->updateReferences = update;
+  this->width = width;
+  this->height = height;
+  memset(keys, 0, sizeof(keys));
+  if (update == false && FindReferences() == false) { return false; }
+
+  //render into our own framebuffer so a hidden window still gives us defined pixels
+  glGenFramebuffers(1, &framebuffer);
+  glGenRenderbuffers(1, &colorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    std::cout << "golden: unable to create offscreen framebuffer\n";
+    return false;
+  }
+
+  pixels = new unsigned char[width * height * 4];
+  flipped = new unsigned char[width * height * 4];
+  heatmap = new unsigned char[width * height * 4];
+
+  isRunning = true;
+  return true;
+}
+
+// script lines, frames count from 0:
+//   <frame> hold [KEY...]   keys held from this frame on, no keys releases everything
+//   <frame> press KEY...    key down events on this frame
+//   <frame> capture         compare this frame against the reference
+//   <frame> end             stop the run
+//   tolerance r g b a       per channel tolerance for the comparison
+bool GoldenTest::LoadScript(const char *scriptPath) {
+  std::ifstream infile(scriptPath);
+  if (infile.fail()) {
+    std::cout << "golden: unable to open script " << scriptPath << "\n";
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(infile, line)) {
+    std::istringstream words(line);
+    std::string first;
+    if (!(words >> first) || first[0] == '#') { continue; }
+
+    if (first == "tolerance") {
+      for (int c = 0; c < 4; c++) {
+        int t = 0;
+        words >> t;
+        tolerance[c] = (unsigned char)t;
+      }
+      continue;
+    }
+
+    GoldenCommand command;
+    command.frame = atoi(first.c_str());
+    command.keyCount = 0;
+
+    std::string type;
+    words >> type;
+    if (type == "hold") { command.type = GOLDEN_HOLD; }
+    else if (type == "press") { command.type = GOLDEN_PRESS; }
+    else if (type == "capture") { command.type = GOLDEN_CAPTURE; }
+    else if (type == "end") { command.type = GOLDEN_END; }
+    else {
+      std::cout << "golden: bad script line: " << line << "\n";
+      return false;
+    }
+
+    std::string name;
+    while (words >> name && command.keyCount < GOLDEN_MAX_KEYS) {
+      for (size_t k = 0; k < sizeof(GOLDEN_KEYS) / sizeof(GOLDEN_KEYS[0]); k++) {
+        if (name == GOLDEN_KEYS[k].name) {
+          command.scancodes[command.keyCount] = GOLDEN_KEYS[k].scancode;
+          command.keycodes[command.keyCount] = GOLDEN_KEYS[k].keycode;
+          command.keyCount++;
+        }
+      }
+    }
+    commands.push_back(command);
+  }
+
+  std::stable_sort(commands.begin(), commands.end(),
+                   [](const GoldenCommand &a, const GoldenCommand &b) { return a.frame < b.frame; });
+  return true;
+}
+
+//call before the game polls input
+void GoldenTest::BeginFrame() {
+  pressed.clear();
+  for (size_t i = nextCommand; i < commands.size() && commands[i].frame <= frame; i++) {
+    GoldenCommand &command = commands[i];
+    if (command.frame != frame) { continue; }
+
+    if (command.type == GOLDEN_HOLD) {
+      memset(keys, 0, sizeof(keys));
+      for (int k = 0; k < command.keyCount; k++) { keys[command.scancodes[k]] = 1; }
+    } else if (command.type == GOLDEN_PRESS) {
+      for (int k = 0; k < command.keyCount; k++) { pressed.push_back(command.keycodes[k]); }
+    }
+  }
+}
+
+//stands in for SDL_PollEvent, hands out this frame's scripted key presses
+bool GoldenTest::PollEvent(SDL_Event *event) {
+  //keep the real queue drained so the window stays responsive
+  SDL_Event ignored;
+  while (SDL_PollEvent(&ignored)) {}
+
+  if (pressed.empty()) { return false; }
+
+  memset(event, 0, sizeof(SDL_Event));
+  event->type = SDL_KEYDOWN;
+  event->key.keysym.sym = pressed.back();
+  pressed.pop_back();
+  return true;
+}
+
+//call after rendering, returns false once the script is done
+bool GoldenTest::EndFrame() {
+  bool done = false;
+  for (; nextCommand < commands.size() && commands[nextCommand].frame <= frame; nextCommand++) {
+    if (commands[nextCommand].frame != frame) { continue; }
+    if (commands[nextCommand].type == GOLDEN_CAPTURE) { CheckFrame(); }
+    if (commands[nextCommand].type == GOLDEN_END) { done = true; }
+  }
+  frame++;
+  return done == false && nextCommand < commands.size();
+}
+
+std::string GoldenTest::ReferencePath(int captureFrame) {
+  char name[64];
+  snprintf(name, sizeof(name), "/frame_%05d.pam", captureFrame);
+  return referenceDir + name;
+}
+
+//every capture's reference is looked for before the run, a missing one fails the whole run up
+//front rather than being found frame by frame, or not at all if the run ends early
+bool GoldenTest::FindReferences() {
+  captures = 0;
+  int missing = 0;
+  for (size_t c = 0; c < commands.size(); c++) {
+    if (commands[c].type != GOLDEN_CAPTURE) { continue; }
+    captures++;
+    std::string referencePath = ReferencePath(commands[c].frame);
+    FILE *file = fopen(referencePath.c_str(), "rb");
+    if (file == NULL) {
+      std::cout << "golden: missing reference " << referencePath << "\n";
+      missing++;
+    } else {
+      fclose(file);
+    }
+  }
+
+  if (captures == 0) {
+    std::cout << "golden: the script has no captures, there is nothing to check\n";
+    return false;
+  }
+  if (missing > 0) {
+    std::cout << "golden: " << missing << " of " << captures << " reference frames missing from " << referenceDir
+              << ", capture them with --update-golden and commit them\n";
+    return false;
+  }
+  return true;
+}
+
+void GoldenTest::CheckFrame() {
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+  //gl rows are bottom up, the images on disk are top down
+  int stride = width * 4;
+  for (int y = 0; y < height; y++) {
+    memcpy(flipped + y * stride, pixels + (height - 1 - y) * stride, stride);
+  }
+
+  std::string referencePath = ReferencePath(frame);
+  framesChecked++;
+
+  if (updateReferences) {
+    if (SavePAM(referencePath.c_str(), flipped, width, height) == false) {
+      std::cout << "golden: unable to write " << referencePath << "\n";
+      framesFailed++;
+    }
+    return;
+  }
+
+  unsigned char *reference = NULL;
+  int refWidth, refHeight;
+  if (LoadPAM(referencePath.c_str(), &reference, &refWidth, &refHeight) == false) {
+    std::cout << "golden: missing reference " << referencePath << "\n";
+    framesFailed++;
+    return;
+  }
+  if (refWidth != width || refHeight != height) {
+    std::cout << "golden: " << referencePath << " is " << refWidth << "x" << refHeight << "\n";
+    framesFailed++;
+    delete[] reference;
+    return;
+  }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  DiffResult result = DiffImages(flipped, reference, width * height, tolerance, heatmap);
+  diffMs += (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+  delete[] reference;
+
+  if (result.mismatched > 0) {
+    framesFailed++;
+    std::string heatmapPath = referencePath.substr(0, referencePath.size() - 4) + "_diff.pam";
+    SavePAM(heatmapPath.c_str(), heatmap, width, height);
+    std::cout << "golden: frame " << frame << " has " << result.mismatched << " mismatched pixels, max delta "
+              << result.maxDelta[0] << " " << result.maxDelta[1] << " " << result.maxDelta[2] << " "
+              << result.maxDelta[3] << ", heatmap in " << heatmapPath << "\n";
+  }
+}
+
+//prints the summary and returns the number of failed frames
+int GoldenTest::Finish() {
+  //never got going, count the whole run as a failure
+  if (isRunning == false) { return 1; }
+  isRunning = false;
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteRenderbuffers(1, &colorBuffer);
+  glDeleteFramebuffers(1, &framebuffer);
+  delete[] pixels;
+  delete[] flipped;
+  delete[] heatmap;
+
+  //a run that stopped before its last capture didn't check everything it was meant to
+  if (updateReferences == false && framesChecked < captures) {
+    std::cout << "golden: the run ended after " << framesChecked << " of " << captures << " captures\n";
+    framesFailed += captures - framesChecked;
+  }
+
+  if (updateReferences) {
+    std::cout << "golden: wrote " << framesChecked - framesFailed << " reference frames to " << referenceDir << "\n";
+  } else {
+    std::cout << "golden: " << framesChecked - framesFailed << "/" << framesChecked << " frames match";
+    if (framesChecked > 0) { std::cout << ", diff avg " << diffMs / framesChecked << " ms per frame"; }
+    std::cout << "\n";
+  }
+  return framesFailed;
+}
@@ -0,0 +1,128 @@
+#include "ImageDiff.h"
+
+#include <cstdio>
+#include <cstring>
+
+static void DiffScalar(const unsigned char *a, const unsigned char *b, int start, int end,
+                       const unsigned char tolerance[4], unsigned char *heatmap, DiffResult *result) {
+  for (int i = start; i < end; i++) {
+    int worst = 0;
+    bool mismatch = false;
+    for (int c = 0; c < 4; c++) {
+      int delta = a[i * 4 + c] - b[i * 4 + c];
+      if (delta < 0) { delta = -delta; }
+      if (delta > tolerance[c]) { mismatch = true; }
+      if (delta > result->maxDelta[c]) { result->maxDelta[c] = delta; }
+      if (delta > worst) { worst = delta; }
+    }
+    if (mismatch) { result->mismatched++; }
+    if (heatmap != NULL) {
+      int red = mismatch ? worst + 64 : 0;
+      heatmap[i * 4] = (unsigned char)(red > 255 ? 255 : red);
+      heatmap[i * 4 + 1] = 0;
+      heatmap[i * 4 + 2] = 0;
+      heatmap[i * 4 + 3] = 255;
+    }
+  }
+}
+
+DiffResult DiffImages(const unsigned char *a, const unsigned char *b, int pixelCount,
+                      const unsigned char tolerance[4], unsigned char *heatmap) {
+  DiffResult result;
+  int i = 0;
+
+#ifdef IMAGE_DIFF_SSE2
+  //4 pixels per iteration
+  __m128i tol = _mm_set1_epi32(tolerance[0] | (tolerance[1] << 8) | (tolerance[2] << 16) | (tolerance[3] << 24));
+  __m128i zero = _mm_setzero_si128();
+  __m128i redMask = _mm_set1_epi32(0xFF);
+  __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+  __m128i boost = _mm_set1_epi32(64);
+  __m128i maxDelta = zero;
+
+  for (; i + 4 <= pixelCount; i += 4) {
+    __m128i va = _mm_loadu_si128((const __m128i *)(a + i * 4));
+    __m128i vb = _mm_loadu_si128((const __m128i *)(b + i * 4));
+
+    //|a - b| per channel using saturating subtracts both ways
+    __m128i delta = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+    maxDelta = _mm_max_epu8(maxDelta, delta);
+
+    //a channel is over tolerance when delta - tol doesn't saturate to zero, a pixel when any channel is
+    __m128i over = _mm_subs_epu8(delta, tol);
+    __m128i ok = _mm_cmpeq_epi32(over, zero);
+    int okBits = _mm_movemask_ps(_mm_castsi128_ps(ok));
+    result.mismatched += 4 - ((okBits & 1) + ((okBits >> 1) & 1) + ((okBits >> 2) & 1) + ((okBits >> 3) & 1));
+
+    if (heatmap != NULL) {
+      //largest channel delta of each pixel ends up in its low byte
+      __m128i worst = _mm_max_epu8(delta, _mm_srli_epi32(delta, 8));
+      worst = _mm_max_epu8(worst, _mm_srli_epi32(worst, 16));
+      worst = _mm_and_si128(worst, redMask);
+      __m128i red = _mm_adds_epu8(worst, boost);
+      red = _mm_andnot_si128(ok, red);
+      _mm_storeu_si128((__m128i *)(heatmap + i * 4), _mm_or_si128(red, alpha));
+    }
+  }
+
+  unsigned char lanes[16];
+  _mm_storeu_si128((__m128i *)lanes, maxDelta);
+  for (int l = 0; l < 16; l++) {
+    if (lanes[l] > result.maxDelta[l % 4]) { result.maxDelta[l % 4] = lanes[l]; }
+  }
+#endif
+
+  //leftovers, or everything without sse2
+  DiffScalar(a, b, i, pixelCount, tolerance, heatmap, &result);
+  return result;
+}
+
+bool LoadPAM(const char *filePath, unsigned char **pixels, int *width, int *height) {
+  FILE *file = fopen(filePath, "rb");
+  if (file == NULL) { return false; }
+
+  char token[32];
+  int depth = 0;
+  int maxval = 0;
+  *width = 0;
+  *height = 0;
+  if (fscanf(file, "%31s", token) != 1 || strcmp(token, "P7") != 0) { fclose(file); return false; }
+  //a header that stops early or has a value missing is rejected, not read with whatever was left over
+  bool valid = true;
+  bool ended = false;
+  while (valid && ended == false && fscanf(file, "%31s", token) == 1) {
+    if (strcmp(token, "ENDHDR") == 0) { ended = true; }
+    else if (strcmp(token, "WIDTH") == 0) { valid = fscanf(file, "%d", width) == 1; }
+    else if (strcmp(token, "HEIGHT") == 0) { valid = fscanf(file, "%d", height) == 1; }
+    else if (strcmp(token, "DEPTH") == 0) { valid = fscanf(file, "%d", &depth) == 1; }
+    else if (strcmp(token, "MAXVAL") == 0) { valid = fscanf(file, "%d", &maxval) == 1; }
+    else if (strcmp(token, "TUPLTYPE") == 0) { valid = fscanf(file, "%31s", token) == 1; }
+  }
+  //a single newline separates ENDHDR from the pixels
+  if (valid && ended) { valid = fgetc(file) == '\n'; }
+
+  if (valid == false || ended == false || depth != 4 || maxval != 255 || *width <= 0 || *height <= 0) {
+    fclose(file);
+    return false;
+  }
+
+  int size = *width * *height * 4;
+  *pixels = new unsigned char[size];
+  bool ok = fread(*pixels, 1, size, file) == (size_t)size;
+  fclose(file);
+  if (ok == false) {
+    delete[] *pixels;
+    *pixels = NULL;
+  }
+  return ok;
+}
+
+bool SavePAM(const char *filePath, const unsigned char *pixels, int width, int height) {
+  FILE *file = fopen(filePath, "wb");
+  if (file == NULL) { return false; }
+
+  fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width, height);
+  bool ok = fwrite(pixels, 1, width * height * 4, file) == (size_t)(width * height * 4);
+  fclose(file);
+  return ok;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_DIFF_SSE2 1
+#include <emmintrin.h>
+#endif
+
+struct DiffResult {
+    int mismatched = 0;
+    int maxDelta[4] = { 0, 0, 0, 0 };
+};
+
+//compares two rgba8 images, a pixel mismatches when any channel differs by more than its tolerance
+//if heatmap is not NULL it gets an rgba image with mismatched pixels in red, brighter for bigger deltas
+DiffResult DiffImages(const unsigned char *a, const unsigned char *b, int pixelCount,
+                      const unsigned char tolerance[4], unsigned char *heatmap);
+
+bool LoadPAM(const char *filePath, unsigned char **pixels, int *width, int *height);
+bool SavePAM(const char *filePath, const unsigned char *pixels, int width, int height);
@@ -0,0 +1,218 @@
+#include "Level.h"
+#include "Simulation.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const char LEVEL_MAGIC[4] = { 'L', 'L', 'L', 'V' };
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static const LevelPlatform DEFAULT_PLATFORMS[] = {
+  //floor
+  { -4.5f, -3.25f, LOSE_PLATFORM },
+  { -3.5f, -3.25f, WIN_PLATFORM },
+  { -2.5f, -3.25f, LOSE_PLATFORM },
+  { -1.5f, -3.25f, LOSE_PLATFORM },
+  { -0.5f, -3.25f, LOSE_PLATFORM },
+  { 0.5f, -3.25f, LOSE_PLATFORM },
+  { 1.5f, -3.25f, LOSE_PLATFORM },
+  { 2.5f, -3.25f, LOSE_PLATFORM },
+  { 3.5f, -3.25f, LOSE_PLATFORM },
+  { 4.5f, -3.25f, LOSE_PLATFORM },
+  //left wall
+  { -4.5f, -2.25f, LOSE_PLATFORM },
+  { -4.5f, -1.25f, LOSE_PLATFORM },
+  { -4.5f, -0.25f, LOSE_PLATFORM },
+  { -4.5f, 0.25f, LOSE_PLATFORM },
+  { -4.5f, 1.25f, LOSE_PLATFORM },
+  { -4.5f, 2.25f, LOSE_PLATFORM },
+  { -4.5f, 3.25f, LOSE_PLATFORM },
+  //right wall
+  { 4.5f, -2.25f, LOSE_PLATFORM },
+  { 4.5f, -1.25f, LOSE_PLATFORM },
+  { 4.5f, -0.25f, LOSE_PLATFORM },
+  { 4.5f, 0.25f, LOSE_PLATFORM },
+  { 4.5f, 1.25f, LOSE_PLATFORM },
+  { 4.5f, 2.25f, LOSE_PLATFORM },
+  { 4.5f, 3.25f, LOSE_PLATFORM },
+  //obstacles
+  { -2.5f, -0.25f, LOSE_PLATFORM },
+  { -3.5f, -0.25f, LOSE_PLATFORM },
+};
+
+static const LevelHeader DEFAULT_HEADER = {
+  { 'L', 'L', 'L', 'V' }, LEVEL_VERSION,
+  0.0f, 5.0f, -1.0f, 1.5f, 5.0f,
+  sizeof(DEFAULT_PLATFORMS) / sizeof(DEFAULT_PLATFORMS[0]), 0,
+  { "win_tile.png", "lose_tile.png" },
+};
+
+const Level &DefaultLevel() {
+  static Level level;
+  level.header = &DEFAULT_HEADER;
+  level.platforms = DEFAULT_PLATFORMS;
+  return level;
+}
+
+//64 bit fnv-1a
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+uint64_t LevelHash(const Level &level) {
+  LevelHeader header = *level.header;
+  header.platformOffset = 0;
+  uint64_t hash = HashBytes(0xCBF29CE484222325ull, &header, sizeof(header));
+  return HashBytes(hash, level.platforms, header.platformCount * sizeof(LevelPlatform));
+}
+
+bool LevelFile::Open(const char *filePath) {
+  Close();
+  Uint64 start = SDL_GetPerformanceCounter();
+  if (file.Open(filePath) == false) { return false; }
+
+  const LevelHeader *header = (const LevelHeader *)file.data;
+  const char *problem = NULL;
+  if (file.size < sizeof(LevelHeader) || memcmp(header->magic, LEVEL_MAGIC, 4) != 0) {
+    problem = "it isn't a level from this game";
+  } else if (header->version != LEVEL_VERSION) {
+    problem = "it was compiled for a different version, compile it again";
+  } else if (header->platformOffset % 4 != 0 ||
+             (size_t)header->platformOffset + (size_t)header->platformCount * sizeof(LevelPlatform) > file.size) {
+    problem = "its platforms are past the end of the file";
+  }
+  for (int t = 0; t < LEVEL_TEXTURE_COUNT && problem == NULL; t++) {
+    if (memchr(header->textures[t], 0, LEVEL_PATH_LENGTH) == NULL) { problem = "a texture path isn't terminated"; }
+  }
+
+  const LevelPlatform *platforms = (const LevelPlatform *)(file.data + (problem == NULL ? header->platformOffset : 0));
+  for (uint32_t i = 0; i < header->platformCount && problem == NULL; i++) {
+    if (platforms[i].kind != WIN_PLATFORM && platforms[i].kind != LOSE_PLATFORM) {
+      problem = "a platform is neither win nor lose";
+    }
+  }
+
+  if (problem != NULL) {
+    std::cout << "Unable to load level " << filePath << ", " << problem << "\n";
+    Close();
+    return false;
+  }
+
+  level.header = header;
+  level.platforms = platforms;
+  openMs = ElapsedMs(start);
+  return true;
+}
+
+void LevelFile::Close() {
+  file.Close();
+  level = Level();
+}
+
+bool CompileLevel(const char *sourcePath, const char *outPath) {
+  std::ifstream infile(sourcePath);
+  if (infile.fail()) {
+    std::cout << "level: unable to open " << sourcePath << "\n";
+    return false;
+  }
+
+  LevelHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LEVEL_MAGIC, 4);
+  header.version = LEVEL_VERSION;
+  std::vector<LevelPlatform> platforms;
+  const char *textureNames[LEVEL_TEXTURE_COUNT] = { "win", "lose" };
+  bool hasShip = false;
+
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(infile, line)) {
+    lineNumber++;
+    std::istringstream words(line);
+    std::string first;
+    if (!(words >> first) || first[0] == '#') { continue; }
+
+    bool valid = false;
+    if (first == "texture") {
+      std::string name;
+      std::string path;
+      words >> name >> path;
+      for (int t = 0; t < LEVEL_TEXTURE_COUNT; t++) {
+        if (name == textureNames[t] && path.empty() == false && path.size() < LEVEL_PATH_LENGTH) {
+          memset(header.textures[t], 0, LEVEL_PATH_LENGTH);
+          memcpy(header.textures[t], path.c_str(), path.size());
+          valid = true;
+        }
+      }
+    } else if (first == "ship") {
+      valid = (bool)(words >> header.shipX >> header.shipY >> header.shipFall >> header.shipSpeed >> header.shipJumpPower);
+      hasShip = valid;
+    } else if (first == "platform") {
+      std::string kind;
+      LevelPlatform platform;
+      words >> kind;
+      platform.kind = kind == "win" ? WIN_PLATFORM : LOSE_PLATFORM;
+      valid = (kind == "win" || kind == "lose") && (bool)(words >> platform.x >> platform.y);
+      if (valid) { platforms.push_back(platform); }
+    } else if (first == "row") {
+      //a row of tiles going right from x, w for win, l for lose and . for none
+      float x;
+      float y;
+      std::string tiles;
+      valid = (bool)(words >> x >> y >> tiles);
+      for (size_t t = 0; t < tiles.size() && valid; t++) {
+        LevelPlatform platform = { x + t, y, tiles[t] == 'w' ? WIN_PLATFORM : LOSE_PLATFORM };
+        valid = tiles[t] == 'w' || tiles[t] == 'l' || tiles[t] == '.';
+        if (valid && tiles[t] != '.') { platforms.push_back(platform); }
+      }
+    }
+
+    if (valid == false) {
+      std::cout << "level: " << sourcePath << " line " << lineNumber << " doesn't make sense: " << line << "\n";
+      return false;
+    }
+  }
+
+  const char *problem = NULL;
+  if (hasShip == false) { problem = "has no ship"; }
+  for (int t = 0; t < LEVEL_TEXTURE_COUNT && problem == NULL; t++) {
+    if (header.textures[t][0] == 0) { problem = "is missing a texture"; }
+  }
+  if (problem != NULL) {
+    std::cout << "level: " << sourcePath << " " << problem << "\n";
+    return false;
+  }
+
+  header.platformCount = (uint32_t)platforms.size();
+  header.platformOffset = sizeof(header);
+
+  FILE *file = fopen(outPath, "wb");
+  if (file == NULL) {
+    std::cout << "level: unable to open " << outPath << "\n";
+    return false;
+  }
+  fwrite(&header, sizeof(header), 1, file);
+  if (platforms.empty() == false) { fwrite(platforms.data(), sizeof(LevelPlatform), platforms.size(), file); }
+  bool written = ferror(file) == 0;
+  fclose(file);
+  if (written == false) {
+    std::cout << "level: unable to write " << outPath << "\n";
+    return false;
+  }
+  std::cout << "level: " << outPath << ", " << platforms.size() << " platforms, "
+            << sizeof(header) + platforms.size() * sizeof(LevelPlatform) << " bytes\n";
+  return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+
+#define LEVEL_VERSION 1
+//longest texture path a level can name, the terminating zero included
+#define LEVEL_PATH_LENGTH 32
+
+//what each of a level's textures is drawn on
+enum LevelTexture { TEXTURE_WIN_PLATFORM, TEXTURE_LOSE_PLATFORM, LEVEL_TEXTURE_COUNT };
+
+//one tile of the level, kind is WIN_PLATFORM or LOSE_PLATFORM
+struct LevelPlatform {
+    float x;
+    float y;
+    uint32_t kind;
+};
+
+//a level file is this header and platformCount LevelPlatforms at platformOffset, laid out the
+//way the game uses them so it is mapped and read in place without parsing
+//all fields are little endian and 4 byte aligned, like the replay files
+struct LevelHeader {
+    char magic[4];
+    uint32_t version;
+    //where the ship starts, how fast it is already falling and how it handles
+    float shipX;
+    float shipY;
+    float shipFall;
+    float shipSpeed;
+    float shipJumpPower;
+    uint32_t platformCount;
+    uint32_t platformOffset;
+    char textures[LEVEL_TEXTURE_COUNT][LEVEL_PATH_LENGTH];
+};
+
+//a level as SetupState reads it, pointers into a mapped file or the built in tables
+struct Level {
+    const LevelHeader *header = NULL;
+    const LevelPlatform *platforms = NULL;
+};
+
+//the level the game has always had, used when no level file is given
+const Level &DefaultLevel();
+
+//identifies a level by what is in it, where it sits in its file doesn't count, so the built in
+//level and a file compiled to the same content give the same hash
+uint64_t LevelHash(const Level &level);
+
+//a level file mapped read only, the Level points straight into the mapping, so it is only good
+//while the file is open
+class LevelFile {
+public:
+    Level level;
+    double openMs = 0.0;
+
+    //false if it can't be mapped or isn't a level this build can play, with the reason printed
+    bool Open(const char *filePath);
+    void Close();
+
+private:
+    MappedFile file;
+};
+
+//reads a level written as text and writes it out in the mapped format, see levels/level1.txt
+//errors are printed with their line number and nothing is written
+bool CompileLevel(const char *sourcePath, const char *outPath);
@@ -0,0 +1,89 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WINDOWS
+
+bool MappedFile::Open(const char *filePath) {
+  Close();
+  file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    file = NULL;
+    std::cout << "Unable to open " << filePath << "\n";
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (GetFileSizeEx(file, &fileSize) == FALSE || fileSize.QuadPart == 0) {
+    std::cout << "Unable to map " << filePath << ", it is empty or unreadable\n";
+    Close();
+    return false;
+  }
+  size = (size_t)fileSize.QuadPart;
+
+  mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping != NULL) { data = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0); }
+  if (data == NULL) {
+    std::cout << "Unable to map " << filePath << "\n";
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != NULL) { UnmapViewOfFile(data); }
+  if (mapping != NULL) { CloseHandle(mapping); }
+  if (file != NULL) { CloseHandle(file); }
+  data = NULL;
+  mapping = NULL;
+  file = NULL;
+  size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const char *filePath) {
+  Close();
+  fd = open(filePath, O_RDONLY);
+  if (fd < 0) {
+    std::cout << "Unable to open " << filePath << "\n";
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    std::cout << "Unable to map " << filePath << ", it is empty or unreadable\n";
+    Close();
+    return false;
+  }
+  size = (size_t)info.st_size;
+
+  void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (mapped == MAP_FAILED) {
+    std::cout << "Unable to map " << filePath << "\n";
+    Close();
+    return false;
+  }
+  data = (const unsigned char *)mapped;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != NULL) { munmap((void *)data, size); }
+  if (fd >= 0) { close(fd); }
+  data = NULL;
+  fd = -1;
+  size = 0;
+}
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+
+//a whole file mapped read only, pages are brought in by the os as they are touched, so opening
+//a big file costs nothing and jumping around in it only reads what is looked at
+class MappedFile {
+public:
+    const unsigned char *data = NULL;
+    size_t size = 0;
+
+    bool Open(const char *filePath);
+    void Close();
+
+private:
+#ifdef _WINDOWS
+    void *file = NULL;
+    void *mapping = NULL;
+#else
+    int fd = -1;
+#endif
+};
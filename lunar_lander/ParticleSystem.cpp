@@ -0,0 +1,301 @@
+#include "ParticleSystem.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WINDOWS
+#include <malloc.h>
+#define AlignedAlloc(size) _aligned_malloc(size, 16)
+#define AlignedFree(pointer) _aligned_free(pointer)
+#else
+#include <cstdlib>
+#define AlignedAlloc(size) aligned_alloc(16, size)
+#define AlignedFree(pointer) free(pointer)
+#endif
+
+static const float QUAD[] = { -0.5f, -0.5f, 0.5f, -0.5f, 0.5f, 0.5f, -0.5f, -0.5f, 0.5f, 0.5f, -0.5f, 0.5f };
+
+void ParticleEmitter::Emit(glm::vec3 position) {
+  if (system != NULL) { system->Emit(*this, position); }
+}
+
+ParticleSystem::~ParticleSystem() {
+  Free();
+}
+
+//zeroed so the lanes past count that the simd loop runs over hold particles that never move or die
+static float *AllocateColumn(int capacity) {
+  float *column = (float *)AlignedAlloc(capacity * sizeof(float));
+  memset(column, 0, capacity * sizeof(float));
+  return column;
+}
+
+void ParticleSystem::Allocate(int capacity) {
+  Free();
+  this->capacity = (capacity + 3) & ~3;
+
+  x = AllocateColumn(this->capacity);
+  y = AllocateColumn(this->capacity);
+  vx = AllocateColumn(this->capacity);
+  vy = AllocateColumn(this->capacity);
+  ay = AllocateColumn(this->capacity);
+  drag = AllocateColumn(this->capacity);
+  age = AllocateColumn(this->capacity);
+  invLife = AllocateColumn(this->capacity);
+  size = AllocateColumn(this->capacity);
+  color = (Uint32 *)AllocateColumn(this->capacity);
+  count = 0;
+  if (maxParticles > this->capacity) { maxParticles = this->capacity; }
+}
+
+void ParticleSystem::Free() {
+  float **columns[] = { &x, &y, &vx, &vy, &ay, &drag, &age, &invLife, &size };
+  for (float **column : columns) {
+    AlignedFree(*column);
+    *column = NULL;
+  }
+  AlignedFree(color);
+  color = NULL;
+  capacity = 0;
+  count = 0;
+}
+
+void ParticleSystem::Load(int capacity) {
+  Allocate(capacity);
+
+  program.Load("shaders/vertex_particle.glsl", "shaders/fragment_particle.glsl");
+  particleXAttribute = glGetAttribLocation(program.programID, "particleX");
+  particleYAttribute = glGetAttribLocation(program.programID, "particleY");
+  particleSizeAttribute = glGetAttribLocation(program.programID, "particleSize");
+  particleAgeAttribute = glGetAttribLocation(program.programID, "particleAge");
+  particleColorAttribute = glGetAttribLocation(program.programID, "particleColor");
+
+  //glDrawArraysInstanced and glVertexAttribDivisor are both core from 3.3
+  int major = 0;
+  int minor = 0;
+  const char *version = (const char *)glGetString(GL_VERSION);
+  instanced = version != NULL && sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 3 || (major == 3 && minor >= 3));
+  if (instanced == false) {
+    std::cout << "particles: no instancing in GL " << (version != NULL ? version : "?") << ", drawing a quad per particle\n";
+  }
+
+  glGenBuffers(1, &quadBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(QUAD), QUAD, GL_STATIC_DRAW);
+
+  //one column after another, same layout as the arrays we keep on the cpu
+  glGenBuffers(1, &instanceBuffer);
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, this->capacity * 5 * 4, NULL, GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//xorshift so bursts come out the same every run
+float ParticleSystem::Random(float min, float max) {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return min + (max - min) * (float)(seed & 0xFFFFFF) / (float)0xFFFFFF;
+}
+
+void ParticleSystem::Emit(const ParticleEmitter &emitter, glm::vec3 position) {
+  int limit = maxParticles < capacity ? maxParticles : capacity;
+  Uint32 packed = emitter.color[0] | (emitter.color[1] << 8) | (emitter.color[2] << 16) | ((Uint32)emitter.color[3] << 24);
+
+  for (int i = 0; i < emitter.count && count < limit; i++) {
+    float angle = Random(0.0f, 6.2831853f);
+    float speed = Random(emitter.speedMin, emitter.speedMax);
+    x[count] = position.x;
+    y[count] = position.y;
+    vx[count] = std::cos(angle) * speed;
+    vy[count] = std::sin(angle) * speed;
+    ay[count] = -emitter.gravity;
+    drag[count] = emitter.drag;
+    age[count] = 0.0f;
+    invLife[count] = 1.0f / Random(emitter.lifeMin, emitter.lifeMax);
+    size[count] = emitter.size;
+    color[count] = packed;
+    count++;
+  }
+}
+
+void ParticleSystem::Update(float deltaTime) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  //everything before the first dead particle is already in place
+  int firstDead = count;
+
+  int i = 0;
+#ifdef PARTICLES_SSE2
+  //integrate and age 4 at a time, the arrays are padded so we can run past count
+  __m128 dt = _mm_set1_ps(deltaTime);
+  __m128 one = _mm_set1_ps(1.0f);
+  for (; i < count; i += 4) {
+    __m128 velX = _mm_load_ps(vx + i);
+    __m128 velY = _mm_load_ps(vy + i);
+    __m128 damping = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_load_ps(drag + i), dt));
+    velX = _mm_mul_ps(velX, damping);
+    velY = _mm_add_ps(_mm_mul_ps(velY, damping), _mm_mul_ps(_mm_load_ps(ay + i), dt));
+    _mm_store_ps(vx + i, velX);
+    _mm_store_ps(vy + i, velY);
+    _mm_store_ps(x + i, _mm_add_ps(_mm_load_ps(x + i), _mm_mul_ps(velX, dt)));
+    _mm_store_ps(y + i, _mm_add_ps(_mm_load_ps(y + i), _mm_mul_ps(velY, dt)));
+    //age is kept as a 0..1 fraction of the particle's life
+    __m128 newAge = _mm_add_ps(_mm_load_ps(age + i), _mm_mul_ps(_mm_load_ps(invLife + i), dt));
+    _mm_store_ps(age + i, newAge);
+
+    int dead = _mm_movemask_ps(_mm_cmpge_ps(newAge, one));
+    if (dead != 0 && firstDead == count) {
+      firstDead = i;
+      while ((dead & 1) == 0) { dead >>= 1; firstDead++; }
+    }
+  }
+#else
+  for (; i < count; i++) {
+    float damping = 1.0f - drag[i] * deltaTime;
+    vx[i] *= damping;
+    vy[i] = vy[i] * damping + ay[i] * deltaTime;
+    x[i] += vx[i] * deltaTime;
+    y[i] += vy[i] * deltaTime;
+    age[i] += invLife[i] * deltaTime;
+    if (age[i] >= 1.0f && firstDead == count) { firstDead = i; }
+  }
+#endif
+
+  //compact the live ones to the front, every particle is copied and only the write index depends on alive
+  int live = firstDead;
+  for (i = firstDead; i < count; i++) {
+    float a = age[i];
+    x[live] = x[i];
+    y[live] = y[i];
+    vx[live] = vx[i];
+    vy[live] = vy[i];
+    ay[live] = ay[i];
+    drag[live] = drag[i];
+    age[live] = a;
+    invLife[live] = invLife[i];
+    size[live] = size[i];
+    color[live] = color[i];
+    live += (int)(a < 1.0f);
+  }
+  count = live;
+
+#ifdef PARTICLES_SSE2
+  //compaction leaves stale copies past count, the padding lanes the simd loop reads next time are
+  //reset so they never age and can't be taken for the first dead particle
+  for (i = count; i < ((count + 3) & ~3); i++) {
+    age[i] = 0.0f;
+    invLife[i] = 0.0f;
+  }
+#endif
+
+  lastUpdateMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void ParticleSystem::Render(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix) {
+  if (count == 0) { return; }
+
+  program.SetProjectionMatrix(projectionMatrix);
+  program.SetViewMatrix(viewMatrix);
+
+  GLint attributes[] = { particleXAttribute, particleYAttribute, particleSizeAttribute, particleAgeAttribute };
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+  if (instanced) { RenderInstanced(attributes); }
+  else { RenderQuads(attributes); }
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  for (int a = 0; a < 4; a++) { glDisableVertexAttribArray(attributes[a]); }
+  glDisableVertexAttribArray(particleColorAttribute);
+  glDisableVertexAttribArray(program.positionAttribute);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void ParticleSystem::RenderInstanced(const GLint *attributes) {
+  //orphan last frame's data and upload each column as is
+  size_t column = capacity * 4;
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, column * 5, NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, count * 4, x);
+  glBufferSubData(GL_ARRAY_BUFFER, column, count * 4, y);
+  glBufferSubData(GL_ARRAY_BUFFER, column * 2, count * 4, size);
+  glBufferSubData(GL_ARRAY_BUFFER, column * 3, count * 4, age);
+  glBufferSubData(GL_ARRAY_BUFFER, column * 4, count * 4, color);
+
+  for (int a = 0; a < 4; a++) {
+    glVertexAttribPointer(attributes[a], 1, GL_FLOAT, false, 0, (void *)(column * a));
+    glVertexAttribDivisor(attributes[a], 1);
+    glEnableVertexAttribArray(attributes[a]);
+  }
+  glVertexAttribPointer(particleColorAttribute, 4, GL_UNSIGNED_BYTE, true, 0, (void *)(column * 4));
+  glVertexAttribDivisor(particleColorAttribute, 1);
+  glEnableVertexAttribArray(particleColorAttribute);
+
+  glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+  glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, 0);
+  glEnableVertexAttribArray(program.positionAttribute);
+
+  glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+
+  //the rest of the game draws from client memory without divisors
+  for (int a = 0; a < 4; a++) { glVertexAttribDivisor(attributes[a], 0); }
+  glVertexAttribDivisor(particleColorAttribute, 0);
+}
+
+//same shader, every corner just carries its particle's values itself
+void ParticleSystem::RenderQuads(const GLint *attributes) {
+  vertices.resize(count * 6);
+  for (int i = 0; i < count; i++) {
+    for (int c = 0; c < 6; c++) {
+      ParticleVertex &vertex = vertices[i * 6 + c];
+      vertex.position[0] = QUAD[c * 2];
+      vertex.position[1] = QUAD[c * 2 + 1];
+      vertex.x = x[i];
+      vertex.y = y[i];
+      vertex.size = size[i];
+      vertex.age = age[i];
+      vertex.color = color[i];
+    }
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+  glBufferData(GL_ARRAY_BUFFER, count * 6 * sizeof(ParticleVertex), vertices.data(), GL_STREAM_DRAW);
+
+  size_t offsets[] = { offsetof(ParticleVertex, x), offsetof(ParticleVertex, y), offsetof(ParticleVertex, size), offsetof(ParticleVertex, age) };
+  for (int a = 0; a < 4; a++) {
+    glVertexAttribPointer(attributes[a], 1, GL_FLOAT, false, sizeof(ParticleVertex), (void *)offsets[a]);
+    glEnableVertexAttribArray(attributes[a]);
+  }
+  glVertexAttribPointer(particleColorAttribute, 4, GL_UNSIGNED_BYTE, true, sizeof(ParticleVertex), (void *)offsetof(ParticleVertex, color));
+  glEnableVertexAttribArray(particleColorAttribute);
+  glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, sizeof(ParticleVertex), (void *)offsetof(ParticleVertex, position));
+  glEnableVertexAttribArray(program.positionAttribute);
+
+  glDrawArrays(GL_TRIANGLES, 0, count * 6);
+}
+
+void BenchmarkParticles(int count, int steps) {
+  ParticleSystem particles;
+  particles.Allocate(count);
+
+  //long lived so the whole set stays alive for the run
+  ParticleEmitter emitter;
+  emitter.count = count;
+  emitter.lifeMin = 1000.0f;
+  emitter.lifeMax = 1000.0f;
+  emitter.gravity = 9.8f;
+  emitter.drag = 0.5f;
+  particles.Emit(emitter, glm::vec3(0.0f));
+
+  double total = 0.0;
+  double worst = 0.0;
+  for (int i = 0; i < steps; i++) {
+    particles.Update(0.0166666f);
+    total += particles.lastUpdateMs;
+    if (particles.lastUpdateMs > worst) { worst = particles.lastUpdateMs; }
+  }
+  std::cout << "particles: " << particles.count << " live, update avg " << total / steps
+            << " ms, max " << worst << " ms over " << steps << " steps\n";
+}
@@ -0,0 +1,104 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLES_SSE2 1
+#include <emmintrin.h>
+#endif
+
+//capacity is rounded up to a multiple of 4 so the simd loop never needs a tail
+#define PARTICLE_MAX 131072
+
+class ParticleSystem;
+
+//what a burst looks like, entities keep pointers to these for their events
+struct ParticleEmitter {
+    ParticleSystem *system = NULL;
+    int count = 32;
+    float speedMin = 1.0f;
+    float speedMax = 4.0f;
+    float lifeMin = 0.3f;
+    float lifeMax = 0.8f;
+    float size = 0.25f;
+    float gravity = 0.0f;
+    float drag = 0.0f;
+    unsigned char color[4] = { 255, 255, 255, 255 };
+
+    void Emit(glm::vec3 position);
+};
+
+//one corner of a particle's quad, for contexts that can't draw instanced
+struct ParticleVertex {
+    float position[2];
+    float x;
+    float y;
+    float size;
+    float age;
+    Uint32 color;
+};
+
+//particles live in structure of arrays columns, updated 4 at a time and drawn with one instanced call
+class ParticleSystem {
+public:
+    int count = 0;
+    int capacity = 0;
+    //emits past this are dropped, lets the frame budget trade particles for time
+    int maxParticles = PARTICLE_MAX;
+
+    double lastUpdateMs = 0.0;
+
+    float *x = NULL;
+    float *y = NULL;
+    float *vx = NULL;
+    float *vy = NULL;
+    float *ay = NULL;
+    float *drag = NULL;
+    //fraction of the particle's life used up, it dies at 1
+    float *age = NULL;
+    float *invLife = NULL;
+    float *size = NULL;
+    Uint32 *color = NULL;
+
+    ~ParticleSystem();
+    void Allocate(int capacity);
+    void Free();
+    void Load(int capacity);
+    void Emit(const ParticleEmitter &emitter, glm::vec3 position);
+    void Update(float deltaTime);
+    void Render(const glm::mat4 &viewMatrix, const glm::mat4 &projectionMatrix);
+
+private:
+    Uint32 seed = 0x9E3779B9;
+
+    ShaderProgram program;
+    GLuint quadBuffer;
+    GLuint instanceBuffer;
+    GLint particleXAttribute;
+    GLint particleYAttribute;
+    GLint particleSizeAttribute;
+    GLint particleAgeAttribute;
+    GLint particleColorAttribute;
+
+    //instancing is core from gl 3.3, older contexts get a quad per particle built on the cpu
+    bool instanced = false;
+    std::vector<ParticleVertex> vertices;
+
+    float Random(float min, float max);
+    void RenderInstanced(const GLint *attributes);
+    void RenderQuads(const GLint *attributes);
+};
+
+//runs steps updates over count live particles and prints the average update time
+void BenchmarkParticles(int count, int steps);
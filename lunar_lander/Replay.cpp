@@ -0,0 +1,271 @@
+#include "Replay.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define REPLAY_VERSION 2
+
+static const char REPLAY_MAGIC[4] = { 'L', 'L', 'R', 'P' };
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+//movement is -1, 0 or 1 from the keys, those take 2 bits, anything else 2 bits and the float
+//compared by bits so the value played back is exactly the one recorded, -0 included
+static uint32_t FloatBits(float value) {
+  uint32_t raw;
+  memcpy(&raw, &value, sizeof(raw));
+  return raw;
+}
+
+static void WriteAxis(BitWriter &bits, float value) {
+  uint32_t raw = FloatBits(value);
+  if (raw == FloatBits(0.0f)) { bits.Write(0, 2); }
+  else if (raw == FloatBits(1.0f)) { bits.Write(1, 2); }
+  else if (raw == FloatBits(-1.0f)) { bits.Write(2, 2); }
+  else {
+    bits.Write(3, 2);
+    bits.Write(raw, 32);
+  }
+}
+
+static float ReadAxis(BitReader &bits) {
+  switch (bits.Read(2)) {
+    case 0: return 0.0f;
+    case 1: return 1.0f;
+    case 2: return -1.0f;
+  }
+  uint32_t raw = bits.Read(32);
+  float value;
+  memcpy(&value, &raw, sizeof(value));
+  return value;
+}
+
+//a step is a 0 bit when its input is the same as the last step's, otherwise a 1 bit, a changed
+//bit and value for the movement, and the jump flag
+static void WriteInput(BitWriter &bits, const InputFrame &last, const InputFrame &input) {
+  bool sameX = FloatBits(input.moveX) == FloatBits(last.moveX);
+  if (sameX && input.jump == last.jump) {
+    bits.Write(0, 1);
+    return;
+  }
+  bits.Write(1, 1);
+  bits.Write(sameX ? 0 : 1, 1);
+  if (sameX == false) { WriteAxis(bits, input.moveX); }
+  bits.Write(input.jump ? 1 : 0, 1);
+}
+
+static void ReadInput(BitReader &bits, InputFrame *last) {
+  if (bits.Read(1) == 0) { return; }
+  if (bits.Read(1) == 1) { last->moveX = ReadAxis(bits); }
+  last->jump = bits.Read(1) == 1;
+}
+
+void ReplayRecorder::Start(const char *filePath, uint64_t levelHash) {
+  path = filePath;
+  this->levelHash = levelHash;
+  bits = BitWriter();
+  last = InputFrame();
+  states.clear();
+  index.clear();
+  stepCount = 0;
+  isRecording = true;
+}
+
+void ReplayRecorder::Record(GameState &state, const InputFrame &input) {
+  if (isRecording == false) { return; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  if (stepCount % REPLAY_KEYFRAME_INTERVAL == 0) {
+    SaveState(state, &scratch);
+    ReplayKeyframe keyframe;
+    keyframe.step = stepCount;
+    keyframe.bitPosition = bits.bitCount;
+    //from the start of the states for now, Finish makes it from the start of the file
+    keyframe.stateOffset = (uint32_t)states.size();
+    keyframe.stateSize = (uint32_t)scratch.size();
+    index.push_back(keyframe);
+    states.insert(states.end(), scratch.begin(), scratch.end());
+    //input after a keyframe is coded against nothing, so playback can start there
+    last = InputFrame();
+  }
+  WriteInput(bits, last, input);
+  last = input;
+  stepCount++;
+
+  double ms = ElapsedMs(start);
+  totalRecordMs += ms;
+  if (ms > maxRecordMs) { maxRecordMs = ms; }
+}
+
+bool ReplayRecorder::Finish() {
+  if (isRecording == false) { return false; }
+  isRecording = false;
+
+  FILE *file = fopen(path.c_str(), "wb");
+  if (file == NULL) {
+    std::cout << "Unable to open replay file " << path << "\n";
+    return false;
+  }
+
+  ReplayHeader header;
+  memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+  header.version = REPLAY_VERSION;
+  header.timestep = FIXED_TIMESTEP;
+  header.keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+  header.levelHash = levelHash;
+
+  ReplayFooter footer;
+  footer.stepCount = stepCount;
+  footer.bitsOffset = sizeof(header);
+  footer.bitCount = bits.bitCount;
+  uint32_t statesOffset = footer.bitsOffset + (uint32_t)bits.bytes.size();
+  footer.indexOffset = statesOffset + (uint32_t)states.size();
+  footer.keyframeCount = (uint32_t)index.size();
+  memcpy(footer.magic, REPLAY_MAGIC, sizeof(footer.magic));
+  for (size_t i = 0; i < index.size(); i++) { index[i].stateOffset += statesOffset; }
+
+  fwrite(&header, sizeof(header), 1, file);
+  if (bits.bytes.empty() == false) { fwrite(bits.bytes.data(), 1, bits.bytes.size(), file); }
+  if (states.empty() == false) { fwrite(states.data(), 1, states.size(), file); }
+  if (index.empty() == false) { fwrite(index.data(), sizeof(ReplayKeyframe), index.size(), file); }
+  fwrite(&footer, sizeof(footer), 1, file);
+  bool written = ferror(file) == 0;
+  fclose(file);
+
+  fileSize = footer.indexOffset + index.size() * sizeof(ReplayKeyframe) + sizeof(footer);
+  if (written == false) { std::cout << "Unable to write replay file " << path << "\n"; }
+  return written;
+}
+
+void ReplayRecorder::Report() {
+  if (stepCount == 0) { return; }
+
+  std::cout << "replay: recorded " << stepCount << " steps (" << stepCount * FIXED_TIMESTEP << " s) to " << path
+            << ", " << fileSize << " bytes, " << (bits.bytes.size() * 8.0) / stepCount << " bits of input per step, "
+            << index.size() << " keyframes of " << (index.empty() ? 0 : index[0].stateSize) << " bytes\n";
+  std::cout << "replay: recording avg " << totalRecordMs * 1000.0 / stepCount << " us per step, max "
+            << maxRecordMs << " ms\n";
+}
+
+bool ReplayPlayer::Open(const char *filePath, uint64_t levelHash) {
+  Close();
+  if (file.Open(filePath) == false) { return false; }
+
+  ReplayFooter footer;
+  bool valid = file.size >= sizeof(header) + sizeof(footer);
+  if (valid) {
+    memcpy(&header, file.data, sizeof(header));
+    memcpy(&footer, file.data + file.size - sizeof(footer), sizeof(footer));
+    valid = memcmp(header.magic, REPLAY_MAGIC, 4) == 0 && memcmp(footer.magic, REPLAY_MAGIC, 4) == 0 &&
+            header.version == REPLAY_VERSION && header.keyframeInterval > 0 &&
+            footer.bitsOffset + (footer.bitCount + 7) / 8 <= file.size &&
+            footer.indexOffset + (size_t)footer.keyframeCount * sizeof(ReplayKeyframe) <= file.size - sizeof(footer);
+  }
+  if (valid == false) {
+    std::cout << "Unable to play " << filePath << ", it isn't a replay from this game\n";
+    Close();
+    return false;
+  }
+  if (header.timestep != FIXED_TIMESTEP) {
+    std::cout << "Unable to play " << filePath << ", it was recorded with a different time step\n";
+    Close();
+    return false;
+  }
+  if (header.levelHash != levelHash) {
+    std::cout << "Unable to play " << filePath << ", it was recorded on a different level\n";
+    Close();
+    return false;
+  }
+
+  index.resize(footer.keyframeCount);
+  if (footer.keyframeCount > 0) {
+    memcpy(index.data(), file.data + footer.indexOffset, footer.keyframeCount * sizeof(ReplayKeyframe));
+  }
+  for (size_t i = 0; i < index.size(); i++) {
+    if ((size_t)index[i].stateOffset + index[i].stateSize > file.size) {
+      std::cout << "Unable to play " << filePath << ", keyframe " << i << " is past the end of the file\n";
+      Close();
+      return false;
+    }
+  }
+
+  bits.Setup(file.data + footer.bitsOffset, footer.bitCount);
+  last = InputFrame();
+  stepCount = footer.stepCount;
+  step = 0;
+  isPlaying = true;
+  return true;
+}
+
+void ReplayPlayer::Close() {
+  file.Close();
+  index.clear();
+  isPlaying = false;
+}
+
+bool ReplayPlayer::Read(GameState &state, InputFrame *input) {
+  if (isPlaying == false || step >= stepCount) { return false; }
+
+  //keyframes are every keyframeInterval steps, so the one for this step is found without a search
+  size_t k = step / header.keyframeInterval;
+  if (step % header.keyframeInterval == 0 && k < index.size()) {
+    SaveState(state, &scratch);
+    const ReplayKeyframe &keyframe = index[k];
+    bool matches = scratch.size() == keyframe.stateSize &&
+                   memcmp(scratch.data(), file.data + keyframe.stateOffset, keyframe.stateSize) == 0;
+    if (matches == false) {
+      if (desyncs == 0) { std::cout << "replay: state doesn't match the recording at step " << step << "\n"; }
+      desyncs++;
+    }
+    keyframesChecked++;
+    bits.position = keyframe.bitPosition;
+    last = InputFrame();
+  }
+
+  ReadInput(bits, &last);
+  if (bits.overrun) { return false; }
+  *input = last;
+  step++;
+  return true;
+}
+
+bool ReplayPlayer::Seek(GameState &state, int target) {
+  if (isPlaying == false || index.empty()) { return false; }
+  if (target > stepCount) { target = stepCount; }
+  if (target < 0) { target = 0; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  size_t k = target / header.keyframeInterval;
+  if (k >= index.size()) { k = index.size() - 1; }
+  const ReplayKeyframe &keyframe = index[k];
+  if (LoadState(state, file.data + keyframe.stateOffset, keyframe.stateSize) == false) {
+    std::cout << "replay: keyframe at step " << keyframe.step << " is from a different build\n";
+    return false;
+  }
+  step = keyframe.step;
+  bits.position = keyframe.bitPosition;
+  last = InputFrame();
+
+  InputFrame input;
+  while (step < target && Read(state, &input)) {
+    Step(state, input, FIXED_TIMESTEP);
+  }
+
+  lastSeekMs = ElapsedMs(start);
+  lastSeekSteps = step - keyframe.step;
+  seekCount++;
+  return true;
+}
+
+void ReplayPlayer::Report() {
+  if (stepCount == 0) { return; }
+
+  std::cout << "replay: played " << step << " of " << stepCount << " steps, " << keyframesChecked
+            << " keyframes checked, " << desyncs << " didn't match\n";
+  if (seekCount > 0) {
+    std::cout << "replay: last seek took " << lastSeekMs << " ms, " << lastSeekSteps << " steps re-simulated\n";
+  }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Simulation.h"
+#include "Bitstream.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//steps between copies of the whole state, a seek re-simulates at most this many, ten seconds of play
+//the state is only the ship, so they can be close together
+#define REPLAY_KEYFRAME_INTERVAL 600
+
+//a replay file is the header, the input bitstream, the keyframe states back to back, their index
+//and the footer, the footer is read from the end of the file and says where everything else is
+//all fields are little endian, which is every machine we build for
+struct ReplayHeader {
+    char magic[4];
+    uint32_t version;
+    float timestep;
+    uint32_t keyframeInterval;
+    //LevelHash of the level it was recorded on, the input only means anything on that level
+    uint64_t levelHash;
+};
+
+struct ReplayKeyframe {
+    //steps that had run when the state was taken
+    uint32_t step;
+    //where the input of that step starts in the bitstream
+    uint32_t bitPosition;
+    uint32_t stateOffset;
+    uint32_t stateSize;
+};
+
+struct ReplayFooter {
+    uint32_t stepCount;
+    uint32_t bitsOffset;
+    uint32_t bitCount;
+    uint32_t indexOffset;
+    uint32_t keyframeCount;
+    char magic[4];
+};
+
+//logs the input of every fixed step so a session can be played back exactly
+//a step with the same input as the one before costs one bit, a change costs a few more, so an
+//hour of play is tens of kilobytes
+//everything is kept in memory until Finish, recording a step is a handful of bit writes
+class ReplayRecorder {
+public:
+    bool isRecording = false;
+    int stepCount = 0;
+    double totalRecordMs = 0.0;
+    double maxRecordMs = 0.0;
+    size_t fileSize = 0;
+
+    void Start(const char *filePath, uint64_t levelHash);
+    //call with the state and the input right before they go to Step
+    void Record(GameState &state, const InputFrame &input);
+    //writes the file, false if it couldn't be
+    bool Finish();
+    void Report();
+
+private:
+    std::string path;
+    uint64_t levelHash = 0;
+    BitWriter bits;
+    InputFrame last;
+    std::vector<Uint8> states;
+    std::vector<ReplayKeyframe> index;
+    std::vector<Uint8> scratch;
+};
+
+//plays a recording back from a mapped file, input comes off the bitstream as the steps need it
+//and a seek restores the keyframe at or before the step it wants and re-simulates from there
+class ReplayPlayer {
+public:
+    bool isPlaying = false;
+    int stepCount = 0;
+    //steps played so far, the next Read is the input for this one
+    int step = 0;
+
+    //keyframes played through, and how many of them didn't match what we had simulated
+    int keyframesChecked = 0;
+    int desyncs = 0;
+
+    int seekCount = 0;
+    double lastSeekMs = 0.0;
+    int lastSeekSteps = 0;
+
+    //false if the file isn't a replay of the level with this LevelHash, with the reason printed
+    bool Open(const char *filePath, uint64_t levelHash);
+    void Close();
+    //the input for the next step, false at the end of the recording
+    //state is the state that input is about to go to, it is checked against any keyframe taken here
+    bool Read(GameState &state, InputFrame *input);
+    //puts state at target steps in, target past the end goes to the end
+    bool Seek(GameState &state, int target);
+    void Report();
+
+private:
+    MappedFile file;
+    ReplayHeader header;
+    std::vector<ReplayKeyframe> index;
+    BitReader bits;
+    InputFrame last;
+    std::vector<Uint8> scratch;
+};
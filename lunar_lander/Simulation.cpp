@@ -0,0 +1,109 @@
+#include "Simulation.h"
+
+#include <cstring>
+
+void SetupState(GameState &state, const Level &level) {
+  const LevelHeader &header = *level.header;
+  state.mode = PLAYING;
+
+  //player
+  state.player = new Entity();
+  state.player->position = glm::vec3(header.shipX, header.shipY, 0.0f);
+  state.player->movement = glm::vec3(0);
+  state.player->acceleration = glm::vec3(0.0f, 0.0f, 0.0f);
+  state.player->speed = header.shipSpeed;
+  state.player->entityType = PLAYER;
+  state.player->velocity.y = header.shipFall;
+
+  state.player->height = 1.0f;
+  state.player->width = 1.0f;
+
+  state.player->jumpPower = header.shipJumpPower;
+
+  //platforms
+  state.platformCount = (int)header.platformCount;
+  state.platforms = new Entity[state.platformCount];
+  for (int i = 0; i < state.platformCount; i++) {
+    state.platforms[i].position = glm::vec3(level.platforms[i].x, level.platforms[i].y, 0.0f);
+    state.platforms[i].entityType = (EntityType)level.platforms[i].kind;
+    state.platforms[i].Update(0, NULL);
+  }
+  state.tiles.Build(state.platforms, state.platformCount);
+}
+
+void Step(GameState &state, const InputFrame &input, float deltaTime) {
+  Entity *player = state.player;
+  player->movement = glm::vec3(input.moveX, 0.0f, 0.0f);
+  if (input.jump && player->collidedBottom) { player->jump = true; }
+
+  //if bottom collision update and check if collided with win or lose platform
+  if (player->collidedBottom) {
+    player->Update(deltaTime, &state.tiles);
+    if (player->lastCollision == WIN_PLATFORM) {
+      state.mode = WIN;
+    } else {
+      state.mode = LOSE;
+    }
+  } else {
+    player->Update(deltaTime, &state.tiles);
+  }
+}
+
+//every field of the ship a step can change, in the order they are saved, one at a time so the
+//padding in Entity never ends up in the bytes
+template <typename Visit>
+static void ForEachField(Entity *player, Visit visit) {
+  visit(&player->isActive, sizeof(player->isActive));
+  visit(&player->collidedTop, sizeof(player->collidedTop));
+  visit(&player->collidedBottom, sizeof(player->collidedBottom));
+  visit(&player->collidedRight, sizeof(player->collidedRight));
+  visit(&player->collidedLeft, sizeof(player->collidedLeft));
+  visit(&player->lastCollision, sizeof(player->lastCollision));
+  visit(&player->position, sizeof(player->position));
+  visit(&player->movement, sizeof(player->movement));
+  visit(&player->acceleration, sizeof(player->acceleration));
+  visit(&player->velocity, sizeof(player->velocity));
+  visit(&player->speed, sizeof(player->speed));
+  visit(&player->width, sizeof(player->width));
+  visit(&player->height, sizeof(player->height));
+  visit(&player->jump, sizeof(player->jump));
+  visit(&player->jumpPower, sizeof(player->jumpPower));
+}
+
+size_t StateSize(GameState &state) {
+  size_t size = sizeof(int);
+  ForEachField(state.player, [&](void *field, size_t fieldSize) { size += fieldSize; });
+  return size;
+}
+
+void SaveState(GameState &state, Uint8 *out) {
+  int mode = (int)state.mode;
+  memcpy(out, &mode, sizeof(mode));
+  out += sizeof(mode);
+  ForEachField(state.player, [&](void *field, size_t fieldSize) {
+    memcpy(out, field, fieldSize);
+    out += fieldSize;
+  });
+}
+
+void SaveState(GameState &state, std::vector<Uint8> *out) {
+  out->resize(StateSize(state));
+  SaveState(state, out->data());
+}
+
+bool LoadState(GameState &state, const Uint8 *data, size_t size) {
+  if (size != StateSize(state)) { return false; }
+
+  int mode;
+  memcpy(&mode, data, sizeof(mode));
+  state.mode = (GameMode)mode;
+  const Uint8 *at = data + sizeof(mode);
+  ForEachField(state.player, [&](void *field, size_t fieldSize) {
+    memcpy(field, at, fieldSize);
+    at += fieldSize;
+  });
+
+  //drawn from the matrix, which is only remade by Update
+  state.player->modelMatrix = glm::translate(glm::mat4(1.0f), state.player->position);
+  return true;
+}
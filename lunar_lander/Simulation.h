@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Entity.h"
+#include "Level.h"
+#include "Tilemap.h"
+
+#include <vector>
+
+#define FIXED_TIMESTEP 0.0166666f
+
+enum GameMode { PLAYING, WIN, LOSE };
+
+//everything the player can ask for in one fixed step
+struct InputFrame {
+    float moveX = 0.0f;
+    bool jump = false;
+};
+
+//the game as the simulation sees it
+//entities also carry textures and effects, those are filled in and used by whoever draws the game
+struct GameState {
+    Entity *player;
+    Entity *platforms;
+    int platformCount = 0;
+    //what the ship collides with, the platforms are only drawn
+    Tilemap tiles;
+    GameMode mode = PLAYING;
+};
+
+//the ship and the level's platforms in their starting places, without textures or effects
+//the level is only read here, it can be closed once the state is set up
+void SetupState(GameState &state, const Level &level);
+
+//advances the game one fixed step from nothing but its arguments, it doesn't read the clock,
+//poll devices or draw, so it can be run by the real time loop or as fast as it goes
+void Step(GameState &state, const InputFrame &input, float deltaTime);
+
+//the part of the state a step changes as bytes, the platforms are left out since nothing moves them
+size_t StateSize(GameState &state);
+//out has room for StateSize bytes
+void SaveState(GameState &state, Uint8 *out);
+void SaveState(GameState &state, std::vector<Uint8> *out);
+//bytes from SaveState put back into a state from SetupState, false if they aren't a saved state
+bool LoadState(GameState &state, const Uint8 *data, size_t size);
@@ -0,0 +1,101 @@
+#include "Snapshot.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define SNAPSHOT_VERSION 2
+
+static const char SNAPSHOT_MAGIC[4] = { 'L', 'L', 'S', 'N' };
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void Snapshot::Take(GameState &state, uint64_t levelHash, float accumulator) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  SnapshotHeader header;
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.levelHash = levelHash;
+  header.stateSize = (uint32_t)StateSize(state);
+  header.accumulator = accumulator;
+
+  bytes.resize(sizeof(header) + header.stateSize);
+  memcpy(bytes.data(), &header, sizeof(header));
+  SaveState(state, bytes.data() + sizeof(header));
+
+  takeMs = ElapsedMs(start);
+}
+
+bool Snapshot::Restore(GameState &state, uint64_t levelHash, float *accumulator) {
+  if (bytes.size() < sizeof(SnapshotHeader)) { return false; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  SnapshotHeader header;
+  memcpy(&header, bytes.data(), sizeof(header));
+  bool sameBuild = memcmp(header.magic, SNAPSHOT_MAGIC, 4) == 0 && header.version == SNAPSHOT_VERSION;
+  //another level with the same row counts would load without complaint, so it is checked first
+  if (sameBuild && header.levelHash != levelHash) {
+    std::cout << "snapshot: it was taken on a different level, not restoring it\n";
+    return false;
+  }
+  if (sameBuild == false || sizeof(header) + header.stateSize != bytes.size() ||
+      LoadState(state, bytes.data() + sizeof(header), header.stateSize) == false) {
+    std::cout << "snapshot: it is from a different build, not restoring it\n";
+    return false;
+  }
+  *accumulator = header.accumulator;
+
+  restoreMs = ElapsedMs(start);
+  return true;
+}
+
+bool Snapshot::Write(const char *filePath) {
+  if (bytes.empty()) { return false; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  FILE *file = fopen(filePath, "wb");
+  if (file == NULL) {
+    std::cout << "Unable to open snapshot file " << filePath << "\n";
+    return false;
+  }
+  fwrite(bytes.data(), 1, bytes.size(), file);
+  bool written = ferror(file) == 0;
+  fclose(file);
+  if (written == false) { std::cout << "Unable to write snapshot file " << filePath << "\n"; }
+
+  writeMs = ElapsedMs(start);
+  return written;
+}
+
+bool Snapshot::Read(const char *filePath) {
+  Uint64 start = SDL_GetPerformanceCounter();
+  FILE *file = fopen(filePath, "rb");
+  if (file == NULL) {
+    std::cout << "Unable to open snapshot file " << filePath << "\n";
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  bytes.resize(size > 0 ? size : 0);
+  bool read = size > 0 && fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+  fclose(file);
+  if (read == false) {
+    std::cout << "Unable to read snapshot file " << filePath << "\n";
+    bytes.clear();
+    return false;
+  }
+
+  readMs = ElapsedMs(start);
+  return true;
+}
+
+void Snapshot::Report() {
+  if (bytes.empty()) { return; }
+
+  std::cout << "snapshot: " << bytes.size() << " bytes, take " << takeMs * 1000.0 << " us, restore "
+            << restoreMs * 1000.0 << " us, write " << writeMs << " ms, read " << readMs << " ms\n";
+}
@@ -0,0 +1,72 @@
+#include "Tilemap.h"
+
+#include <cmath>
+#include <cstring>
+
+static bool OnGrid(float edge, float origin, float size) {
+  float cells = (edge - origin) / size;
+  return std::fabs(cells - std::round(cells)) < 0.001f;
+}
+
+static int ToCell(float edge, float origin, float size) {
+  return (int)std::round((edge - origin) / size);
+}
+
+void Tilemap::Build(const Entity *platforms, int count) {
+  width = 0;
+  height = 0;
+  if (count == 0) { return; }
+
+  float right = platforms[0].position.x + platforms[0].width / 2.0f;
+  float top = platforms[0].position.y + platforms[0].height / 2.0f;
+  originX = platforms[0].position.x - platforms[0].width / 2.0f;
+  originY = platforms[0].position.y - platforms[0].height / 2.0f;
+  for (int i = 1; i < count; i++) {
+    originX = std::fmin(originX, platforms[i].position.x - platforms[i].width / 2.0f);
+    originY = std::fmin(originY, platforms[i].position.y - platforms[i].height / 2.0f);
+    right = std::fmax(right, platforms[i].position.x + platforms[i].width / 2.0f);
+    top = std::fmax(top, platforms[i].position.y + platforms[i].height / 2.0f);
+  }
+
+  for (cellSize = 1.0f; cellSize > TILEMAP_MIN_CELL; cellSize /= 2.0f) {
+    bool fits = true;
+    for (int i = 0; i < count && fits; i++) {
+      const Entity &platform = platforms[i];
+      fits = OnGrid(platform.position.x - platform.width / 2.0f, originX, cellSize) &&
+             OnGrid(platform.position.x + platform.width / 2.0f, originX, cellSize) &&
+             OnGrid(platform.position.y - platform.height / 2.0f, originY, cellSize) &&
+             OnGrid(platform.position.y + platform.height / 2.0f, originY, cellSize);
+    }
+    if (fits) { break; }
+  }
+
+  width = ToCell(right, originX, cellSize);
+  height = ToCell(top, originY, cellSize);
+  cells = new Uint8[width * height];
+  memset(cells, NONE, width * height);
+
+  //later platforms are drawn over earlier ones, so they win where two overlap
+  for (int i = 0; i < count; i++) {
+    const Entity &platform = platforms[i];
+    int column0 = ToCell(platform.position.x - platform.width / 2.0f, originX, cellSize);
+    int column1 = ToCell(platform.position.x + platform.width / 2.0f, originX, cellSize);
+    int row0 = ToCell(platform.position.y - platform.height / 2.0f, originY, cellSize);
+    int row1 = ToCell(platform.position.y + platform.height / 2.0f, originY, cellSize);
+    for (int row = row0; row < row1; row++) {
+      memset(cells + row * width + column0, platform.entityType, column1 - column0);
+    }
+  }
+}
+
+bool Tilemap::Overlap(glm::vec3 position, float halfWidth, float halfHeight,
+                      int *column0, int *row0, int *column1, int *row1) const {
+  *column0 = (int)std::floor((position.x - halfWidth - originX) / cellSize);
+  *column1 = (int)std::ceil((position.x + halfWidth - originX) / cellSize) - 1;
+  *row0 = (int)std::floor((position.y - halfHeight - originY) / cellSize);
+  *row1 = (int)std::ceil((position.y + halfHeight - originY) / cellSize) - 1;
+  if (*column0 < 0) { *column0 = 0; }
+  if (*row0 < 0) { *row0 = 0; }
+  if (*column1 >= width) { *column1 = width - 1; }
+  if (*row1 >= height) { *row1 = height - 1; }
+  return *column0 <= *column1 && *row0 <= *row1;
+}
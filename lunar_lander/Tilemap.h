@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Entity.h"
+
+//smallest cell a tilemap will use, a level with platform edges finer than this has them rounded
+#define TILEMAP_MIN_CELL 0.125f
+
+//the level's platforms as a dense grid of cells, each holding the kind of platform covering it or
+//NONE, so what a box touches is found by looking up the cells under it instead of testing every
+//platform, the cost is the same for a map of ten tiles or ten thousand
+class Tilemap {
+public:
+    //bottom left corner of cell 0, 0, rows go up from there
+    float originX = 0.0f;
+    float originY = 0.0f;
+    float cellSize = 1.0f;
+    int width = 0;
+    int height = 0;
+    Uint8 *cells = NULL;
+
+    //covers every platform, cells are as big as they can be with every platform edge on a cell
+    //edge, so a level laid out on a grid gets one cell per tile
+    void Build(const Entity *platforms, int count);
+
+    EntityType At(int column, int row) const { return (EntityType)cells[row * width + column]; }
+    glm::vec3 Center(int column, int row) const {
+        return glm::vec3(originX + (column + 0.5f) * cellSize, originY + (row + 0.5f) * cellSize, 0.0f);
+    }
+
+    //the cells a box overlaps, touching edges don't count, false if it is off the map
+    bool Overlap(glm::vec3 position, float halfWidth, float halfHeight,
+                 int *column0, int *row0, int *column1, int *row1) const;
+};
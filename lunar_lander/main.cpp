@@ -15,19 +15,15 @@
 #include "stb_image.h"
 
 #include "Entity.h"
-
-#define PLATFORM_COUNT 26
+#include "GoldenTest.h"
+#include "Level.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "StepScheduler.h"
 
 #include <vector>
 
-enum GameMode { PLAYING, WIN, LOSE };
-GameMode mode = PLAYING;
-
-struct GameState {
-    Entity *player;
-    Entity *platforms;
-};
-
 GameState state;
 
 SDL_Window* displayWindow;
@@ -36,6 +32,47 @@ bool gameIsRunning = true;
 ShaderProgram program;
 glm::mat4 viewMatrix, modelMatrix, projectionMatrix;
 
+ParticleSystem particles;
+ParticleEmitter crashEmitter;
+ParticleEmitter landEmitter;
+
+GoldenTest golden;
+const char *goldenScript = NULL;
+const char *goldenDir = NULL;
+bool goldenUpdate = false;
+
+ReplayRecorder recorder;
+const char *recordPath = NULL;
+ReplayPlayer replay;
+const char *replayPath = NULL;
+int seekStep = 0;
+
+//F5 takes a snapshot and writes it to snapshotPath, F9 goes back to it
+Snapshot snapshot;
+const char *snapshotPath = "snapshot.bin";
+bool resumeSnapshot = false;
+bool takeSnapshot = false;
+bool restoreSnapshot = false;
+
+//--level plays a compiled level file instead of the built in one, it is mapped and read in place
+LevelFile levelFile;
+const char *levelPath = NULL;
+const Level *level = &DefaultLevel();
+double setupMs = 0.0;
+
+void SetupLevel() {
+  Uint64 start = SDL_GetPerformanceCounter();
+  SetupState(state, *level);
+  setupMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void ReportLevel() {
+  if (levelPath == NULL) { return; }
+  std::cout << "level: " << levelPath << ", " << state.platformCount << " platforms in a " << state.tiles.width
+            << "x" << state.tiles.height << " map of " << state.tiles.cellSize << " cells, mapped in "
+            << levelFile.openMs * 1000.0 << " us, set up in " << setupMs * 1000.0 << " us\n";
+}
+
 GLuint LoadTexture(const char* filePath) {
   int w, h, n;
   unsigned char* image = stbi_load(filePath, &w, &h, &n, STBI_rgb_alpha);
@@ -106,7 +143,9 @@ void DrawText(ShaderProgram *program, GLuint fontTextureID, std::string text,
 
 void Initialize() {
   SDL_Init(SDL_INIT_VIDEO);
-  displayWindow = SDL_CreateWindow("Lunar Lander", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 480, SDL_WINDOW_OPENGL);
+  Uint32 windowFlags = SDL_WINDOW_OPENGL;
+  if (goldenScript != NULL) { windowFlags |= SDL_WINDOW_HIDDEN; }
+  displayWindow = SDL_CreateWindow("Lunar Lander", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, 640, 480, windowFlags);
   SDL_GLContext context = SDL_GL_CreateContext(displayWindow);
   SDL_GL_MakeCurrent(displayWindow, context);
   
@@ -131,170 +170,116 @@ void Initialize() {
   glEnable(GL_BLEND);
 
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  particles.Load(PARTICLE_MAX);
+
+  crashEmitter.system = &particles;
+  crashEmitter.count = 600;
+  crashEmitter.speedMin = 0.5f;
+  crashEmitter.speedMax = 3.0f;
+  crashEmitter.lifeMin = 0.5f;
+  crashEmitter.lifeMax = 1.5f;
+  crashEmitter.size = 0.1f;
+  crashEmitter.gravity = 2.0f;
+  crashEmitter.drag = 1.0f;
+  crashEmitter.color[0] = 255;
+  crashEmitter.color[1] = 120;
+  crashEmitter.color[2] = 40;
+
+  landEmitter = crashEmitter;
+  landEmitter.count = 150;
+  landEmitter.speedMax = 1.5f;
+  landEmitter.size = 0.08f;
+  landEmitter.color[0] = 120;
+  landEmitter.color[1] = 255;
+  landEmitter.color[2] = 120;
   
  
   // Initialize Game Objects
-  
-  // Initialize Player
-  state.player = new Entity();
-  state.player->position = glm::vec3(0.0f, 5.0f, 0.0f);
-  state.player->movement = glm::vec3(0);
-  state.player->acceleration = glm::vec3(0.0f, 0.0f, 0.0f);
-  state.player->speed = 1.5f;
-  state.player->entityType = PLAYER;
-  state.player->velocity.y = -1.0f;
-
+  SetupLevel();
 
   SHIP_TEXTURES[0] = LoadTexture("blue_ship.png");
   SHIP_TEXTURES[1] = LoadTexture("red_ship.png");
   SHIP_TEXTURES[2] = LoadTexture("green_ship.png");
   state.player->textureID = SHIP_TEXTURES[0];
-  
-  state.player->height = 1.0f;
-  state.player->width = 1.0f;
 
-  state.player->jumpPower = 5.0f;
+  state.player->onLand = &landEmitter;
+  state.player->onDeath = &crashEmitter;
 
   fontTexID = new GLuint(LoadTexture("font.png"));
 
-  state.platforms = new Entity[PLATFORM_COUNT];
-
-  GLuint winPlatformTexID = LoadTexture("win_tile.png");
-  GLuint losePlatformTexID = LoadTexture("lose_tile.png");
-
-  //floor
-  state.platforms[0].textureID = losePlatformTexID;
-  state.platforms[0].position = glm::vec3(-4.5f, -3.25f, 0.0f);
-  state.platforms[0].entityType = LOSE_PLATFORM;
-
-  state.platforms[1].textureID = winPlatformTexID;
-  state.platforms[1].position = glm::vec3(-3.5f, -3.25f, 0.0f);
-  state.platforms[1].entityType = WIN_PLATFORM;
-
-  state.platforms[2].textureID = losePlatformTexID;
-  state.platforms[2].position = glm::vec3(-2.5f, -3.25f, 0.0f);
-  state.platforms[2].entityType = LOSE_PLATFORM;
-  
-  state.platforms[3].textureID = losePlatformTexID;
-  state.platforms[3].position = glm::vec3(-1.5f, -3.25f, 0.0f);
-  state.platforms[3].entityType = LOSE_PLATFORM;
-
-  state.platforms[4].textureID = losePlatformTexID;
-  state.platforms[4].position = glm::vec3(-0.5f, -3.25f, 0.0f);
-  state.platforms[4].entityType = LOSE_PLATFORM;
-
-  state.platforms[5].textureID = losePlatformTexID;
-  state.platforms[5].position = glm::vec3(0.5f, -3.25f, 0.0f);
-  state.platforms[5].entityType = LOSE_PLATFORM;
+  GLuint winPlatformTexID = LoadTexture(level->header->textures[TEXTURE_WIN_PLATFORM]);
+  GLuint losePlatformTexID = LoadTexture(level->header->textures[TEXTURE_LOSE_PLATFORM]);
+  for (int i = 0; i < state.platformCount; i++) {
+    state.platforms[i].textureID = state.platforms[i].entityType == WIN_PLATFORM ? winPlatformTexID : losePlatformTexID;
+  }
 
-  state.platforms[6].textureID = losePlatformTexID;
-  state.platforms[6].position = glm::vec3(1.5f, -3.25f, 0.0f);
-  state.platforms[6].entityType = LOSE_PLATFORM;
+  //record this session's input, or play back a recorded one from seekStep on
+  if (recordPath != NULL) { recorder.Start(recordPath, LevelHash(*level)); }
+  if (replayPath != NULL) {
+    if (replay.Open(replayPath, LevelHash(*level)) == false) { gameIsRunning = false; }
+    else if (seekStep > 0) { replay.Seek(state, seekStep); }
+  }
 
-  state.platforms[7].textureID = losePlatformTexID;
-  state.platforms[7].position = glm::vec3(2.5f, -3.25f, 0.0f);
-  state.platforms[7].entityType = LOSE_PLATFORM;
+  //headless scripted run checked against reference frames
+  if (goldenScript != NULL && golden.Start(goldenScript, goldenDir, goldenUpdate, 640, 480) == false) {
+    gameIsRunning = false;
+  }
+}
 
-  state.platforms[8].textureID = losePlatformTexID;
-  state.platforms[8].position = glm::vec3(3.5f, -3.25f, 0.0f);
-  state.platforms[8].entityType = LOSE_PLATFORM;
+//scripted input replaces the real event queue and keyboard during a golden run
+bool PollEvent(SDL_Event *event) {
+  if (golden.isRunning) { return golden.PollEvent(event); }
+  return SDL_PollEvent(event) != 0;
+}
 
-  state.platforms[9].textureID = losePlatformTexID;
-  state.platforms[9].position = glm::vec3(4.5f, -3.25f, 0.0f);
-  state.platforms[9].entityType = LOSE_PLATFORM;
-  
-  //left wall
-  state.platforms[10].textureID = losePlatformTexID;
-  state.platforms[10].position = glm::vec3(-4.5f, -2.25f, 0.0f);
-  state.platforms[10].entityType = LOSE_PLATFORM;
-
-  state.platforms[11].textureID = losePlatformTexID;
-  state.platforms[11].position = glm::vec3(-4.5f, -1.25f, 0.0f);
-  state.platforms[11].entityType = LOSE_PLATFORM;
-  
-  state.platforms[12].textureID = losePlatformTexID;
-  state.platforms[12].position = glm::vec3(-4.5f, -0.25f, 0.0f);
-  state.platforms[12].entityType = LOSE_PLATFORM;
+const Uint8 *GetKeyboardState() {
+  if (golden.isRunning) { return golden.keys; }
+  return SDL_GetKeyboardState(NULL);
+}
 
-  state.platforms[13].textureID = losePlatformTexID;
-  state.platforms[13].position = glm::vec3(-4.5f, 0.25f, 0.0f);
-  state.platforms[13].entityType = LOSE_PLATFORM;
-  
-  state.platforms[14].textureID = losePlatformTexID;
-  state.platforms[14].position = glm::vec3(-4.5f, 1.25f, 0.0f);
-  state.platforms[14].entityType = LOSE_PLATFORM;
-
-  state.platforms[15].textureID = losePlatformTexID;
-  state.platforms[15].position = glm::vec3(-4.5f, 2.25f, 0.0f);
-  state.platforms[15].entityType = LOSE_PLATFORM;
-
-  state.platforms[16].textureID = losePlatformTexID;
-  state.platforms[16].position = glm::vec3(-4.5f, 3.25f, 0.0f);
-  state.platforms[16].entityType = LOSE_PLATFORM;
-
-  //right wall
-  state.platforms[17].textureID = losePlatformTexID;
-  state.platforms[17].position = glm::vec3(4.5f, -2.25f, 0.0f);
-  state.platforms[17].entityType = LOSE_PLATFORM;
-
-  state.platforms[18].textureID = losePlatformTexID;
-  state.platforms[18].position = glm::vec3(4.5f, -1.25f, 0.0f);
-  state.platforms[18].entityType = LOSE_PLATFORM;
-  
-  state.platforms[19].textureID = losePlatformTexID;
-  state.platforms[19].position = glm::vec3(4.5f, -0.25f, 0.0f);
-  state.platforms[19].entityType = LOSE_PLATFORM;
+//input for the fixed steps of this frame
+InputFrame frameInput;
 
-  state.platforms[20].textureID = losePlatformTexID;
-  state.platforms[20].position = glm::vec3(4.5f, 0.25f, 0.0f);
-  state.platforms[20].entityType = LOSE_PLATFORM;
-  
-  state.platforms[21].textureID = losePlatformTexID;
-  state.platforms[21].position = glm::vec3(4.5f, 1.25f, 0.0f);
-  state.platforms[21].entityType = LOSE_PLATFORM;
-
-  state.platforms[22].textureID = losePlatformTexID;
-  state.platforms[22].position = glm::vec3(4.5f, 2.25f, 0.0f);
-  state.platforms[22].entityType = LOSE_PLATFORM;
-
-  state.platforms[23].textureID = losePlatformTexID;
-  state.platforms[23].position = glm::vec3(4.5f, 3.25f, 0.0f);
-  state.platforms[23].entityType = LOSE_PLATFORM;
-
-  //obstacles
-  state.platforms[24].textureID = losePlatformTexID;
-  state.platforms[24].position = glm::vec3(-2.5f, -0.25f, 0.0f);
-  state.platforms[24].entityType = LOSE_PLATFORM;
-
-  state.platforms[25].textureID = losePlatformTexID;
-  state.platforms[25].position = glm::vec3(-3.5f, -0.25f, 0.0f);
-  state.platforms[25].entityType = LOSE_PLATFORM;
-  
-  for (int i = 0; i < PLATFORM_COUNT; i++) {
-    state.platforms[i].Update(0, NULL, 0);
-  }
-  
+//game seconds per real second, below 1 is slow motion and above 1 fast forward
+//steps stay FIXED_TIMESTEP long either way, there are just fewer or more of them per frame
+#define TIME_SCALE_MIN 0.125f
+#define TIME_SCALE_MAX 8.0f
+float timeScale = 1.0f;
 
+void SetTimeScale(float scale) {
+  if (scale < TIME_SCALE_MIN) { scale = TIME_SCALE_MIN; }
+  if (scale > TIME_SCALE_MAX) { scale = TIME_SCALE_MAX; }
+  timeScale = scale;
 }
 
 void ProcessInput() {
+  if (golden.isRunning) { golden.BeginFrame(); }
+
   SDL_Event event;
-  switch(mode) {
+  switch(state.mode) {
     case WIN:
     case LOSE:
-      while (SDL_PollEvent(&event)) {
+      while (PollEvent(&event)) {
         switch (event.type) {
           case SDL_QUIT:
           case SDL_WINDOWEVENT_CLOSE:
             gameIsRunning = false;
             break;
+
+          //a crash can be taken back
+          case SDL_KEYDOWN:
+            if (event.key.keysym.sym == SDLK_F9) { restoreSnapshot = true; }
+            break;
         }
       }
       break;
     case PLAYING:
-      state.player->movement = glm::vec3(0);
+      //the held direction is read again every frame, a jump waits for a step to use it, a frame
+      //that runs no steps would otherwise lose it
+      frameInput.moveX = 0.0f;
       
-      while (SDL_PollEvent(&event)) {
+      while (PollEvent(&event)) {
         switch (event.type) {
           case SDL_QUIT:
           case SDL_WINDOWEVENT_CLOSE:
@@ -312,63 +297,111 @@ void ProcessInput() {
                 break;
                 
               case SDLK_SPACE:
-                if (state.player->collidedBottom) {
-                  state.player->jump = true;
-                }
+                frameInput.jump = true;
+                break;
+
+              //slow the game down and speed it up against the clock
+              case SDLK_LEFTBRACKET:
+                SetTimeScale(timeScale * 0.5f);
+                break;
+
+              case SDLK_RIGHTBRACKET:
+                SetTimeScale(timeScale * 2.0f);
+                break;
+
+              //done by Update between steps
+              case SDLK_F5:
+                takeSnapshot = true;
+                break;
+
+              case SDLK_F9:
+                restoreSnapshot = true;
                 break;
               }
             break; // SDL_KEYDOWN
         }
       }
       
-      const Uint8 *keys = SDL_GetKeyboardState(NULL);
+      const Uint8 *keys = GetKeyboardState();
 
       if (keys[SDL_SCANCODE_LEFT]) {
-        state.player->movement.x = -1.0f;
+        frameInput.moveX = -1.0f;
       }
       else if (keys[SDL_SCANCODE_RIGHT]) {
-        state.player->movement.x = 1.0f;
-      }
-      
-
-      if (glm::length(state.player->movement) > 1.0f) {
-        state.player->movement = glm::normalize(state.player->movement);
+        frameInput.moveX = 1.0f;
       }
       break;
   }
 }
 
-#define FIXED_TIMESTEP 0.0166666f
 float lastTicks = 0;
 float accumulator = 0.0f;
+//bounds the steps a frame runs after a stall, --catch-up picks what happens to the rest
+StepScheduler scheduler;
+
+//particles for how the last step ended
+void PlayStepEffects(GameMode lastMode) {
+  if (lastMode != PLAYING) { return; }
+  if (state.mode == WIN && state.player->onLand != NULL) { state.player->onLand->Emit(state.player->position); }
+  if (state.mode == LOSE && state.player->onDeath != NULL) { state.player->onDeath->Emit(state.player->position); }
+}
+
+//goes back to the snapshot taken this run, or the one on disk if there isn't one
+void RestoreSnapshot() {
+  if (snapshot.bytes.empty() && snapshot.Read(snapshotPath) == false) { return; }
+  if (snapshot.Restore(state, LevelHash(*level), &accumulator)) { scheduler.Clear(); }
+}
 
+//the real time driver, runs however many fixed steps the clock says are due
 void Update() {
+  //recordings and replays have to stay in step with their input, so F5 and F9 do nothing while
+  //one is going
+  bool canJump = recorder.isRecording == false && replay.isPlaying == false;
+  if (takeSnapshot && canJump) {
+    snapshot.Take(state, LevelHash(*level), accumulator);
+    snapshot.Write(snapshotPath);
+  }
+  if (restoreSnapshot && canJump) { RestoreSnapshot(); }
+  takeSnapshot = false;
+  restoreSnapshot = false;
+
   float ticks = (float)SDL_GetTicks() / 1000.0f;
   float deltaTime = ticks - lastTicks;
   lastTicks = ticks;
 
-  switch (mode) {
+  //golden runs advance exactly one step per frame so they don't depend on the clock
+  float scale = golden.isRunning ? 1.0f : timeScale;
+  if (golden.isRunning) { deltaTime = FIXED_TIMESTEP; }
+  else { deltaTime *= scale; }
+
+  switch (state.mode) {
     case WIN:
     case LOSE:
+      //let the crash play out
+      particles.Update(deltaTime);
       break;
     case PLAYING:
       deltaTime += accumulator;
+      deltaTime = scheduler.Limit(deltaTime, scale);
 
       if (deltaTime < FIXED_TIMESTEP) { accumulator = deltaTime; return; }
 
       // Update using fixed time step
       while (deltaTime >= FIXED_TIMESTEP) {
-        //if bottom collision update and check if collided with win or lose platform
-        if (state.player->collidedBottom) {
-          state.player->Update(FIXED_TIMESTEP, state.platforms, PLATFORM_COUNT);
-          if (state.player->lastCollision == WIN_PLATFORM) {
-            mode = WIN;
-          } else {
-            mode = LOSE;
-          }
-        } else {
-          state.player->Update(FIXED_TIMESTEP, state.platforms, PLATFORM_COUNT);
+        //a replay still lets the keys change the time scale, but the step gets the recorded input
+        if (replay.isPlaying && replay.Read(state, &frameInput) == false) {
+          gameIsRunning = false;
+          break;
         }
+        recorder.Record(state, frameInput);
+
+        GameMode lastMode = state.mode;
+        Step(state, frameInput, FIXED_TIMESTEP);
+        //a jump is one key press, not one per step
+        frameInput.jump = false;
+        PlayStepEffects(lastMode);
+
+        particles.Update(FIXED_TIMESTEP);
         deltaTime -= FIXED_TIMESTEP;
       }
       accumulator = deltaTime;
@@ -377,10 +410,58 @@ void Update() {
 
 }
 
+//made up input that drifts left and right and jumps now and then, the same for the same seed
+InputFrame BotInput(unsigned int *seed) {
+  *seed = *seed * 1103515245 + 12345;
+  int r = (*seed >> 16) & 255;
+  InputFrame frame;
+  frame.moveX = (float)((r & 3) == 0 ? -1 : (r & 3) == 1 ? 1 : 0);
+  frame.jump = (r >> 2) < 2;
+  return frame;
+}
+
+int batchSteps = 0;
+
+//the batch driver, runs steps fixed steps on the bot's input as fast as they go, with no
+//window or drawing, the game keeps going after it is won or lost so every run is steps long
+//with --replay the input comes from the recording instead and the run stops where it does
+void RunBatch(int steps) {
+  SetupLevel();
+
+  if (replayPath != NULL) {
+    if (replay.Open(replayPath, LevelHash(*level)) == false) { return; }
+    if (seekStep > 0) { replay.Seek(state, seekStep); }
+  }
+  if (recordPath != NULL) { recorder.Start(recordPath, LevelHash(*level)); }
+
+  unsigned int seed = 1;
+  int endStep = -1;
+  int step = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (; step < steps; step++) {
+    InputFrame frame = BotInput(&seed);
+    if (replay.isPlaying && replay.Read(state, &frame) == false) { break; }
+    recorder.Record(state, frame);
+    Step(state, frame, FIXED_TIMESTEP);
+    if (state.mode != PLAYING && endStep < 0) { endStep = step; }
+  }
+  double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+  const char *modes[] = { "playing", "won", "lost" };
+  std::cout << "batch: " << step << " steps in " << ms << " ms, " << step * 1000.0 / ms << " steps per second ("
+            << step * FIXED_TIMESTEP * 1000.0 / ms << "x real time), " << modes[state.mode];
+  if (endStep >= 0) { std::cout << " at step " << endStep; }
+  std::cout << "\n";
+  ReportLevel();
+  recorder.Finish();
+  recorder.Report();
+  replay.Report();
+}
+
 void Render() {
   glClear(GL_COLOR_BUFFER_BIT);
 
-  switch (mode) {
+  switch (state.mode) {
     case WIN:
       DrawText(&program, *fontTexID, "GREAT SUCCESS!!", 0.5f, -0.25f, glm::vec3(-2.0f, 1.0f, 0.0f));
       state.player->textureID = SHIP_TEXTURES[2];
@@ -391,22 +472,106 @@ void Render() {
       break;
   }
 
-  for (int i = 0; i < PLATFORM_COUNT; i++) {
+  for (int i = 0; i < state.platformCount; i++) {
     state.platforms[i].Render(&program);
   }
 
   state.player->Render(&program);
+
+  particles.Render(viewMatrix, projectionMatrix);
+
+  if (golden.isRunning && golden.EndFrame() == false) { gameIsRunning = false; }
   
   SDL_GL_SwapWindow(displayWindow);
 }
 
 
-void Shutdown() {
+int Shutdown() {
+  ReportLevel();
+  recorder.Finish();
+  recorder.Report();
+  replay.Report();
+  snapshot.Report();
+  scheduler.Report();
+  int failures = 0;
+  if (goldenScript != NULL) { failures = golden.Finish(); }
   SDL_Quit();
+  return failures;
 }
 
 int main(int argc, char* argv[]) {
+  // --golden <script> <dir> checks frames against <dir>, add --update-golden to rewrite them
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--golden") == 0 && i + 2 < argc) {
+      goldenScript = argv[++i];
+      goldenDir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--update-golden") == 0) {
+      goldenUpdate = true;
+    }
+    // --time-scale <x> runs the game x times as fast as the clock, [ and ] change it while playing
+    else if (strcmp(argv[i], "--time-scale") == 0 && i + 1 < argc) {
+      SetTimeScale((float)atof(argv[++i]));
+    }
+    // --batch <steps> runs that many steps with made up input as fast as possible and exits
+    else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      batchSteps = atoi(argv[++i]);
+    }
+    // --record <file> logs every step's input so the session can be played back with --replay
+    else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    }
+    // --replay <file> plays a recording instead of reading the keyboard, --seek <step> starts it
+    // that many steps in
+    else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+      seekStep = atoi(argv[++i]);
+    }
+    // --catch-up <drop|slow> is what happens to the steps over --max-steps <n> in a frame after a
+    // stall, drop skips them and slow runs them over the next few frames
+    else if (strcmp(argv[i], "--catch-up") == 0 && i + 1 < argc) {
+      scheduler.policy = strcmp(argv[++i], "drop") == 0 ? DROP_TIME : SLOW_DOWN;
+    }
+    else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc) {
+      scheduler.maxStepsPerFrame = atoi(argv[++i]);
+      if (scheduler.maxStepsPerFrame < 1) { scheduler.maxStepsPerFrame = 1; }
+    }
+    // --resume <file> starts from a snapshot F5 wrote, F5 and F9 then use that file too
+    else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+      snapshotPath = argv[++i];
+      resumeSnapshot = true;
+    }
+    // --level <file> plays a level compiled with --compile-level <text file> <level file>, which
+    // writes the level and exits
+    else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+      levelPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "--compile-level") == 0 && i + 2 < argc) {
+      const char *sourcePath = argv[++i];
+      return CompileLevel(sourcePath, argv[++i]) ? 0 : 1;
+    }
+  }
+
+  if (levelPath != NULL) {
+    if (levelFile.Open(levelPath) == false) { return 1; }
+    level = &levelFile.level;
+  }
+  //a recording starts from the level's first step, that is where playback starts it too
+  if (resumeSnapshot && (recordPath != NULL || replayPath != NULL)) {
+    std::cout << "--resume can't be used with --record or --replay, recordings start from the level's first step\n";
+    return 1;
+  }
+
+  if (batchSteps > 0) {
+    RunBatch(batchSteps);
+    return 0;
+  }
+
   Initialize();
+  //pick up where a snapshot on disk left off
+  if (resumeSnapshot) { RestoreSnapshot(); }
   
   while (gameIsRunning) {
     ProcessInput();
@@ -414,7 +579,6 @@ int main(int argc, char* argv[]) {
     Render();
   }
   
-  Shutdown();
-  return 0;
+  return Shutdown() == 0 ? 0 : 1;
 }
 
@@ -0,0 +1,22 @@
+attribute vec2 position;
+
+// per instance
+attribute float particleX;
+attribute float particleY;
+attribute float particleSize;
+attribute float particleAge;
+attribute vec4 particleColor;
+
+uniform mat4 viewMatrix;
+uniform mat4 projectionMatrix;
+
+varying vec2 texCoordVar;
+varying vec4 colorVar;
+
+void main()
+{
+    vec4 p = vec4(particleX + position.x * particleSize, particleY + position.y * particleSize, 0.0, 1.0);
+    texCoordVar = position + vec2(0.5);
+    colorVar = vec4(particleColor.rgb, particleColor.a * (1.0 - particleAge));
+    gl_Position = projectionMatrix * viewMatrix * p;
+}
@@ -0,0 +1,130 @@
+#include "Net.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WINDOWS
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static sockaddr_in LoopbackAddress(int port) {
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((unsigned short)port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+bool UdpSocket::Open(int localPort, int remotePort) {
+  Close();
+#ifdef _WINDOWS
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+    std::cout << "Unable to start winsock\n";
+    return false;
+  }
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s == INVALID_SOCKET) {
+    std::cout << "Unable to make a udp socket\n";
+    return false;
+  }
+  u_long nonBlocking = 1;
+  ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) {
+    std::cout << "Unable to make a udp socket\n";
+    return false;
+  }
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+  handle = (intptr_t)s;
+
+  sockaddr_in address = LoopbackAddress(localPort);
+  if (bind(s, (sockaddr *)&address, sizeof(address)) != 0) {
+    std::cout << "Unable to listen on port " << localPort << ", is something else using it?\n";
+    Close();
+    return false;
+  }
+  this->remotePort = remotePort;
+  return true;
+}
+
+void UdpSocket::Close() {
+  if (handle == -1) { return; }
+#ifdef _WINDOWS
+  closesocket((SOCKET)handle);
+  WSACleanup();
+#else
+  close((int)handle);
+#endif
+  handle = -1;
+}
+
+void UdpSocket::Send(const Uint8 *data, int size) {
+  if (handle == -1) { return; }
+  sockaddr_in address = LoopbackAddress(remotePort);
+  //a full buffer or nobody listening yet is the same as a lost packet, the game sends again anyway
+#ifdef _WINDOWS
+  sendto((SOCKET)handle, (const char *)data, size, 0, (sockaddr *)&address, sizeof(address));
+#else
+  sendto((int)handle, data, size, 0, (sockaddr *)&address, sizeof(address));
+#endif
+}
+
+int UdpSocket::Receive(Uint8 *data, int capacity) {
+  if (handle == -1) { return -1; }
+#ifdef _WINDOWS
+  int size = recv((SOCKET)handle, (char *)data, capacity, 0);
+#else
+  int size = (int)recv((int)handle, data, capacity, 0);
+#endif
+  return size < 0 ? -1 : size;
+}
+
+//xorshift, plenty for picking which packets to lose
+Uint32 NetEmulator::Random() {
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+void NetEmulator::Send(UdpSocket &socket, const Uint8 *data, int size, Uint32 now) {
+  sent++;
+  if (loss > 0.0f && (Random() % 10000) < (Uint32)(loss * 10000.0f)) {
+    dropped++;
+    return;
+  }
+  Uint32 due = now + delayMs + (jitterMs > 0 ? Random() % (jitterMs + 1) : 0);
+  if (due == now) {
+    socket.Send(data, size);
+    return;
+  }
+  Held packet;
+  packet.due = due;
+  packet.bytes.assign(data, data + size);
+  held.push_back(packet);
+}
+
+void NetEmulator::Flush(UdpSocket &socket, Uint32 now) {
+  size_t kept = 0;
+  for (size_t i = 0; i < held.size(); i++) {
+    if ((int)(now - held[i].due) >= 0) {
+      socket.Send(held[i].bytes.data(), (int)held[i].bytes.size());
+    } else {
+      if (kept != i) { held[kept].bytes.swap(held[i].bytes); held[kept].due = held[i].due; }
+      kept++;
+    }
+  }
+  held.resize(kept);
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <vector>
+
+//a non blocking udp socket on 127.0.0.1 that talks to one peer on the same machine
+class UdpSocket {
+public:
+    bool Open(int localPort, int remotePort);
+    void Close();
+    bool IsOpen() const { return handle != -1; }
+    void Send(const Uint8 *data, int size);
+    //copies the next waiting datagram into data and returns its size, -1 when nothing is waiting
+    int Receive(Uint8 *data, int capacity);
+
+private:
+    //a SOCKET on windows, a file descriptor everywhere else
+    intptr_t handle = -1;
+    int remotePort = 0;
+};
+
+//stands between the game and the socket and makes loopback look like a real connection
+//every packet is dropped with probability loss, otherwise held for delayMs plus up to jitterMs
+//more, so with jitter packets also arrive out of order
+class NetEmulator {
+public:
+    int delayMs = 0;
+    int jitterMs = 0;
+    float loss = 0.0f;
+
+    int sent = 0;
+    int dropped = 0;
+
+    void Send(UdpSocket &socket, const Uint8 *data, int size, Uint32 now);
+    //sends the held packets that are due by now
+    void Flush(UdpSocket &socket, Uint32 now);
+
+private:
+    struct Held {
+        Uint32 due;
+        std::vector<Uint8> bytes;
+    };
+    std::vector<Held> held;
+    //its own generator, so emulating the network never changes anything else's random numbers
+    Uint32 seed = 2463534242u;
+
+    Uint32 Random();
+};
@@ -10,10 +10,12 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "Net.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include <cstdint>
 #include <vector>
 
 SDL_Window* displayWindow;
@@ -37,6 +39,14 @@ private:
 };
 
 
+//what changes about an object while playing, everything that decides its next update
+struct ObjectState {
+  glm::vec3 position;
+  glm::vec3 movement;
+  bool moving = false;
+  bool scored = false;
+};
+
 class Object {
 public:
   Object(glm::vec3 position, GLuint textureID);
@@ -48,6 +58,8 @@ public:
   float getH();
   void setMoveX(float x);
   void setMoveY(float y);
+  virtual void save(ObjectState *out);
+  virtual void load(const ObjectState &in);
 protected:
   GLuint textureID;
   glm::mat4 modelMatrix;
@@ -67,19 +79,224 @@ public:
 
 class Ball: public Object {
 public:
-  Ball(glm::vec3 position, GLuint textureID);
+  Ball(glm::vec3 position, GLuint textureID, Object *left, Object *right);
   void update(float deltaTime);
   void checkCollisions(glm::vec3 *new_pos);
   void start();
+  bool hasScored();
+  void save(ObjectState *out);
+  void load(const ObjectState &in);
 private:
   bool moving;
+  bool scored;
+  Object *left;
+  Object *right;
+};
+
+#define FIXED_TIMESTEP 0.0166666f
+
+//everything the players can ask for in one fixed step
+struct InputFrame {
+  float leftMove = 0.0f;
+  float rightMove = 0.0f;
+  bool serve = false;
+};
+
+//the game as the simulation sees it, the objects also carry their textures for drawing
+struct GameState {
+  Player *left = NULL;
+  Player *right = NULL;
+  Ball *ball = NULL;
+  //someone scored, which ends the game
+  bool over = false;
 };
 
+GameState state;
 std::vector<Object*> objs;
 
-float getDeltaTime();
 bool isColliding(glm::vec3 *new_pos, float width, float height, Object *obj);
 
+//paddles in the middle and the ball waiting to be served
+void SetupState(GameState &state, GLuint playerTextureID, GLuint ballTextureID) {
+  state.left = new Player(glm::vec3(-4.5f, 0.0f, 0.0f), playerTextureID);
+  state.right = new Player(glm::vec3(4.5f, 0.0f, 0.0f), playerTextureID);
+  state.ball = new Ball(glm::vec3(0.0f, 0.0f, 0.0f), ballTextureID, state.left, state.right);
+  state.over = false;
+}
+
+//advances the game one fixed step from nothing but its arguments, it doesn't read the clock,
+//poll devices or draw, so it can be run by the real time loop or as fast as it goes
+void Step(GameState &state, const InputFrame &input, float deltaTime) {
+  state.left->setMoveY(input.leftMove);
+  state.right->setMoveY(input.rightMove);
+  if (input.serve) { state.ball->start(); }
+
+  state.left->update(deltaTime);
+  state.right->update(deltaTime);
+  state.ball->update(deltaTime);
+  if (state.ball->hasScored()) { state.over = true; }
+}
+
+//the whole game at one frame, small enough to keep one for every frame a rollback may go back
+struct SavedState {
+  ObjectState left;
+  ObjectState right;
+  ObjectState ball;
+  bool over = false;
+};
+
+void SaveState(GameState &state, SavedState *out) {
+  state.left->save(&out->left);
+  state.right->save(&out->right);
+  state.ball->save(&out->ball);
+  out->over = state.over;
+}
+
+void LoadState(GameState &state, const SavedState &saved) {
+  state.left->load(saved.left);
+  state.right->load(saved.right);
+  state.ball->load(saved.ball);
+  state.over = saved.over;
+}
+
+//fnv-1a over the fields one at a time, so padding in the structs never counts
+uint32_t checksumBytes(uint32_t hash, const void *data, size_t size) {
+  const Uint8 *bytes = (const Uint8 *)data;
+  for (size_t i = 0; i < size; i++) { hash = (hash ^ bytes[i]) * 16777619u; }
+  return hash;
+}
+
+uint32_t checksumObject(uint32_t hash, const ObjectState &object) {
+  hash = checksumBytes(hash, &object.position, sizeof(object.position));
+  hash = checksumBytes(hash, &object.movement, sizeof(object.movement));
+  Uint8 flags = (object.moving ? 1 : 0) | (object.scored ? 2 : 0);
+  return checksumBytes(hash, &flags, 1);
+}
+
+//two machines that simulated the same frames from the same input have the same checksum
+uint32_t StateChecksum(const SavedState &saved) {
+  uint32_t hash = 2166136261u;
+  hash = checksumObject(hash, saved.left);
+  hash = checksumObject(hash, saved.right);
+  hash = checksumObject(hash, saved.ball);
+  Uint8 over = saved.over ? 1 : 0;
+  return checksumBytes(hash, &over, 1);
+}
+
+//one player's input for one frame as it goes over the network, bits 0 and 1 are the paddle and
+//bit 2 is a serve
+#define INPUT_UP 1
+#define INPUT_DOWN 2
+#define INPUT_SERVE 4
+
+Uint8 packInput(float move, bool serve) {
+  Uint8 bits = move > 0.0f ? INPUT_UP : (move < 0.0f ? INPUT_DOWN : 0);
+  return bits | (serve ? INPUT_SERVE : 0);
+}
+
+float unpackMove(Uint8 bits) {
+  if (bits & INPUT_UP) { return 1.0f; }
+  if (bits & INPUT_DOWN) { return -1.0f; }
+  return 0.0f;
+}
+
+//frames of input and state kept, has to be more than NET_MAX_ROLLBACK and NET_MAX_INPUTS
+#define NET_RING 64
+//furthest back a rollback goes, a side this far ahead of the other's input waits for it
+#define NET_MAX_ROLLBACK 12
+//most inputs a packet carries, a side with this many the other hasn't acked waits too
+#define NET_MAX_INPUTS 32
+//frames between giving up a step to let the other side catch up
+#define NET_WAIT_INTERVAL 10
+//how long the end of a match is sent for once it is confirmed, in case the other side missed it
+#define NET_LINGER_MS 1000
+
+//every packet is this followed by count input bytes for the frames from start on
+//the inputs are all the sender's the receiver hasn't acked yet, so a lost packet is made up by
+//the next one and the input never has to be sent reliably
+struct NetPacket {
+  char magic[4];
+  //the sender's frame, and the newest frame it has the receiver's input for up to
+  int32_t frame;
+  int32_t ack;
+  //the sender's checksum of its state at checkFrame, which every input before it is confirmed for
+  int32_t checkFrame;
+  uint32_t checksum;
+  int32_t start;
+  int32_t count;
+};
+
+//rollback netcode for two players, one on each side of a udp socket
+//we never wait for the other side's input, a frame runs with a guess at it, the last input they
+//sent without the serve, and the state of every frame is kept, when their real input comes and
+//the guess was wrong the state from that frame is loaded and every frame since is run again
+class Rollback {
+public:
+  bool isLeft = true;
+  UdpSocket socket;
+  NetEmulator emulator;
+  //frames run so far, the state is the state at this frame
+  int frame = 0;
+  //newest frame we have the other side's input for, and every frame before it
+  int remoteFrame = -1;
+  //newest frame the other side has our input for
+  int peerAck = -1;
+  bool connected = false;
+  //frames to play before the match ends on its own, -1 to play until someone scores
+  int frameLimit = -1;
+  //the first frame the game is over in with every input before it confirmed, -1 until then
+  int overFrame = -1;
+  Uint32 overTicks = 0;
+
+  //rollbacks and how deep they went, depthCounts[d] is rollbacks of d frames
+  int rollbacks = 0;
+  int depthCounts[NET_MAX_ROLLBACK + 1] = {};
+  double depthMs[NET_MAX_ROLLBACK + 1] = {};
+  int maxDepth = 0;
+  double resimMs = 0.0;
+  double maxResimMs = 0.0;
+  //frames we had a step due but couldn't take it, and steps given up to let the other side catch up
+  int stalls = 0;
+  int waits = 0;
+  int packetsReceived = 0;
+  int checks = 0;
+  int desyncs = 0;
+
+  bool start(int localPort, int remotePort, GameState &state);
+  //reads what has arrived and rolls back if it shows a guess was wrong
+  void poll(GameState &state, Uint32 now);
+  bool canStep();
+  //true once in a while when we are ahead of the other side, the step due should be skipped
+  bool shouldWait();
+  //runs the current frame with this input for our paddle
+  void advance(GameState &state, Uint8 input);
+  void send(Uint32 now);
+  //the match is over and the other side has had time to find out
+  bool isFinished(Uint32 now);
+  void report();
+
+private:
+  Uint8 localInputs[NET_RING];
+  //confirmed input up to remoteFrame, after it the guesses the frames were run with
+  Uint8 remoteInputs[NET_RING];
+  SavedState states[NET_RING];
+  //earliest frame run with a wrong guess, -1 when there isn't one
+  int firstWrong = -1;
+  //the other side's frame and how far ahead of our input it was, for keeping the two in step
+  int peerFrame = -1;
+  int peerAdvantage = 0;
+  int lastWaitFrame = 0;
+  //newest checksum from the other side, and the last frame we compared
+  int peerCheckFrame = -1;
+  uint32_t peerChecksum = 0;
+  int lastChecked = -1;
+
+  void simulate(GameState &state, int f);
+  void receive(const Uint8 *data, int size);
+  //newest frame every input is known for on both sides
+  int confirmedFrame() { return remoteFrame < frame - 1 ? remoteFrame : frame - 1; }
+};
+
 void Initialize() {
   SDL_Init(SDL_INIT_VIDEO);
   displayWindow = SDL_CreateWindow("Pong", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
@@ -115,17 +332,33 @@ void Initialize() {
   Texture ballTex("ball.png");
 
   //create objects
-  Player *p1 = new Player(glm::vec3(-4.5f, 0.0f, 0.0f), playerTex.getTextureID());
-  objs.push_back(p1);
+  SetupState(state, playerTex.getTextureID(), ballTex.getTextureID());
+  objs.push_back(state.left);
+  objs.push_back(state.right);
+  objs.push_back(state.ball);
+}
 
-  Player *p2 = new Player(glm::vec3(4.5f, 0.0f, 0.0f), playerTex.getTextureID());
-  objs.push_back(p2);
-  
-  Ball *ball = new Ball(glm::vec3(0.0f, 0.0f, 0.0f), ballTex.getTextureID());
-  objs.push_back(ball);
+//input for the fixed steps of this frame
+InputFrame frameInput;
+
+//game seconds per real second, below 1 is slow motion and above 1 fast forward
+//steps stay FIXED_TIMESTEP long either way, there are just fewer or more of them per frame
+#define TIME_SCALE_MIN 0.125f
+#define TIME_SCALE_MAX 8.0f
+float timeScale = 1.0f;
+
+void setTimeScale(float scale) {
+  if (scale < TIME_SCALE_MIN) { scale = TIME_SCALE_MIN; }
+  if (scale > TIME_SCALE_MAX) { scale = TIME_SCALE_MAX; }
+  timeScale = scale;
 }
 
 void ProcessInput() {
+  //the held paddles are read again every frame, a serve waits for a step to use it, a frame that
+  //runs no steps would otherwise lose it
+  frameInput.leftMove = 0.0f;
+  frameInput.rightMove = 0.0f;
+
   //proccess event
   SDL_Event event;
   while (SDL_PollEvent(&event)) {
@@ -139,8 +372,15 @@ void ProcessInput() {
         switch(event.key.keysym.sym) {
           case SDLK_SPACE:
             //start ball when space pressed
-            Ball *ball = static_cast<Ball*>(objs[2]);
-            ball->start();
+            frameInput.serve = true;
+            break;
+          //slow the game down and speed it up against the clock
+          case SDLK_LEFTBRACKET:
+            setTimeScale(timeScale * 0.5f);
+            break;
+          case SDLK_RIGHTBRACKET:
+            setTimeScale(timeScale * 2.0f);
+            break;
         }
         break;
     }
@@ -149,24 +389,133 @@ void ProcessInput() {
   const Uint8 *keys = SDL_GetKeyboardState(NULL);
   //move p1
   if(keys[SDL_SCANCODE_W]) {
-    objs[0]->setMoveY(1.0f);
+    frameInput.leftMove = 1.0f;
   } else if(keys[SDL_SCANCODE_S]) {
-    objs[0]->setMoveY(-1.0f);
+    frameInput.leftMove = -1.0f;
   }
   //move p2
   if(keys[SDL_SCANCODE_UP]) {
-    objs[1]->setMoveY(1.0f);
+    frameInput.rightMove = 1.0f;
   } else if(keys[SDL_SCANCODE_DOWN]) {
-    objs[1]->setMoveY(-1.0f);
+    frameInput.rightMove = -1.0f;
+  }
+
+}
+
+//both paddles follow the ball, so a rally goes on for as long as it is run
+InputFrame botInput(const GameState &state, int step) {
+  InputFrame frame;
+  frame.serve = step == 0;
+  float ballY = state.ball->getY();
+  if (ballY > state.left->getY()) { frame.leftMove = 1.0f; }
+  else if (ballY < state.left->getY()) { frame.leftMove = -1.0f; }
+  if (ballY > state.right->getY()) { frame.rightMove = 1.0f; }
+  else if (ballY < state.right->getY()) { frame.rightMove = -1.0f; }
+  return frame;
+}
+
+float lastTicks = 0;
+float accumulator = 0.0f;
+
+//set with --net, the match is against another copy of the game and our paddle is the one for isLeft
+Rollback net;
+bool isNet = false;
+
+//the networked driver, the same clock as Update but the steps go through the rollback session
+//and the time scale is left alone, both sides have to run at the same speed
+//move and serve are our paddle's, bot tracks the ball with it instead
+//serve is cleared once a step has sent it, until then it stays set for the next call
+//returns false once the match is over and the other side has had its chance to see it
+bool updateNet(float move, bool *serve, bool bot) {
+  Uint32 now = SDL_GetTicks();
+  float ticks = (float)now / 1000.0f;
+  float deltaTime = ticks - lastTicks + accumulator;
+  lastTicks = ticks;
+
+  net.poll(state, now);
+  //input goes out once a step, polling can be a lot more often than that
+  bool ticked = deltaTime >= FIXED_TIMESTEP;
+  while (deltaTime >= FIXED_TIMESTEP) {
+    deltaTime -= FIXED_TIMESTEP;
+    if (net.shouldWait()) { continue; }
+    if (net.canStep() == false) {
+      //the time goes, waiting doesn't make the other side's input come any faster
+      if (net.connected && net.overFrame < 0) { net.stalls++; }
+      continue;
+    }
+    if (bot) {
+      InputFrame frame = botInput(state, net.frame);
+      move = net.isLeft ? frame.leftMove : frame.rightMove;
+      *serve = net.isLeft && net.frame == 0;
+    }
+    net.advance(state, packInput(move, *serve));
+    //a serve is one key press, not one per step, and not lost to a frame that waited or stalled
+    *serve = false;
   }
+  accumulator = deltaTime;
+  if (ticked) { net.send(now); }
+  return net.isFinished(now) == false;
+}
 
+//how long a match without a window waits for the other side to turn up
+#define NET_CONNECT_MS 10000
+
+//updateNet without a window, our paddle follows the ball for steps frames or until someone scores
+void runNetBatch(int steps) {
+  net.frameLimit = steps;
+  Uint32 started = SDL_GetTicks();
+  bool serve = false;
+  while (updateNet(0.0f, &serve, true)) {
+    if (net.connected == false && SDL_GetTicks() - started > NET_CONNECT_MS) {
+      std::cout << "net: nobody answered, is the other side running?\n";
+      break;
+    }
+    SDL_Delay(1);
+  }
 }
 
+//the real time driver, runs however many fixed steps the clock says are due
 void Update() {
-  float deltaTime = getDeltaTime();
-  for (size_t i = 0; i < objs.size(); i++) {
-    objs[i]->update(deltaTime);
+  if (isNet) {
+    float move = frameInput.leftMove != 0.0f ? frameInput.leftMove : frameInput.rightMove;
+    if (updateNet(move, &frameInput.serve, false) == false) { gameIsRunning = false; }
+    return;
+  }
+
+  float ticks = (float)SDL_GetTicks() / 1000.0f;
+  float deltaTime = (ticks - lastTicks) * timeScale;
+  lastTicks = ticks;
+
+  deltaTime += accumulator;
+  if (deltaTime < FIXED_TIMESTEP) { accumulator = deltaTime; return; }
+
+  while (deltaTime >= FIXED_TIMESTEP) {
+    Step(state, frameInput, FIXED_TIMESTEP);
+    //a serve is one key press, not one per step
+    frameInput.serve = false;
+    deltaTime -= FIXED_TIMESTEP;
+  }
+  accumulator = deltaTime;
+
+  if (state.over) { gameIsRunning = false; }
+}
+
+//the batch driver, runs steps fixed steps on the bot's input as fast as they go, with no
+//window or drawing
+void runBatch(int steps) {
+  SetupState(state, 0, 0);
+
+  int step = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (; step < steps && state.over == false; step++) {
+    Step(state, botInput(state, step), FIXED_TIMESTEP);
   }
+  double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+  std::cout << "batch: " << step << " steps in " << ms << " ms, " << step * 1000.0 / ms << " steps per second ("
+            << step * FIXED_TIMESTEP * 1000.0 / ms << "x real time)";
+  if (state.over) { std::cout << ", someone scored"; }
+  std::cout << "\n";
 }
 
 void Render() {
@@ -192,6 +541,7 @@ void Render() {
 }
 
 void Shutdown() {
+  net.report();
   for (size_t i = 0; i < objs.size(); i++) {
     free(objs[i]);
   }
@@ -199,7 +549,54 @@ void Shutdown() {
 }
 
 int main(int argc, char* argv[]) {
+  int batchSteps = 0;
+  int localPort = 0;
+  int remotePort = 0;
+  for (int i = 1; i < argc; i++) {
+    // --time-scale <x> runs the game x times as fast as the clock, [ and ] change it while playing
+    if (strcmp(argv[i], "--time-scale") == 0 && i + 1 < argc) {
+      setTimeScale((float)atof(argv[++i]));
+    }
+    // --batch <steps> runs that many steps with the paddles following the ball and exits
+    else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      batchSteps = atoi(argv[++i]);
+    }
+    // --net <left|right> <port> <other port> plays the paddle on that side against another copy
+    // listening on the other port, both on this machine
+    else if (strcmp(argv[i], "--net") == 0 && i + 3 < argc) {
+      isNet = true;
+      net.isLeft = strcmp(argv[++i], "right") != 0;
+      localPort = atoi(argv[++i]);
+      remotePort = atoi(argv[++i]);
+    }
+    // --delay <ms>, --jitter <ms> and --loss <0 to 1> make the connection to the other copy worse
+    else if (strcmp(argv[i], "--delay") == 0 && i + 1 < argc) {
+      net.emulator.delayMs = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+      net.emulator.jitterMs = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+      net.emulator.loss = (float)atof(argv[++i]);
+    }
+  }
+
+  if (batchSteps > 0) {
+    if (isNet == false) {
+      runBatch(batchSteps);
+      return 0;
+    }
+    SetupState(state, 0, 0);
+    if (net.start(localPort, remotePort, state)) { runNetBatch(batchSteps); }
+    net.report();
+    return 0;
+  }
+
   Initialize();
+  if (isNet && net.start(localPort, remotePort, state) == false) {
+    Shutdown();
+    return 1;
+  }
   
   while (gameIsRunning) {
       ProcessInput();
@@ -211,14 +608,6 @@ int main(int argc, char* argv[]) {
   return 0;
 }
 
-float getDeltaTime() {
-  static float lastTicks = 0;
-  float ticks = (float)SDL_GetTicks() / 1000.0f;
-  float deltaTime = ticks - lastTicks;
-  lastTicks = ticks;
-  return deltaTime;
-}
-
 Object::Object(glm::vec3 position, GLuint textureID)
        : position(position), textureID(textureID)
 {
@@ -243,6 +632,17 @@ float Object::getH() { return height; }
 void Object::setMoveX(float x) { movement.x = x; }
 void Object::setMoveY(float y) { movement.y = y; }
 
+void Object::save(ObjectState *out) {
+  out->position = position;
+  out->movement = movement;
+}
+
+void Object::load(const ObjectState &in) {
+  position = in.position;
+  movement = in.movement;
+  modelMatrix = glm::translate(glm::mat4(1.0f), position);
+}
+
 
 Player::Player(glm::vec3 position, GLuint textureID)
       : Object(position, textureID) { speed = 5.0f; width = 0.25f; height = 0.9f; }
@@ -268,8 +668,10 @@ void Player::checkCollisions(glm::vec3 *new_pos) {
   else if ( (*new_pos).y < -cutoff) { (*new_pos).y = -cutoff; }
 }
 
-Ball::Ball(glm::vec3 position, GLuint textureID) : Object(position, textureID) {
+Ball::Ball(glm::vec3 position, GLuint textureID, Object *left, Object *right)
+    : Object(position, textureID), left(left), right(right) {
   moving = false;
+  scored = false;
   speed = 7.0f;
   height = width = 0.2f;
 }
@@ -294,9 +696,9 @@ void Ball::checkCollisions(glm::vec3 *new_pos) {
   else if ( (*new_pos).y < -cutoff) { (*new_pos).y = -cutoff; movement.y = -movement.y; }
 
   //check if hits player
-  if (isColliding(new_pos, width, height, objs[0])) {
+  if (isColliding(new_pos, width, height, left)) {
     movement.x = 1.0f;
-  } else if (isColliding(new_pos, width, height, objs[1])) {
+  } else if (isColliding(new_pos, width, height, right)) {
     movement.x = -1.0f;
   }
 
@@ -304,10 +706,10 @@ void Ball::checkCollisions(glm::vec3 *new_pos) {
   cutoff = ORTHO_WIDTH - (width / 2);
   if ((*new_pos).x > cutoff) {
     (*new_pos).x = cutoff;
-    gameIsRunning = false;
+    scored = true;
   } else if ((*new_pos).x < -cutoff) {
     (*new_pos).x = -cutoff;
-    gameIsRunning = false;
+    scored = true;
   }
 }
 
@@ -316,6 +718,189 @@ void Ball::start() {
   movement = glm::vec3(1.0f, 0.2f, 0.0f);
 }
 
+bool Ball::hasScored() { return scored; }
+
+void Ball::save(ObjectState *out) {
+  Object::save(out);
+  out->moving = moving;
+  out->scored = scored;
+}
+
+void Ball::load(const ObjectState &in) {
+  Object::load(in);
+  moving = in.moving;
+  scored = in.scored;
+}
+
+bool Rollback::start(int localPort, int remotePort, GameState &state) {
+  if (socket.Open(localPort, remotePort) == false) { return false; }
+  frame = 0;
+  SaveState(state, &states[0]);
+  return true;
+}
+
+void Rollback::simulate(GameState &state, int f) {
+  Uint8 local = localInputs[f % NET_RING];
+  Uint8 remote;
+  if (f <= remoteFrame) {
+    remote = remoteInputs[f % NET_RING];
+  } else {
+    //they'll most likely still be holding what they last held, a serve is one press though
+    remote = remoteFrame < 0 ? 0 : remoteInputs[remoteFrame % NET_RING] & ~INPUT_SERVE;
+    remoteInputs[f % NET_RING] = remote;
+  }
+
+  Uint8 left = isLeft ? local : remote;
+  Uint8 right = isLeft ? remote : local;
+  InputFrame input;
+  input.leftMove = unpackMove(left);
+  input.rightMove = unpackMove(right);
+  input.serve = ((left | right) & INPUT_SERVE) != 0;
+  Step(state, input, FIXED_TIMESTEP);
+  SaveState(state, &states[(f + 1) % NET_RING]);
+}
+
+void Rollback::receive(const Uint8 *data, int size) {
+  NetPacket packet;
+  if (size < (int)sizeof(packet)) { return; }
+  memcpy(&packet, data, sizeof(packet));
+  if (memcmp(packet.magic, "PONG", 4) != 0 || packet.count < 0 || size < (int)sizeof(packet) + packet.count) { return; }
+  const Uint8 *inputs = data + sizeof(packet);
+
+  connected = true;
+  packetsReceived++;
+  if (packet.ack > peerAck) { peerAck = packet.ack; }
+  if (packet.frame > peerFrame) {
+    peerFrame = packet.frame;
+    peerAdvantage = packet.frame - packet.ack;
+  }
+  if (packet.checkFrame > peerCheckFrame) {
+    peerCheckFrame = packet.checkFrame;
+    peerChecksum = packet.checksum;
+  }
+
+  for (int i = 0; i < packet.count; i++) {
+    int f = packet.start + i;
+    if (f <= remoteFrame) { continue; }
+    //packets can come out of order, input is only taken without gaps, the rest comes again
+    //and input too far ahead would land on ring slots still in use
+    if (f != remoteFrame + 1 || f >= frame + NET_RING / 2) { break; }
+    if (f < frame && remoteInputs[f % NET_RING] != inputs[i]) {
+      if (firstWrong < 0 || f < firstWrong) { firstWrong = f; }
+    }
+    remoteInputs[f % NET_RING] = inputs[i];
+    remoteFrame = f;
+  }
+}
+
+void Rollback::poll(GameState &state, Uint32 now) {
+  emulator.Flush(socket, now);
+  Uint8 data[sizeof(NetPacket) + NET_MAX_INPUTS];
+  int size;
+  while ((size = socket.Receive(data, sizeof(data))) >= 0) { receive(data, size); }
+
+  if (firstWrong >= 0) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    int depth = frame - firstWrong;
+    LoadState(state, states[firstWrong % NET_RING]);
+    for (int f = firstWrong; f < frame; f++) { simulate(state, f); }
+    double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    rollbacks++;
+    depthCounts[depth]++;
+    depthMs[depth] += ms;
+    if (depth > maxDepth) { maxDepth = depth; }
+    resimMs += ms;
+    if (ms > maxResimMs) { maxResimMs = ms; }
+    firstWrong = -1;
+  }
+
+  //only once we have every input up to the frame they checked, and still have its state
+  int confirmed = confirmedFrame();
+  if (peerCheckFrame > lastChecked && peerCheckFrame <= confirmed + 1 && peerCheckFrame > frame - NET_RING) {
+    if (StateChecksum(states[peerCheckFrame % NET_RING]) != peerChecksum) {
+      if (desyncs == 0) { std::cout << "net: our state doesn't match theirs at frame " << peerCheckFrame << "\n"; }
+      desyncs++;
+    }
+    checks++;
+    lastChecked = peerCheckFrame;
+  }
+
+  if (overFrame < 0 && (states[(confirmed + 1) % NET_RING].over || (frameLimit >= 0 && confirmed + 1 >= frameLimit))) {
+    overFrame = confirmed + 1;
+    overTicks = now;
+  }
+}
+
+bool Rollback::canStep() {
+  if (connected == false || overFrame >= 0 || (frameLimit >= 0 && frame >= frameLimit)) { return false; }
+  return frame - remoteFrame <= NET_MAX_ROLLBACK && frame - peerAck < NET_MAX_INPUTS;
+}
+
+//both sides see the other behind by the trip time, the difference between how far behind each
+//sees the other is twice how far ahead one of them really is
+bool Rollback::shouldWait() {
+  if (peerFrame < 0 || frame - lastWaitFrame < NET_WAIT_INTERVAL) { return false; }
+  if ((frame - remoteFrame) - peerAdvantage < 2) { return false; }
+  lastWaitFrame = frame;
+  waits++;
+  return true;
+}
+
+void Rollback::advance(GameState &state, Uint8 input) {
+  localInputs[frame % NET_RING] = input;
+  simulate(state, frame);
+  frame++;
+}
+
+void Rollback::send(Uint32 now) {
+  Uint8 data[sizeof(NetPacket) + NET_MAX_INPUTS];
+  NetPacket packet;
+  memcpy(packet.magic, "PONG", 4);
+  packet.frame = frame;
+  packet.ack = remoteFrame;
+  packet.checkFrame = confirmedFrame() + 1;
+  packet.checksum = StateChecksum(states[packet.checkFrame % NET_RING]);
+  packet.start = peerAck + 1;
+  packet.count = frame - packet.start;
+  for (int i = 0; i < packet.count; i++) { data[sizeof(packet) + i] = localInputs[(packet.start + i) % NET_RING]; }
+  memcpy(data, &packet, sizeof(packet));
+  emulator.Send(socket, data, sizeof(packet) + packet.count, now);
+  emulator.Flush(socket, now);
+}
+
+bool Rollback::isFinished(Uint32 now) {
+  if (overFrame < 0) { return false; }
+  return peerAck >= overFrame - 1 || now - overTicks >= NET_LINGER_MS;
+}
+
+void Rollback::report() {
+  if (socket.IsOpen() == false) { return; }
+
+  std::cout << "net: " << frame << " frames, " << rollbacks << " rollbacks, " << stalls << " stalled, " << waits
+            << " waited to let the other side catch up\n";
+  if (rollbacks > 0) {
+    int frames = 0;
+    for (int d = 1; d <= NET_MAX_ROLLBACK; d++) { frames += depthCounts[d] * d; }
+    std::cout << "net: rollback avg " << (double)frames / rollbacks << " frames, max " << maxDepth
+              << ", re-simulating avg " << resimMs / rollbacks << " ms, max " << maxResimMs << " ms\n";
+    for (int d = 1; d <= NET_MAX_ROLLBACK; d++) {
+      if (depthCounts[d] == 0) { continue; }
+      std::cout << "net:   " << d << " frames back: " << depthCounts[d] << " times, avg "
+                << depthMs[d] * 1000.0 / depthCounts[d] << " us\n";
+    }
+  }
+  std::cout << "net: sent " << emulator.sent << " packets, " << emulator.dropped << " dropped by the emulator, "
+            << packetsReceived << " received\n";
+  std::cout << "net: " << checks << " checksums compared, " << desyncs << " didn't match";
+  std::cout << "\n";
+  if (overFrame >= 0) {
+    std::cout << "net: over at frame " << overFrame << ", state checksum " << StateChecksum(states[overFrame % NET_RING])
+              << "\n";
+  }
+  socket.Close();
+}
+
 Texture::Texture(const char *filePath) {
   textureID = loadTexture(filePath);
 }
@@ -0,0 +1,123 @@
+#include "AabbBatch.h"
+
+#include <SDL.h>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AABB_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+//gcc and clang only emit avx inside functions marked for it, msvc always can
+#if defined(_MSC_VER)
+#define AABB_AVX2 1
+#define AABB_AVX2_TARGET
+#elif defined(__GNUC__)
+#define AABB_AVX2 1
+#define AABB_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+typedef int (*OverlapFunction)(float, float, float, float, const float *, const float *, const float *, const float *, int);
+
+//same sums in the same order as the vector paths, so every path gives the same bits
+static int OverlapScalar(float x, float y, float halfWidth, float halfHeight, const float *xs, const float *ys,
+                         const float *halfWidths, const float *halfHeights, int first, int count) {
+  int mask = 0;
+  for (int i = first; i < count; i++) {
+    float xdist = std::fabs(x - xs[i]) - (halfWidth + halfWidths[i]);
+    float ydist = std::fabs(y - ys[i]) - (halfHeight + halfHeights[i]);
+    mask |= (int)(xdist < 0 && ydist < 0) << i;
+  }
+  return mask;
+}
+
+static int OverlapPlain(float x, float y, float halfWidth, float halfHeight, const float *xs, const float *ys,
+                        const float *halfWidths, const float *halfHeights, int count) {
+  return OverlapScalar(x, y, halfWidth, halfHeight, xs, ys, halfWidths, halfHeights, 0, count);
+}
+
+#ifdef AABB_SSE2
+static int OverlapSSE2(float x, float y, float halfWidth, float halfHeight, const float *xs, const float *ys,
+                       const float *halfWidths, const float *halfHeights, int count) {
+  __m128 boxX = _mm_set1_ps(x);
+  __m128 boxY = _mm_set1_ps(y);
+  __m128 boxHalfWidth = _mm_set1_ps(halfWidth);
+  __m128 boxHalfHeight = _mm_set1_ps(halfHeight);
+  __m128 sign = _mm_set1_ps(-0.0f);
+  __m128 zero = _mm_setzero_ps();
+
+  int mask = 0;
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 xdist = _mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(boxX, _mm_loadu_ps(xs + i))),
+                              _mm_add_ps(boxHalfWidth, _mm_loadu_ps(halfWidths + i)));
+    __m128 ydist = _mm_sub_ps(_mm_andnot_ps(sign, _mm_sub_ps(boxY, _mm_loadu_ps(ys + i))),
+                              _mm_add_ps(boxHalfHeight, _mm_loadu_ps(halfHeights + i)));
+    __m128 hit = _mm_and_ps(_mm_cmplt_ps(xdist, zero), _mm_cmplt_ps(ydist, zero));
+    mask |= _mm_movemask_ps(hit) << i;
+  }
+  return mask | OverlapScalar(x, y, halfWidth, halfHeight, xs, ys, halfWidths, halfHeights, i, count);
+}
+#endif
+
+#ifdef AABB_AVX2
+AABB_AVX2_TARGET
+static int OverlapAVX2(float x, float y, float halfWidth, float halfHeight, const float *xs, const float *ys,
+                       const float *halfWidths, const float *halfHeights, int count) {
+  __m256 boxX = _mm256_set1_ps(x);
+  __m256 boxY = _mm256_set1_ps(y);
+  __m256 boxHalfWidth = _mm256_set1_ps(halfWidth);
+  __m256 boxHalfHeight = _mm256_set1_ps(halfHeight);
+  __m256 sign = _mm256_set1_ps(-0.0f);
+  __m256 zero = _mm256_setzero_ps();
+
+  int mask = 0;
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 xdist = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(boxX, _mm256_loadu_ps(xs + i))),
+                                 _mm256_add_ps(boxHalfWidth, _mm256_loadu_ps(halfWidths + i)));
+    __m256 ydist = _mm256_sub_ps(_mm256_andnot_ps(sign, _mm256_sub_ps(boxY, _mm256_loadu_ps(ys + i))),
+                                 _mm256_add_ps(boxHalfHeight, _mm256_loadu_ps(halfHeights + i)));
+    __m256 hit = _mm256_and_ps(_mm256_cmp_ps(xdist, zero, _CMP_LT_OQ), _mm256_cmp_ps(ydist, zero, _CMP_LT_OQ));
+    mask |= _mm256_movemask_ps(hit) << i;
+  }
+  //a leftover 4 still goes wide, then whatever is under that
+  return mask | (OverlapSSE2(x, y, halfWidth, halfHeight, xs + i, ys + i, halfWidths + i, halfHeights + i, count - i) << i);
+}
+#endif
+
+static const char *overlapPath = "plain";
+
+static OverlapFunction PickOverlap() {
+  OverlapFunction picked = OverlapPlain;
+#ifdef AABB_SSE2
+  if (SDL_HasSSE2()) {
+    picked = OverlapSSE2;
+    overlapPath = "sse2";
+  }
+#endif
+#ifdef AABB_AVX2
+  if (SDL_HasAVX2()) {
+    picked = OverlapAVX2;
+    overlapPath = "avx2";
+  }
+#endif
+  return picked;
+}
+
+//a function static is only set up once even if several threads get here first
+static OverlapFunction Overlap() {
+  static OverlapFunction overlap = PickOverlap();
+  return overlap;
+}
+
+int AabbOverlap(float x, float y, float halfWidth, float halfHeight,
+                const float *xs, const float *ys, const float *halfWidths, const float *halfHeights, int count) {
+  if (count > AABB_BATCH) { count = AABB_BATCH; }
+  return Overlap()(x, y, halfWidth, halfHeight, xs, ys, halfWidths, halfHeights, count);
+}
+
+const char *AabbOverlapPath() {
+  Overlap();
+  return overlapPath;
+}
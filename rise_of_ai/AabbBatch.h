@@ -0,0 +1,13 @@
+#pragma once
+
+//boxes tested per call, callers walk longer lists in blocks of this
+#define AABB_BATCH 16
+
+//tests one box against up to 16 others given as columns of centres and half extents, bit i of
+//the result is set when box i overlaps, touching edges don't count
+//picks avx2, sse2 or plain code the first time it is called depending on the cpu
+int AabbOverlap(float x, float y, float halfWidth, float halfHeight,
+                const float *xs, const float *ys, const float *halfWidths, const float *halfHeights, int count);
+
+//which of the above is in use, for reports
+const char *AabbOverlapPath();
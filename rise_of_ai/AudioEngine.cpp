@@ -0,0 +1,264 @@
+#include "AudioEngine.h"
+
+#include <cstring>
+#include <iostream>
+
+bool AudioEngine::Open() {
+  SDL_AudioSpec want;
+  SDL_zero(want);
+  want.freq = AUDIO_FREQUENCY;
+  want.format = AUDIO_F32SYS;
+  want.channels = 2;
+  want.samples = AUDIO_SAMPLES;
+  want.callback = Callback;
+  want.userdata = this;
+
+  //no allowed changes, sdl converts from float stereo if the hardware wants something else
+  device = SDL_OpenAudioDevice(NULL, 0, &want, &spec, 0);
+  if (device == 0) {
+    std::cout << "Unable to open audio device: " << SDL_GetError() << "\n";
+    return false;
+  }
+
+  isOpen = true;
+  music.Start(spec.freq);
+  SDL_PauseAudioDevice(device, 0);
+  return true;
+}
+
+//returns the sound's index for Play, or -1
+int AudioEngine::LoadSound(const char *path, int maxVoices, int priority) {
+  int index = soundCount.load(std::memory_order_relaxed);
+  if (isOpen == false || index == AUDIO_SOUNDS) { return -1; }
+
+  SDL_AudioSpec wavSpec;
+  Uint8 *wavData;
+  Uint32 wavLength;
+  if (SDL_LoadWAV(path, &wavSpec, &wavData, &wavLength) == NULL) {
+    std::cout << "Unable to load sound " << path << ": " << SDL_GetError() << "\n";
+    return -1;
+  }
+
+  //decode to mono floats at the device rate now so the callback only ever adds
+  SDL_AudioCVT cvt;
+  SDL_BuildAudioCVT(&cvt, wavSpec.format, wavSpec.channels, wavSpec.freq, AUDIO_F32SYS, 1, spec.freq);
+  cvt.len = wavLength;
+  cvt.buf = (Uint8 *)SDL_malloc(wavLength * cvt.len_mult);
+  memcpy(cvt.buf, wavData, wavLength);
+  SDL_FreeWAV(wavData);
+  if (cvt.needed) {
+    SDL_ConvertAudio(&cvt);
+  } else {
+    cvt.len_cvt = cvt.len;
+  }
+
+  Sound &sound = sounds[index];
+  sound.samples = (float *)cvt.buf;
+  sound.length = cvt.len_cvt / sizeof(float);
+  sound.maxVoices = maxVoices;
+  sound.priority = priority;
+
+  //published after the sound is filled in, the callback never looks past soundCount
+  soundCount.store(index + 1, std::memory_order_release);
+  return index;
+}
+
+//returns an id for Stop, 0 if nothing was queued
+Uint32 AudioEngine::Play(int sound, float volume, float pan) {
+  if (isOpen == false || sound < 0) { return 0; }
+
+  AudioCommand command;
+  command.type = AUDIO_PLAY;
+  command.sound = sound;
+  command.voiceID = nextVoiceID++;
+  command.volume = volume;
+  command.pan = pan < -1.0f ? -1.0f : (pan > 1.0f ? 1.0f : pan);
+  if (commands.Push(command) == false) {
+    droppedCommands++;
+    return 0;
+  }
+  return command.voiceID;
+}
+
+void AudioEngine::Stop(Uint32 voiceID) {
+  if (isOpen == false || voiceID == 0) { return; }
+
+  AudioCommand command;
+  command.type = AUDIO_STOP;
+  command.voiceID = voiceID;
+  if (commands.Push(command) == false) { droppedCommands++; }
+}
+
+void AudioEngine::StopAll() {
+  if (isOpen == false) { return; }
+
+  AudioCommand command;
+  command.type = AUDIO_STOP_ALL;
+  if (commands.Push(command) == false) { droppedCommands++; }
+}
+
+void AudioEngine::Close() {
+  if (isOpen == false) { return; }
+
+  //waits for a running callback to finish
+  SDL_CloseAudioDevice(device);
+  isOpen = false;
+  music.Close();
+  for (int i = 0; i < soundCount; i++) { SDL_free(sounds[i].samples); }
+  soundCount = 0;
+}
+
+void AudioEngine::Callback(void *userdata, Uint8 *stream, int length) {
+  AudioEngine *engine = (AudioEngine *)userdata;
+  Uint64 start = SDL_GetPerformanceCounter();
+  Uint64 frequency = SDL_GetPerformanceFrequency();
+  int frames = length / (int)(sizeof(float) * 2);
+
+  //sdl doesn't report underruns, a gap of more than one and a half buffers since the last
+  //callback means the device most likely ran dry waiting on us
+  Uint64 bufferTicks = (Uint64)frames * frequency / engine->spec.freq;
+  if (engine->lastCallback != 0 && start - engine->lastCallback > bufferTicks * 3 / 2) {
+    engine->underruns++;
+  }
+  engine->lastCallback = start;
+
+  engine->RunCommands();
+  engine->Mix((float *)stream, frames);
+
+  Uint64 ticks = SDL_GetPerformanceCounter() - start;
+  engine->callbackTicks += ticks;
+  if (ticks > engine->maxCallbackTicks) { engine->maxCallbackTicks = ticks; }
+  engine->callbacks++;
+}
+
+void AudioEngine::RunCommands() {
+  AudioCommand command;
+  while (commands.Pop(&command)) {
+    switch (command.type) {
+      case AUDIO_PLAY:
+        StartVoice(command);
+        break;
+      case AUDIO_STOP:
+        for (int v = 0; v < AUDIO_VOICES; v++) {
+          if (voices[v].id == command.voiceID) { voices[v].sound = -1; }
+        }
+        break;
+      case AUDIO_STOP_ALL:
+        for (int v = 0; v < AUDIO_VOICES; v++) { voices[v].sound = -1; }
+        break;
+    }
+  }
+}
+
+void AudioEngine::StartVoice(const AudioCommand &command) {
+  if (command.sound >= soundCount.load(std::memory_order_acquire)) { return; }
+  const Sound &sound = sounds[command.sound];
+
+  int slot = -1;
+  int same = 0;
+  int oldestSame = -1;
+  for (int v = 0; v < AUDIO_VOICES; v++) {
+    if (voices[v].sound == command.sound) {
+      same++;
+      if (oldestSame < 0 || voices[v].position > voices[oldestSame].position) { oldestSame = v; }
+    } else if (voices[v].sound < 0 && slot < 0) {
+      slot = v;
+    }
+  }
+
+  if (same >= sound.maxVoices) {
+    //too many of this sound already, cut off the one that's furthest along
+    slot = oldestSame;
+    steals++;
+  } else if (slot < 0) {
+    //every voice is busy, take the lowest priority one that's furthest along
+    for (int v = 0; v < AUDIO_VOICES; v++) {
+      const Sound &playing = sounds[voices[v].sound];
+      if (playing.priority > sound.priority) { continue; }
+      if (slot < 0) { slot = v; continue; }
+      const Sound &best = sounds[voices[slot].sound];
+      if (playing.priority < best.priority ||
+          (playing.priority == best.priority && voices[v].position > voices[slot].position)) {
+        slot = v;
+      }
+    }
+    if (slot < 0) { return; }
+    steals++;
+  }
+
+  Voice &voice = voices[slot];
+  voice.sound = command.sound;
+  voice.id = command.voiceID;
+  voice.position = 0;
+  voice.gainLeft = command.volume * (command.pan > 0.0f ? 1.0f - command.pan : 1.0f);
+  voice.gainRight = command.volume * (command.pan < 0.0f ? 1.0f + command.pan : 1.0f);
+}
+
+void AudioEngine::Mix(float *out, int frames) {
+  memset(out, 0, frames * 2 * sizeof(float));
+
+  int active = 0;
+  for (int v = 0; v < AUDIO_VOICES; v++) {
+    Voice &voice = voices[v];
+    if (voice.sound < 0) { continue; }
+
+    const Sound &sound = sounds[voice.sound];
+    const float *source = sound.samples + voice.position;
+    int count = sound.length - voice.position;
+    if (count > frames) { count = frames; }
+
+    int i = 0;
+#ifdef AUDIO_SSE2
+    //4 mono samples become 4 stereo frames, interleaved as l0 r0 l1 r1 | l2 r2 l3 r3
+    __m128 gainLeft = _mm_set1_ps(voice.gainLeft);
+    __m128 gainRight = _mm_set1_ps(voice.gainRight);
+    for (; i + 4 <= count; i += 4) {
+      __m128 samples = _mm_loadu_ps(source + i);
+      __m128 left = _mm_mul_ps(samples, gainLeft);
+      __m128 right = _mm_mul_ps(samples, gainRight);
+      float *frame = out + i * 2;
+      _mm_storeu_ps(frame, _mm_add_ps(_mm_loadu_ps(frame), _mm_unpacklo_ps(left, right)));
+      _mm_storeu_ps(frame + 4, _mm_add_ps(_mm_loadu_ps(frame + 4), _mm_unpackhi_ps(left, right)));
+    }
+#endif
+    for (; i < count; i++) {
+      out[i * 2] += source[i] * voice.gainLeft;
+      out[i * 2 + 1] += source[i] * voice.gainRight;
+    }
+
+    voice.position += count;
+    if (voice.position >= sound.length) {
+      voice.sound = -1;
+    } else {
+      active++;
+    }
+  }
+  activeVoices.store(active, std::memory_order_relaxed);
+
+  music.Mix(out, frames);
+
+  //keep the sum in range so a pile of explosions clips instead of wrapping
+  int i = 0;
+#ifdef AUDIO_SSE2
+  __m128 low = _mm_set1_ps(-1.0f);
+  __m128 high = _mm_set1_ps(1.0f);
+  for (; i + 4 <= frames * 2; i += 4) {
+    _mm_storeu_ps(out + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(out + i), low), high));
+  }
+#endif
+  for (; i < frames * 2; i++) {
+    if (out[i] < -1.0f) { out[i] = -1.0f; }
+    if (out[i] > 1.0f) { out[i] = 1.0f; }
+  }
+}
+
+void AudioEngine::Report() {
+  if (callbacks == 0) { return; }
+
+  double frequency = (double)SDL_GetPerformanceFrequency();
+  std::cout << "audio: " << callbacks << " callbacks, avg " << callbackTicks * 1000.0 / frequency / callbacks
+            << " ms, max " << maxCallbackTicks * 1000.0 / frequency << " ms of a "
+            << spec.samples * 1000.0 / spec.freq << " ms buffer, " << underruns << " underruns, "
+            << steals << " voices stolen, " << droppedCommands << " commands dropped\n";
+  music.Report();
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <atomic>
+
+#include "MusicStream.h"
+#include "SpscQueue.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#define AUDIO_FREQUENCY 44100
+//frames per callback, about 11.6 ms at 44100
+#define AUDIO_SAMPLES 512
+#define AUDIO_VOICES 32
+#define AUDIO_SOUNDS 16
+#define AUDIO_COMMANDS 256
+
+//decoded once at load into mono floats at the device rate
+struct Sound {
+    float *samples = NULL;
+    int length = 0;
+    //more than this many at once and the oldest one is cut off
+    int maxVoices = AUDIO_VOICES;
+    //when every voice is busy, lower priority voices get taken first
+    int priority = 0;
+};
+
+enum AudioCommandType { AUDIO_PLAY, AUDIO_STOP, AUDIO_STOP_ALL };
+
+struct AudioCommand {
+    AudioCommandType type;
+    int sound;
+    Uint32 voiceID;
+    float volume;
+    float pan;
+};
+
+struct Voice {
+    int sound = -1;
+    Uint32 id = 0;
+    int position = 0;
+    float gainLeft = 0.0f;
+    float gainRight = 0.0f;
+};
+
+//the game thread only pushes commands, all voice state belongs to the audio callback
+class AudioEngine {
+public:
+    bool isOpen = false;
+
+    //streamed background music, mixed under the effects
+    MusicPlayer music;
+
+    //written by the callback, safe to read from the game thread
+    std::atomic<int> callbacks{ 0 };
+    std::atomic<int> underruns{ 0 };
+    std::atomic<int> steals{ 0 };
+    std::atomic<int> activeVoices{ 0 };
+    std::atomic<Uint64> callbackTicks{ 0 };
+    std::atomic<Uint64> maxCallbackTicks{ 0 };
+
+    //commands that didn't fit in the queue, game thread only
+    int droppedCommands = 0;
+
+    bool Open();
+    int LoadSound(const char *path, int maxVoices, int priority);
+    Uint32 Play(int sound, float volume, float pan);
+    void Stop(Uint32 voiceID);
+    void StopAll();
+    void Close();
+    void Report();
+
+private:
+    SDL_AudioDeviceID device = 0;
+    SDL_AudioSpec spec;
+
+    Sound sounds[AUDIO_SOUNDS];
+    std::atomic<int> soundCount{ 0 };
+
+    SpscQueue<AudioCommand, AUDIO_COMMANDS> commands;
+    Uint32 nextVoiceID = 1;
+
+    //callback only
+    Voice voices[AUDIO_VOICES];
+    Uint64 lastCallback = 0;
+
+    static void Callback(void *userdata, Uint8 *stream, int length);
+    void RunCommands();
+    void StartVoice(const AudioCommand &command);
+    void Mix(float *out, int frames);
+};
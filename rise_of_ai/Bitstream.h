@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+//bits packed into bytes lowest bit first, for data that mostly needs far less than a byte
+class BitWriter {
+public:
+    std::vector<uint8_t> bytes;
+    uint32_t bitCount = 0;
+
+    //the low bits of value, up to 32
+    void Write(uint32_t value, int bits) {
+        for (int i = 0; i < bits; i++) {
+            if ((bitCount & 7) == 0) { bytes.push_back(0); }
+            if ((value >> i) & 1) { bytes.back() |= (uint8_t)(1 << (bitCount & 7)); }
+            bitCount++;
+        }
+    }
+};
+
+class BitReader {
+public:
+    const uint8_t *bytes = NULL;
+    uint32_t bitCount = 0;
+    uint32_t position = 0;
+    //set once a read goes past bitCount, the bits past the end read as 0
+    bool overrun = false;
+
+    void Setup(const uint8_t *bytes, uint32_t bitCount, uint32_t position = 0) {
+        this->bytes = bytes;
+        this->bitCount = bitCount;
+        this->position = position;
+        overrun = false;
+    }
+
+    uint32_t Read(int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++) {
+            if (position >= bitCount) {
+                overrun = true;
+                return value;
+            }
+            if ((bytes[position >> 3] >> (position & 7)) & 1) { value |= (uint32_t)1 << i; }
+            position++;
+        }
+        return value;
+    }
+};
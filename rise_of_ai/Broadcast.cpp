@@ -0,0 +1,378 @@
+#include "Broadcast.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const char BROADCAST_MAGIC[4] = { 'R', 'A', 'I', 'B' };
+static const char ACK_MAGIC[4] = { 'R', 'A', 'I', 'A' };
+
+//the flags a spectator can show something for
+#define BROADCAST_FLAGS (ENTITY_ACTIVE | ENTITY_FIRED | ENTITY_HIT | ENTITY_DIED)
+#define BROADCAST_FLAG_BITS 6
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static int16_t Clamp16(long value) {
+  if (value > INT16_MAX) { return INT16_MAX; }
+  if (value < INT16_MIN) { return INT16_MIN; }
+  return (int16_t)value;
+}
+
+static int16_t Quantize(SimReal value) {
+  return Clamp16(std::lround(ToFloat(value) * BROADCAST_QUANTUM));
+}
+
+static void Capture(GameState &state, bool bossText, int tick, BroadcastFrame *frame) {
+  EntityStore &entities = state.entities;
+  frame->tick = tick;
+  frame->mode = (Uint8)state.mode;
+  frame->bossText = bossText ? 1 : 0;
+  frame->rows.resize(entities.count);
+  for (int i = 0; i < entities.count; i++) {
+    BroadcastEntity row = {};
+    if (entities.flags[i] & ENTITY_ACTIVE) {
+      row.x = Quantize(entities.x[i]);
+      row.y = Quantize(entities.y[i]);
+      row.health = Clamp16(entities.health[i]);
+      row.flags = entities.flags[i] & BROADCAST_FLAGS;
+    }
+    frame->rows[i] = row;
+  }
+}
+
+//fnv-1a over the fields, the same on both ends whatever the padding in BroadcastEntity
+static uint32_t Checksum(const BroadcastFrame &frame) {
+  uint32_t hash = 2166136261u;
+  Uint8 modeBytes[2] = { frame.mode, frame.bossText };
+  for (int k = 0; k < 2; k++) { hash = (hash ^ modeBytes[k]) * 16777619u; }
+  for (size_t i = 0; i < frame.rows.size(); i++) {
+    const BroadcastEntity &row = frame.rows[i];
+    int16_t values[3] = { row.x, row.y, row.health };
+    const Uint8 *bytes = (const Uint8 *)values;
+    for (size_t k = 0; k < sizeof(values); k++) { hash = (hash ^ bytes[k]) * 16777619u; }
+    hash = (hash ^ row.flags) * 16777619u;
+  }
+  return hash;
+}
+
+//a step's move is a few quanta, so a value close to the one before is 8 bits and anything
+//else the full 17
+static void WriteValue(BitWriter &bits, int value, int base) {
+  int delta = value - base;
+  if (delta >= -64 && delta < 64) {
+    bits.Write(0, 1);
+    bits.Write((uint32_t)(delta + 64), 7);
+  } else {
+    bits.Write(1, 1);
+    bits.Write((uint16_t)value, 16);
+  }
+}
+
+static int16_t ReadValue(BitReader &bits, int base) {
+  if (bits.Read(1) == 0) { return (int16_t)(base + (int)bits.Read(7) - 64); }
+  return (int16_t)bits.Read(16);
+}
+
+//a row is a 0 bit when it is the same as in the base, otherwise a 1 bit and a changed bit and
+//value for each field that differs
+static void WriteRow(BitWriter &bits, const BroadcastEntity &row, const BroadcastEntity &base) {
+  bool sameX = row.x == base.x;
+  bool sameY = row.y == base.y;
+  bool sameHealth = row.health == base.health;
+  bool sameFlags = row.flags == base.flags;
+  if (sameX && sameY && sameHealth && sameFlags) {
+    bits.Write(0, 1);
+    return;
+  }
+  bits.Write(1, 1);
+  bits.Write(sameX ? 0 : 1, 1);
+  if (sameX == false) { WriteValue(bits, row.x, base.x); }
+  bits.Write(sameY ? 0 : 1, 1);
+  if (sameY == false) { WriteValue(bits, row.y, base.y); }
+  bits.Write(sameHealth ? 0 : 1, 1);
+  if (sameHealth == false) { WriteValue(bits, row.health, base.health); }
+  bits.Write(sameFlags ? 0 : 1, 1);
+  if (sameFlags == false) { bits.Write(row.flags, BROADCAST_FLAG_BITS); }
+}
+
+static void ReadRow(BitReader &bits, BroadcastEntity *row) {
+  if (bits.Read(1) == 0) { return; }
+  if (bits.Read(1) == 1) { row->x = ReadValue(bits, row->x); }
+  if (bits.Read(1) == 1) { row->y = ReadValue(bits, row->y); }
+  if (bits.Read(1) == 1) { row->health = ReadValue(bits, row->health); }
+  if (bits.Read(1) == 1) { row->flags = (Uint8)bits.Read(BROADCAST_FLAG_BITS); }
+}
+
+bool BroadcastServer::Start(int port) {
+  if (socket.Open(port) == false) { return false; }
+  isRunning = true;
+  return true;
+}
+
+void BroadcastServer::ReadAcks(Uint32 now) {
+  Uint8 data[BROADCAST_PACKET_BYTES];
+  int from;
+  int size;
+  while ((size = socket.Receive(data, sizeof(data), &from)) >= 0) {
+    BroadcastAck ack;
+    if (size < (int)sizeof(ack)) { continue; }
+    memcpy(&ack, data, sizeof(ack));
+    if (memcmp(ack.magic, ACK_MAGIC, 4) != 0) { continue; }
+
+    Viewer *viewer = NULL;
+    for (size_t i = 0; i < viewers.size(); i++) {
+      if (viewers[i].port == from) { viewer = &viewers[i]; }
+    }
+    if (viewer == NULL) {
+      if (viewers.size() >= BROADCAST_MAX_VIEWERS) { continue; }
+      Viewer joined;
+      joined.port = from;
+      joined.ackTick = -1;
+      viewers.push_back(joined);
+      viewer = &viewers.back();
+    }
+    //acks can come out of order, only a newer one moves the base on
+    if (ack.tick > viewer->ackTick && ack.tick < tick) { viewer->ackTick = ack.tick; }
+    viewer->lastHeard = now;
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < viewers.size(); i++) {
+    if (now - viewers[i].lastHeard <= BROADCAST_TIMEOUT_MS) { viewers[kept++] = viewers[i]; }
+  }
+  viewers.resize(kept);
+  if ((int)viewers.size() > mostViewers) { mostViewers = (int)viewers.size(); }
+}
+
+int BroadcastServer::Encode(const BroadcastFrame &frame, int baseTick) {
+  for (int i = 0; i < encodingCount; i++) {
+    if (encodings[i].baseTick == baseTick) { return i; }
+  }
+
+  bits.bytes.clear();
+  bits.bitCount = 0;
+  BroadcastEntity empty = {};
+  const BroadcastFrame *base = baseTick >= 0 ? &frames[baseTick % BROADCAST_HISTORY] : NULL;
+  for (size_t i = 0; i < frame.rows.size(); i++) {
+    WriteRow(bits, frame.rows[i], base != NULL ? base->rows[i] : empty);
+  }
+
+  BroadcastHeader header;
+  memcpy(header.magic, BROADCAST_MAGIC, 4);
+  header.tick = frame.tick;
+  header.baseTick = baseTick;
+  header.checksum = Checksum(frame);
+  header.rowCount = (uint16_t)frame.rows.size();
+  header.mode = frame.mode;
+  header.bits = frame.bossText;
+
+  if (encodingCount == (int)encodings.size()) { encodings.push_back(Encoding()); }
+  Encoding &encoding = encodings[encodingCount];
+  encoding.baseTick = baseTick;
+  encoding.bytes.resize(sizeof(header) + bits.bytes.size());
+  memcpy(encoding.bytes.data(), &header, sizeof(header));
+  if (bits.bytes.empty() == false) { memcpy(encoding.bytes.data() + sizeof(header), bits.bytes.data(), bits.bytes.size()); }
+
+  encodes++;
+  if (baseTick < 0) { fullFrames++; }
+  else { deltaFrames++; }
+  return encodingCount++;
+}
+
+void BroadcastServer::Send(GameState &state, bool bossText) {
+  if (isRunning == false) { return; }
+
+  ReadAcks(SDL_GetTicks());
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  BroadcastFrame &frame = frames[tick % BROADCAST_HISTORY];
+  Capture(state, bossText, tick, &frame);
+
+  //one coding per tick acked, most of the time that is one for everybody
+  encodingCount = 0;
+  chosen.resize(viewers.size());
+  for (size_t i = 0; i < viewers.size(); i++) {
+    int baseTick = viewers[i].ackTick;
+    if (baseTick < 0 || baseTick <= tick - BROADCAST_HISTORY || frames[baseTick % BROADCAST_HISTORY].tick != baseTick) { baseTick = -1; }
+    chosen[i] = Encode(frame, baseTick);
+  }
+  encodeMs += ElapsedMs(start);
+
+  //spectators read one packet into BROADCAST_PACKET_BYTES, a bigger one would be cut short and
+  //never decode, so rather than send frames nobody can show the broadcast ends here
+  for (int e = 0; e < encodingCount; e++) {
+    if (encodings[e].bytes.size() > BROADCAST_PACKET_BYTES) {
+      std::cout << "broadcast: tick " << tick << " codes to " << encodings[e].bytes.size() << " bytes, more than the "
+                << BROADCAST_PACKET_BYTES << " a packet holds, the level has too many rows to broadcast, stopping\n";
+      Stop();
+      return;
+    }
+  }
+
+  start = SDL_GetPerformanceCounter();
+  for (size_t i = 0; i < viewers.size(); i++) {
+    const Encoding &encoding = encodings[chosen[i]];
+    socket.SendTo(viewers[i].port, encoding.bytes.data(), (int)encoding.bytes.size());
+    packetsSent++;
+    bytesSent += encoding.bytes.size();
+  }
+  sendMs += ElapsedMs(start);
+
+  viewerTicks += viewers.size();
+  ticks++;
+  tick++;
+}
+
+void BroadcastServer::Stop() {
+  if (isRunning == false) { return; }
+
+  BroadcastHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BROADCAST_MAGIC, 4);
+  header.tick = tick;
+  header.baseTick = -1;
+  header.bits = 2;
+  //it may get lost like any other packet, so it goes a few times
+  for (int k = 0; k < 3; k++) {
+    for (size_t i = 0; i < viewers.size(); i++) { socket.SendTo(viewers[i].port, (const Uint8 *)&header, sizeof(header)); }
+  }
+  socket.Close();
+  isRunning = false;
+}
+
+void BroadcastServer::Report() {
+  if (ticks == 0) { return; }
+
+  std::cout << "broadcast: " << ticks << " ticks to at most " << mostViewers << " viewers, " << encodes << " codings ("
+            << fullFrames << " full, " << deltaFrames << " delta) for " << packetsSent << " packets, "
+            << (encodes > 0 ? (double)packetsSent / encodes : 0.0) << " viewers per coding\n";
+  if (viewerTicks > 0.0) {
+    double bytesPerTick = bytesSent / viewerTicks;
+    std::cout << "broadcast: per viewer avg " << bytesPerTick << " bytes per tick, "
+              << bytesPerTick * 8.0 / FIXED_TIMESTEP / 1000.0 << " kbit/s, " << (encodeMs + sendMs) * 1000.0 / viewerTicks
+              << " us of cpu per tick\n";
+  }
+  std::cout << "broadcast: coding avg " << encodeMs * 1000.0 / ticks << " us per tick, sending avg "
+            << sendMs * 1000.0 / ticks << " us per tick\n";
+}
+
+bool BroadcastViewer::Start(int localPort, int serverPort) {
+  if (socket.Open(localPort) == false) { return false; }
+  this->serverPort = serverPort;
+  isWatching = true;
+  Ack(-1);
+  return true;
+}
+
+void BroadcastViewer::Ack(int tick) {
+  BroadcastAck ack;
+  memcpy(ack.magic, ACK_MAGIC, 4);
+  ack.tick = tick;
+  socket.SendTo(serverPort, (const Uint8 *)&ack, sizeof(ack));
+  lastAck = SDL_GetTicks();
+}
+
+bool BroadcastViewer::Decode(const BroadcastHeader &header, const Uint8 *data, int size) {
+  const BroadcastFrame *base = NULL;
+  if (header.baseTick >= 0) {
+    base = &frames[header.baseTick % BROADCAST_HISTORY];
+    if (base->tick != header.baseTick || base->rows.size() != header.rowCount) {
+      noBaseline++;
+      return false;
+    }
+  }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  //the base is never in this slot, the server only codes against the last BROADCAST_HISTORY ticks
+  BroadcastFrame &frame = frames[header.tick % BROADCAST_HISTORY];
+  frame.tick = -1;
+  frame.rows.resize(header.rowCount);
+  BitReader bits;
+  bits.Setup(data, (uint32_t)size * 8);
+  for (int i = 0; i < header.rowCount; i++) {
+    BroadcastEntity row = {};
+    if (base != NULL) { row = base->rows[i]; }
+    ReadRow(bits, &row);
+    frame.rows[i] = row;
+  }
+  frame.mode = header.mode;
+  frame.bossText = header.bits & 1;
+  decodeMs += ElapsedMs(start);
+
+  if (bits.overrun || Checksum(frame) != header.checksum) {
+    if (mismatches == 0) { std::cout << "spectate: frame " << header.tick << " didn't decode to what was sent\n"; }
+    mismatches++;
+    return false;
+  }
+  frame.tick = header.tick;
+  return true;
+}
+
+bool BroadcastViewer::Poll(GameState &state, bool *bossText) {
+  if (isWatching == false) { return false; }
+
+  Uint32 now = SDL_GetTicks();
+  Uint8 data[BROADCAST_PACKET_BYTES];
+  int from;
+  int size;
+  bool changed = false;
+  while ((size = socket.Receive(data, sizeof(data), &from)) >= 0) {
+    BroadcastHeader header;
+    if (from != serverPort || size < (int)sizeof(header)) { continue; }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, BROADCAST_MAGIC, 4) != 0) { continue; }
+
+    if (packetsReceived == 0) { firstTicks = now; }
+    lastTicks = now;
+    packetsReceived++;
+    bytesReceived += size;
+
+    if (header.bits & 2) {
+      ended = true;
+      continue;
+    }
+    //late packets for ticks we are past are no use
+    if (header.tick <= newest) { continue; }
+    if (Decode(header, data + sizeof(header), size - (int)sizeof(header)) == false) { continue; }
+    if (newest >= 0) { missedTicks += header.tick - newest - 1; }
+    newest = header.tick;
+    changed = true;
+  }
+
+  if (changed) {
+    const BroadcastFrame &frame = frames[newest % BROADCAST_HISTORY];
+    EntityStore &entities = state.entities;
+    for (int i = 0; i < entities.count && i < (int)frame.rows.size(); i++) {
+      const BroadcastEntity &row = frame.rows[i];
+      entities.x[i] = SimReal((float)row.x / BROADCAST_QUANTUM);
+      entities.y[i] = SimReal((float)row.y / BROADCAST_QUANTUM);
+      entities.health[i] = row.health;
+      entities.flags[i] = row.flags;
+    }
+    state.mode = (GameMode)frame.mode;
+    *bossText = frame.bossText != 0;
+    framesApplied++;
+    Ack(newest);
+  } else if (now - lastAck > 500) {
+    //the join or the last ack may have been lost, and the server drops the ones it stops hearing from
+    Ack(newest);
+  }
+  return changed;
+}
+
+void BroadcastViewer::Report() {
+  if (isWatching == false) { return; }
+
+  std::cout << "spectate: " << packetsReceived << " packets, " << framesApplied << " frames shown, " << missedTicks
+            << " ticks missed, " << noBaseline << " deltas without their base, " << mismatches << " didn't decode\n";
+  double seconds = (lastTicks - firstTicks) / 1000.0;
+  if (packetsReceived > 0) {
+    std::cout << "spectate: avg " << bytesReceived / packetsReceived << " bytes per packet";
+    if (seconds > 0.0) { std::cout << ", " << bytesReceived * 8.0 / seconds / 1000.0 << " kbit/s"; }
+    std::cout << ", decoding avg " << decodeMs * 1000.0 / packetsReceived << " us\n";
+  }
+  socket.Close();
+}
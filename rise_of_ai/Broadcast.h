@@ -0,0 +1,151 @@
+#pragma once
+
+#include "Simulation.h"
+#include "Bitstream.h"
+#include "Net.h"
+
+#include <cstdint>
+#include <vector>
+
+//ticks of frames the server keeps to code deltas against, a spectator whose last ack is older
+//than this gets a full frame
+#define BROADCAST_HISTORY 32
+//spectators one server sends to
+#define BROADCAST_MAX_VIEWERS 64
+//a spectator that hasn't acked for this long has gone
+#define BROADCAST_TIMEOUT_MS 3000
+//positions are sent in steps of 1 / BROADCAST_QUANTUM units, finer than a pixel at 640x480
+#define BROADCAST_QUANTUM 64.0f
+//biggest packet either end sends, and what both read into, a frame that codes to more isn't sent
+#define BROADCAST_PACKET_BYTES 2048
+
+//one row as spectators see it, inactive rows are all zero so they never change
+//x and y are in quanta, health is whole points as the game keeps it
+struct BroadcastEntity {
+    int16_t x;
+    int16_t y;
+    int16_t health;
+    Uint8 flags;
+};
+
+//what a spectator needs to draw one step
+struct BroadcastFrame {
+    int tick = -1;
+    Uint8 mode = PLAYING;
+    Uint8 bossText = 0;
+    std::vector<BroadcastEntity> rows;
+};
+
+//every packet from the server is this followed by the frame coded against baseTick, or against
+//nothing when baseTick is -1, fields are little endian like the replay files
+struct BroadcastHeader {
+    char magic[4];
+    int32_t tick;
+    int32_t baseTick;
+    //of the whole frame, so a spectator knows its decode came out right
+    uint32_t checksum;
+    uint16_t rowCount;
+    uint8_t mode;
+    //bit 0 the boss health is showing, bit 1 the broadcast is over
+    uint8_t bits;
+};
+
+//from a spectator, the newest tick it has decoded, -1 to ask to join
+struct BroadcastAck {
+    char magic[4];
+    int32_t tick;
+};
+
+//sends every step to any number of spectators on this machine, who draw it without running
+//the simulation
+//a frame is coded against the last one a spectator acked, the rows that didn't move cost a bit,
+//and spectators that acked the same tick share one coded buffer, so with everyone keeping up
+//a step is coded once however many are watching
+class BroadcastServer {
+public:
+    bool isRunning = false;
+
+    int ticks = 0;
+    int fullFrames = 0;
+    int deltaFrames = 0;
+    //codings made, and packets sent from them
+    int encodes = 0;
+    int packetsSent = 0;
+    double bytesSent = 0.0;
+    int mostViewers = 0;
+    double encodeMs = 0.0;
+    double sendMs = 0.0;
+
+    bool Start(int port);
+    //call after every step, reads the acks that came in and sends the step out
+    //a step too big for one packet stops the broadcast, with the reason printed
+    void Send(GameState &state, bool bossText);
+    //tells the spectators there is nothing more coming
+    void Stop();
+    void Report();
+
+private:
+    struct Viewer {
+        int port;
+        int ackTick;
+        Uint32 lastHeard;
+    };
+
+    //one coding of this tick's frame, for the spectators that acked baseTick
+    struct Encoding {
+        int baseTick;
+        std::vector<Uint8> bytes;
+    };
+
+    UdpSocket socket;
+    std::vector<Viewer> viewers;
+    BroadcastFrame frames[BROADCAST_HISTORY];
+    std::vector<Encoding> encodings;
+    int tick = 0;
+    //sum over ticks of viewers sent to, for the per viewer numbers
+    double viewerTicks = 0.0;
+    //codings made this tick, the first encodingCount of encodings, reused from tick to tick
+    int encodingCount = 0;
+    //which coding each viewer gets this tick
+    std::vector<int> chosen;
+    BitWriter bits;
+
+    void ReadAcks(Uint32 now);
+    int Encode(const BroadcastFrame &frame, int baseTick);
+};
+
+//watches a BroadcastServer, each frame that comes in is decoded against the one it was coded
+//against and copied into a state that is only drawn
+class BroadcastViewer {
+public:
+    bool isWatching = false;
+    //the server said it was done
+    bool ended = false;
+
+    int packetsReceived = 0;
+    int framesApplied = 0;
+    //ticks that never came, deltas against frames we didn't have, and checksums that didn't match
+    int missedTicks = 0;
+    int noBaseline = 0;
+    int mismatches = 0;
+    double bytesReceived = 0.0;
+    double decodeMs = 0.0;
+    Uint32 firstTicks = 0;
+    Uint32 lastTicks = 0;
+
+    bool Start(int localPort, int serverPort);
+    //reads what has arrived, applies the newest frame to state and acks it
+    //true when state changed
+    bool Poll(GameState &state, bool *bossText);
+    void Report();
+
+private:
+    UdpSocket socket;
+    int serverPort = 0;
+    BroadcastFrame frames[BROADCAST_HISTORY];
+    int newest = -1;
+    Uint32 lastAck = 0;
+
+    bool Decode(const BroadcastHeader &header, const Uint8 *data, int size);
+    void Ack(int tick);
+};
@@ -0,0 +1,70 @@
+#include "CollisionEvents.h"
+
+#include <algorithm>
+#include <iostream>
+
+void CollisionEvents::Allocate(int capacity) {
+  this->capacity = capacity;
+  events = new CollisionEvent[capacity];
+  count = 0;
+}
+
+void CollisionEvents::Add(EntityType type, int row, EntityType otherType, int other, float time) {
+  int slot = count++;
+  //counted and left out by Sort, the buffer is sized so this shouldn't happen
+  if (slot >= capacity) { return; }
+  events[slot].pair = type * NONE + otherType;
+  events[slot].row = row;
+  events[slot].other = other;
+  events[slot].time = time;
+}
+
+static bool EventLess(const CollisionEvent &a, const CollisionEvent &b) {
+  if (a.pair != b.pair) { return a.pair < b.pair; }
+  if (a.row != b.row) { return a.row < b.row; }
+  return a.other < b.other;
+}
+
+static bool EventEarlier(const CollisionEvent &a, const CollisionEvent &b) {
+  if (a.pair != b.pair) { return a.pair < b.pair; }
+  return a.time < b.time;
+}
+
+void CollisionEvents::Sort() {
+  int found = count;
+  if (found > capacity) {
+    dropped += found - capacity;
+    found = capacity;
+    count = found;
+  }
+  std::sort(events, events + found, EventLess);
+
+  //a counting pass for where each pair starts, the sort already put them in that order
+  int pairCount[COLLISION_PAIR_COUNT] = {};
+  for (int e = 0; e < found; e++) {
+    pairCount[events[e].pair]++;
+    if (e > 0 && events[e].pair == events[e - 1].pair && events[e].row == events[e - 1].row) { sharedRows++; }
+  }
+  //then by when they happened, stable so equal times stay in row, other order
+  std::stable_sort(events, events + found, EventEarlier);
+  pairStart[0] = 0;
+  for (int p = 0; p < COLLISION_PAIR_COUNT; p++) { pairStart[p + 1] = pairStart[p] + pairCount[p]; }
+
+  steps++;
+  contacts += found;
+  if (found > mostInStep) { mostInStep = found; }
+}
+
+const CollisionEvent *CollisionEvents::Pair(EntityType type, EntityType otherType, int *found) const {
+  int pair = type * NONE + otherType;
+  *found = pairStart[pair + 1] - pairStart[pair];
+  return events + pairStart[pair];
+}
+
+void CollisionEvents::Report() {
+  if (steps == 0) { return; }
+
+  std::cout << "collisions: " << contacts << " contacts in " << steps << " steps, at most " << mostInStep
+            << " in one step, " << sharedRows << " more than one on the same row in a step, " << dropped
+            << " dropped for room (" << capacity << " per step)\n";
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "EntityStore.h"
+
+#include <atomic>
+
+//a contact's pair is the tested row's type and the touched row's type, NONE is never in one
+#define COLLISION_PAIR_COUNT (NONE * NONE)
+
+//one overlap found during a step, row was being tested and other is what it touched
+struct CollisionEvent {
+    int pair;
+    int row;
+    int other;
+    //fraction of the step where other first touched row along its path, 1 when only its end was tested
+    float time;
+};
+
+//every contact found during one step, in a buffer allocated once for the most the level can have
+//collision tests add to it from any worker, Sort then groups it by type pair so each kind of
+//response runs over all of its contacts in one loop
+class CollisionEvents {
+public:
+    CollisionEvent *events = NULL;
+    int capacity = 0;
+    //after Sort, contacts of pair p are events[pairStart[p]] up to events[pairStart[p + 1]]
+    int pairStart[COLLISION_PAIR_COUNT + 1] = {};
+
+    //telemetry, contacts for a row that already had one of the same pair that step are the ones
+    //keeping a single last collision per row used to lose
+    long long steps = 0;
+    long long contacts = 0;
+    long long sharedRows = 0;
+    long long dropped = 0;
+    int mostInStep = 0;
+
+    void Allocate(int capacity);
+    void Clear() { count = 0; }
+    //safe to call from several workers at once
+    void Add(EntityType type, int row, EntityType otherType, int other, float time = 1.0f);
+    //puts the contacts in pair, time, row, other order, so what the responses do doesn't depend on
+    //how the tests were split over the workers, and a response that uses up other on its first
+    //contact uses it on the one it reached first
+    void Sort();
+    int Count() const { return count; }
+    //the contacts of rows of type touching rows of otherType, valid after Sort
+    const CollisionEvent *Pair(EntityType type, EntityType otherType, int *found) const;
+    void Report();
+
+private:
+    std::atomic<int> count{ 0 };
+};
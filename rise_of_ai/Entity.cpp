@@ -1,147 +1,137 @@
 #include "Entity.h"
 
-Entity::Entity() {
-  position = glm::vec3(0);
-  acceleration = glm::vec3(0);
-  velocity = glm::vec3(0);
-  speed = 0;
-  
-  modelMatrix = glm::mat4(1.0f);
+template <typename Real>
+BasicEntity<Real>::BasicEntity(BasicEntityStore<Real> *store, int index)
+  : store(store), index(index),
+    entityType(store->entityType[index]), enemyType(store->enemyType[index]), enemyState(store->enemyState[index]),
+    flags(store->flags[index]), speed(store->speed[index]), health(store->health[index]),
+    timer(store->timer[index]), timer2(store->timer2[index]), shotPower(store->shotPower[index]),
+    textureID(store->textureID[index]),
+    onHit(store->onHit[index]), onDeath(store->onDeath[index]) {
 }
 
-bool Entity::checkCollision(Entity *other) {
-  if (isActive == false || other->isActive == false) { return false; }
+template <typename Real>
+void BasicEntity<Real>::Update(Real deltaTime, int player, EntityRange enemies, BasicEntityPool<Real> &enemyBullets,
+                               BasicEntityPool<Real> &bullets, CollisionEvents &collisions) {
+  if (IsActive() == false) { return; }
 
-  float xdist = std::fabs(position.x - other->position.x) - ((width + other->width)/2);
-  float ydist = std::fabs(position.y - other->position.y) - ((height + other->height)/2);
+  Real *x = store->x;
+  Real *y = store->y;
+  Real *vx = store->vx;
+  Real *vy = store->vy;
 
-  if (xdist < 0 && ydist < 0) {
-    lastCollision = other;
-    return true;
-  }
-  return false;
-}
-
-void Entity::checkCollisions(Entity *objects, int objCount) {
-  for (int i = 0; i < objCount; i++) {
-    Entity *object = &objects[i];
-
-    if (checkCollision(object)) {
-      collided = true;
-    }
-  }
-}
-
-void Entity::Update(float deltaTime, Entity *player, Entity *enemies, int enemyCount, Entity *enemyBullets, int enemyBulletCount, Entity *bullets, int bulletCount) {
-  if (isActive == false) { return; }
-
-  collided = false;
-
-  float new_y;
-  float new_x;
+  Real new_y;
+  Real new_x;
   switch (entityType) {
     case PLAYER:
-      velocity.x = movement.x * speed;
-      velocity.y = movement.y * speed;
-      velocity += acceleration * deltaTime;
+      vx[index] = store->moveX[index] * speed;
+      vy[index] = store->moveY[index] * speed;
 
       //check bounds + collisions and move
-      new_y = position.y + velocity.y * deltaTime;
+      new_y = y[index] + vy[index] * deltaTime;
       if (new_y > 14.5f) {
-        position.y = 14.5f;
+        y[index] = 14.5f;
       } else if (new_y < -14.5f) {
-        position.y = -14.5f;
+        y[index] = -14.5f;
       } else {
-        position.y += velocity.y * deltaTime;       //move on Y
+        y[index] += vy[index] * deltaTime;       //move on Y
       }
 
-      new_x = position.x + velocity.x * deltaTime;
+      new_x = x[index] + vx[index] * deltaTime;
       if (new_x > 19.5f) {
-        position.x = 19.5f;
+        x[index] = 19.5f;
       } else if (new_x < -19.5f) {
-        position.x = -19.5f;
+        x[index] = -19.5f;
       } else {
-        position.x += velocity.x * deltaTime;       //move on X
+        x[index] += vx[index] * deltaTime;       //move on X
       }
 
-      checkCollisions(enemies, enemyCount);
-      checkCollisions(enemyBullets, enemyBulletCount);
+      store->Collide(index, enemies, collisions);
+      store->Collide(index, enemyBullets, collisions);
 
       //shoot bullet
-      if (shot) {
-        shot = false;
-        for (int i = 0; i < bulletCount; i++) {
-          Entity *bullet = &bullets[i];
-          if (bullet->isActive == false) {
-            bullet->isActive = true;
-            bullet->position = position;
-            bullet->velocity.y = 1.0f * bullet->speed;
-            bullet->shotPower = shotPower;
-            bullet->modelMatrix = glm::mat4(1.0f);
-            bullet->modelMatrix = glm::translate(bullet->modelMatrix, bullet->position);
-            break;
-          }
-        }
+      if (Has(ENTITY_SHOT)) {
+        Set(ENTITY_SHOT, false);
+        Fire(bullets, x[index], y[index]);
       }
       break;
-    case BULLET:
-      position.y += velocity.y * deltaTime;
-      if (position.y > 16.0f) { isActive = false; }
-      break;
     case ENEMY:
-      AI(deltaTime, player, enemyBullets, enemyBulletCount, enemies, enemyCount);
-      checkCollisions(bullets, bulletCount);
+      //leaves ENTITY_SHOT set for the game to Fire, so enemies can be updated in any order
+      AI(deltaTime, player, enemies);
+      store->Collide(index, bullets, collisions);
       break;
-    case ENEMY_BULLET:
-      position.y += velocity.y * deltaTime;
-      position.x += velocity.x * deltaTime;
-      if (std::fabs(position.y) > 16.0f) { isActive = false; }
-      if (std::fabs(position.x) > 21.0f) { isActive = false; }
+    default:
+      //bullets are moved all at once by EntityStore::Integrate
       break;
   }
-
-  modelMatrix = glm::mat4(1.0f);
-  modelMatrix = glm::translate(modelMatrix, position);
 }
 
-void Entity::Render(ShaderProgram *program) {
-  if (isActive == false) { return; }
+//bullets come out of fromX, fromY, for enemies that is where they were before this step's move
+//called by the game in a fixed order so the pool hands out the same rows every run
+template <typename Real>
+void BasicEntity<Real>::Fire(BasicEntityPool<Real> &bullets, Real fromX, Real fromY) {
+  float xs[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  float ys[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+  int count = 1;
+  if (entityType == ENEMY) {
+    switch (enemyType) {
+      case SNIPER:
+        ys[0] = -1.0f;
+        break;
+      case BOMBER:
+        count = 4;
+        xs[2] = 1.0f;
+        xs[3] = -1.0f;
+        ys[0] = -1.0f;
+        ys[1] = 1.0f;
+        break;
+      case BOSS:
+        count = 3;
+        xs[0] = -1.0f;
+        xs[2] = 1.0f;
+        ys[0] = -1.0f;
+        ys[1] = -1.0f;
+        ys[2] = -1.0f;
+        break;
+    }
+  }
 
-  program->SetModelMatrix(modelMatrix);
-  
-  float vertices[]  = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-  float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
-  
-  glBindTexture(GL_TEXTURE_2D, textureID);
-  
-  glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
-  glEnableVertexAttribArray(program->positionAttribute);
-  
-  glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
-  glEnableVertexAttribArray(program->texCoordAttribute);
-  
-  glDrawArrays(GL_TRIANGLES, 0, 6);
-  
-  glDisableVertexAttribArray(program->positionAttribute);
-  glDisableVertexAttribArray(program->texCoordAttribute);
+  for (int c = 0; c < count; c++) {
+    int i = bullets.Acquire();
+    if (i < 0) { break; }
+    BasicEntity bullet = store->Get(i);
+    Set(ENTITY_FIRED, true);
+    store->x[i] = store->fromX[i] = fromX;
+    store->y[i] = store->fromY[i] = fromY;
+    //rows are reused in any order, so set both even when one is 0
+    store->vx[i] = xs[c] * bullet.speed;
+    store->vy[i] = ys[c] * bullet.speed;
+    bullet.shotPower = shotPower;
+  }
 }
 
-
-void Entity::AI(float deltaTime, Entity *player, Entity *enemyBullets, int enemyBulletCount, Entity *enemies, int enemyCount) {
+template <typename Real>
+void BasicEntity<Real>::AI(Real deltaTime, int player, EntityRange enemies) {
   switch (enemyType) {
     case SNIPER:
-      AISniper(deltaTime, player, enemyBullets, enemyBulletCount);
+      AISniper(deltaTime, player);
       break;
     case BOMBER:
-      AIBomber(deltaTime, enemyBullets, enemyBulletCount);
+      AIBomber(deltaTime);
       break;
     case BOSS:
-      AIBoss(deltaTime, enemyBullets, enemyBulletCount, enemies, enemyCount);
+      AIBoss(deltaTime, enemies);
       break;
   }
 }
 
-void Entity::AISniper(float deltaTime, Entity *player, Entity *enemyBullets, int enemyBulletCount) {
+template <typename Real>
+void BasicEntity<Real>::AISniper(Real deltaTime, int player) {
+  Real &x = store->x[index];
+  Real &y = store->y[index];
+  Real &vx = store->vx[index];
+  Real &vy = store->vy[index];
+
   switch (enemyState) {
     case IDLE:
       break;
@@ -149,13 +139,13 @@ void Entity::AISniper(float deltaTime, Entity *player, Entity *enemyBullets, int
     case ENTERING:
       //high health while entering
       health = 100.0f;
-      velocity.y = -1.0f;
+      vy = -1.0f;
       timer += deltaTime;
       if (timer > 4.0f) {
         timer = 0.0f;
-        velocity.x *= -1.0f;
+        vx *= -1.0f;
       }
-      if (position.y < 5.0f) {
+      if (y < 5.0f) {
         health = 1.0f;
         enemyState = DEFAULT;
       }
@@ -164,46 +154,37 @@ void Entity::AISniper(float deltaTime, Entity *player, Entity *enemyBullets, int
     case DEFAULT:
       timer += deltaTime;
       if (timer > 1.5f) {
-        shot = true;
+        Set(ENTITY_SHOT, true);
         timer = 0.0f;
-        velocity.y *= -1.0f;
-      }
-      if (player->position.x > position.x) { velocity.x = 1.0f; } 
-      else if (player->position.x < position.x) { velocity.x = -1.0f; } 
-      else { velocity.x = 0.0f; }
-
-      //shoot
-      if (shot) {
-        shot = false;
-        for (int i = 0; i < enemyBulletCount; i++) {
-          Entity *bullet = &enemyBullets[i];
-          if (bullet->isActive == false) {
-            bullet->isActive = true;
-            bullet->position = position;
-            bullet->velocity.y = -1.0f * bullet->speed;
-            bullet->shotPower = shotPower;
-            bullet->modelMatrix = glm::mat4(1.0f);
-            bullet->modelMatrix = glm::translate(bullet->modelMatrix, bullet->position);
-            break;
-          }
-        }
+        vy *= -1.0f;
       }
-
+      if (store->x[player] > x) { vx = 1.0f; } 
+      else if (store->x[player] < x) { vx = -1.0f; } 
+      else { vx = 0.0f; }
       break;
   }
-  position.x += velocity.x * speed * deltaTime;
-  position.y += velocity.y * speed * deltaTime;
+  //a shot asked for this step comes out from here
+  store->fromX[index] = x;
+  store->fromY[index] = y;
+  x += vx * speed * deltaTime;
+  y += vy * speed * deltaTime;
 }
 
-void Entity::AIBomber(float deltaTime, Entity *enemyBullets, int enemyBulletCount) {
+template <typename Real>
+void BasicEntity<Real>::AIBomber(Real deltaTime) {
+  Real &x = store->x[index];
+  Real &y = store->y[index];
+  Real &vx = store->vx[index];
+  Real &vy = store->vy[index];
+
   switch (enemyState) {
     case IDLE:
       break;
     case ENTERING:
       //high health while entering
       health = 100.0f;
-      if (position.y >= 14.5) {
-        velocity.y = -1.0f;
+      if (y >= 14.5) {
+        vy = -1.0f;
       } else {
         health = 1.0f;
         enemyState = DEFAULT;
@@ -212,57 +193,45 @@ void Entity::AIBomber(float deltaTime, Entity *enemyBullets, int enemyBulletCoun
     case DEFAULT:
       timer += deltaTime;
       if (timer > 2.5f) {
-        shot = true;
+        Set(ENTITY_SHOT, true);
         timer = 0.0f;
       }
-      if (position.x <= -19.5f && position.y >= 14.5f) {
-        position.x = -19.5f;
-        velocity.y = -1.0f;
-        velocity.x = 0.0f;
+      if (x <= -19.5f && y >= 14.5f) {
+        x = -19.5f;
+        vy = -1.0f;
+        vx = 0.0f;
       }
-      else if (position.y >= 14.5f) {
-        position.y = 14.5f;
-        velocity.x = -1.0f;
-        velocity.y = 0.0f;
+      else if (y >= 14.5f) {
+        y = 14.5f;
+        vx = -1.0f;
+        vy = 0.0f;
       }
-      else if (position.x >= 19.5f) {
-        position.x = 19.5f;
-        velocity.y = 1.0f;
-        velocity.x = 0.0f;
+      else if (x >= 19.5f) {
+        x = 19.5f;
+        vy = 1.0f;
+        vx = 0.0f;
       }
-      else if (position.y <= -14.5f) {
-        position.y = -14.5f;
-        velocity.x = 1.0f;
-        velocity.y = 0.0f;
+      else if (y <= -14.5f) {
+        y = -14.5f;
+        vx = 1.0f;
+        vy = 0.0f;
       }
       break;
   }
-  //shooting
-  int count = 0;
-  float xs[] = { 0.0f, 0.0f, 1.0f, -1.0f };
-  float ys[] = { -1.0f, 1.0f, 0.0f, 0.0f };
-  if (shot) {
-    shot = false;
-    for (int i = 0; i < enemyBulletCount; i++) {
-      Entity *bullet = &enemyBullets[i];
-      if (bullet->isActive == false) {
-        bullet->isActive = true;
-        bullet->position = position;
-        bullet->velocity.y = ys[count] * bullet->speed;
-        bullet->velocity.x = xs[count] * bullet->speed;
-        bullet->shotPower = shotPower;
-        bullet->modelMatrix = glm::mat4(1.0f);
-        bullet->modelMatrix = glm::translate(bullet->modelMatrix, bullet->position);
-        count += 1;
-        if (count == 4) { break; }
-      }
-    }
-  }
-  position.x += velocity.x * speed * deltaTime;
-  position.y += velocity.y * speed * deltaTime;
+  //a shot asked for this step comes out from here
+  store->fromX[index] = x;
+  store->fromY[index] = y;
+  x += vx * speed * deltaTime;
+  y += vy * speed * deltaTime;
 }
 
-void Entity::AIBoss(float deltaTime, Entity *enemyBullets, int enemyBulletCount, Entity *enemies, int enemyCount) {
+template <typename Real>
+void BasicEntity<Real>::AIBoss(Real deltaTime, EntityRange enemies) {
+  Real &x = store->x[index];
+  Real &y = store->y[index];
+  Real &vx = store->vx[index];
+  Real &vy = store->vy[index];
+
   int deadCount = 0;
   switch (enemyState) {
     case IDLE:
@@ -270,11 +239,11 @@ void Entity::AIBoss(float deltaTime, Entity *enemyBullets, int enemyBulletCount,
     case ENTERING:
       //high health while entering;
       health = 9000.0f;
-      velocity.y = -1.0f;
-      velocity.x = 0.0f;
-      if (position.y <= 12.5f) {
+      vy = -1.0f;
+      vx = 0.0f;
+      if (y <= 12.5f) {
         enemyState = DEFAULT;
-        velocity.x = 1.0f;
+        vx = 1.0f;
         health = 5;
       }
       break;
@@ -282,38 +251,23 @@ void Entity::AIBoss(float deltaTime, Entity *enemyBullets, int enemyBulletCount,
       timer += deltaTime;
       if (timer > 1.5f) {
         timer = 0.0f;
-        velocity.y *= -1.0f;
+        vy *= -1.0f;
       }
       timer2 += deltaTime;
       if (timer2 > 1.0f) {
         timer2 = 0.0f;
-        shot = true;
+        Set(ENTITY_SHOT, true);
       }
-      if (position.x >= 15.0f) {velocity.x = -1.0f;}
-      else if (position.x <= -15.0f) {velocity.x = 1.0f;}
+      if (x >= 15.0f) {vx = -1.0f;}
+      else if (x <= -15.0f) {vx = 1.0f;}
       break;
   }
-
-  int count = 0;
-  float xs[] = { -1.0f, 0.0f, 1.0f };
-  float ys[] = { -1.0f, -1.0f, -1.0f};
-  if (shot) {
-    shot = false;
-    for (int i = 0; i < enemyBulletCount; i++) {
-      Entity *bullet = &enemyBullets[i];
-      if (bullet->isActive == false) {
-        bullet->isActive = true;
-        bullet->position = position;
-        bullet->velocity.y = ys[count] * bullet->speed;
-        bullet->velocity.x = xs[count] * bullet->speed;
-        bullet->shotPower = shotPower;
-        bullet->modelMatrix = glm::mat4(1.0f);
-        bullet->modelMatrix = glm::translate(bullet->modelMatrix, bullet->position);
-        count += 1;
-        if (count == 3) { break; }
-      }
-    }
-  }
-  position.x += velocity.x * speed * deltaTime;
-  position.y += velocity.y * speed * deltaTime;
+  //a shot asked for this step comes out from here
+  store->fromX[index] = x;
+  store->fromY[index] = y;
+  x += vx * speed * deltaTime;
+  y += vy * speed * deltaTime;
 }
+
+template class BasicEntity<float>;
+template class BasicEntity<Fixed16>;
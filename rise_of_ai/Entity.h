@@ -11,53 +11,58 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "ParticleSystem.h"
+#include "EntityStore.h"
+#include "CollisionEvents.h"
 
-enum EntityType { PLAYER, ENEMY, BULLET, ENEMY_BULLET, NONE };
-enum EnemyType { BOMBER, SNIPER, BOSS };
-enum EnemyState { IDLE, ENTERING, DEFAULT, DEAD }; 
-
-class Entity {
+//one row of the entity store seen as an object, so gameplay code can still say enemy.health
+//the data itself lives in the store's columns
+template <typename Real>
+class BasicEntity {
 public:
-    EntityType entityType = NONE;
-    EnemyType enemyType;
-    EnemyState enemyState = IDLE;
-
-    bool isActive = false;
-
-    bool collided = false;
-    Entity *lastCollision = NULL;
-
-    glm::vec3 position;
-    glm::vec3 movement;
-    glm::vec3 acceleration;
-    glm::vec3 velocity;
-    float speed;
-    int health = 1.0f;
-
-    float width = 1.0f;
-    float height = 1.0f;
-    float scale = 1.0f;
-
-    float timer = 0.0f;
-    float timer2 = 0.0f;
+    BasicEntityStore<Real> *store;
+    int index;
 
-    bool shot = false;
-    int shotPower = 0;
+    EntityType &entityType;
+    EnemyType &enemyType;
+    EnemyState &enemyState;
+    Uint8 &flags;
+    Real &speed;
+    int &health;
+    Real &timer;
+    Real &timer2;
+    int &shotPower;
+    GLuint &textureID;
+    ParticleEmitter *&onHit;
+    ParticleEmitter *&onDeath;
 
-    GLuint textureID;
+    BasicEntity(BasicEntityStore<Real> *store, int index);
 
-    glm::mat4 modelMatrix;
+    bool Has(Uint8 flag) const { return (flags & flag) != 0; }
+    void Set(Uint8 flag, bool on) { flags = on ? (flags | flag) : (flags & ~flag); }
+    bool IsActive() const { return Has(ENTITY_ACTIVE); }
+    void SetActive(bool on) { Set(ENTITY_ACTIVE, on); }
 
-    Entity();
+    glm::vec3 Position() const { return glm::vec3(ToFloat(store->x[index]), ToFloat(store->y[index]), 0.0f); }
+    //places the entity without it having travelled there
+    void SetPosition(glm::vec3 position) {
+        store->x[index] = store->fromX[index] = position.x;
+        store->y[index] = store->fromY[index] = position.y;
+    }
+    glm::vec3 Velocity() const { return glm::vec3(ToFloat(store->vx[index]), ToFloat(store->vy[index]), 0.0f); }
+    void SetVelocity(glm::vec3 velocity) { store->vx[index] = velocity.x; store->vy[index] = velocity.y; }
+    glm::vec3 Movement() const { return glm::vec3(ToFloat(store->moveX[index]), ToFloat(store->moveY[index]), 0.0f); }
+    void SetMovement(glm::vec3 movement) { store->moveX[index] = movement.x; store->moveY[index] = movement.y; }
+    void SetSize(float width, float height) { store->halfWidth[index] = width / 2; store->halfHeight[index] = height / 2; }
 
-    bool checkCollision(Entity *other);
-    void checkCollisions(Entity *objects, int objCount);
-    void Update(float deltaTime, Entity *player, Entity *enemies, int enemyCount, Entity *enemyBullets, int enemyBulletCount, Entity *bullets, int bulletCount);
-    void Render(ShaderProgram *program);
-    void DrawSpriteFromTextureAtlas(ShaderProgram *program, GLuint textureID, int index);
-    void AI(float deltaTime, Entity *player, Entity *enemyBullets, int enemyBulletCount, Entity *enemies, int enemyCount);
-    void AISniper(float deltaTime, Entity *player, Entity *enemyBullets, int enemyBulletCount);
-    void AIBomber(float deltaTime, Entity *enemyBullets, int enemyBulletCount);
-    void AIBoss(float deltaTime, Entity *enemyBullets, int enemyBulletCount, Entity *enemies, int enemyCount);
+    //contacts found are added to collisions, the game responds to them once every row has moved
+    void Update(Real deltaTime, int player, EntityRange enemies, BasicEntityPool<Real> &enemyBullets,
+                BasicEntityPool<Real> &bullets, CollisionEvents &collisions);
+    void Fire(BasicEntityPool<Real> &bullets, Real fromX, Real fromY);
+    void AI(Real deltaTime, int player, EntityRange enemies);
+    void AISniper(Real deltaTime, int player);
+    void AIBomber(Real deltaTime);
+    void AIBoss(Real deltaTime, EntityRange enemies);
 };
 
+typedef BasicEntity<SimReal> Entity;
@@ -0,0 +1,425 @@
+#include "EntityStore.h"
+#include "CollisionEvents.h"
+#include "Entity.h"
+#include "AabbBatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+//points column at the next free bytes of base, or with base NULL only counts them
+//columns start on 8 bytes so every number type lines up
+template <typename T>
+static void Place(Uint8 *base, size_t *used, T **column, int capacity) {
+  if (base != NULL) { *column = (T *)(base + *used); }
+  *used += (sizeof(T) * capacity + 7) & ~(size_t)7;
+}
+
+//lays the columns a step can change out one after another from base, returns the bytes they take
+template <typename Real>
+size_t BasicEntityStore<Real>::LayOut(Uint8 *base) {
+  size_t used = 0;
+  Place(base, &used, &x, capacity);
+  Place(base, &used, &y, capacity);
+  Place(base, &used, &vx, capacity);
+  Place(base, &used, &vy, capacity);
+  Place(base, &used, &fromX, capacity);
+  Place(base, &used, &fromY, capacity);
+  Place(base, &used, &halfWidth, capacity);
+  Place(base, &used, &halfHeight, capacity);
+  Place(base, &used, &health, capacity);
+  Place(base, &used, &flags, capacity);
+
+  Place(base, &used, &entityType, capacity);
+  Place(base, &used, &enemyType, capacity);
+  Place(base, &used, &enemyState, capacity);
+  Place(base, &used, &moveX, capacity);
+  Place(base, &used, &moveY, capacity);
+  Place(base, &used, &speed, capacity);
+  Place(base, &used, &timer, capacity);
+  Place(base, &used, &timer2, capacity);
+  Place(base, &used, &shotPower, capacity);
+  return used;
+}
+
+template <typename Real>
+void BasicEntityStore<Real>::Allocate(int capacity) {
+  this->capacity = capacity;
+  count = 0;
+
+  //zeroed so the padding and unused rows are the same bytes in every copy
+  blockSize = LayOut(NULL);
+  block = new Uint8[blockSize]();
+  LayOut(block);
+
+  textureID = new GLuint[capacity];
+  onHit = new ParticleEmitter *[capacity];
+  onDeath = new ParticleEmitter *[capacity];
+}
+
+//adds count inactive rows of one type with the same defaults the old Entity had
+template <typename Real>
+EntityRange BasicEntityStore<Real>::Add(EntityType type, int count) {
+  EntityRange range;
+  range.begin = this->count;
+  range.end = this->count + count;
+  if (range.end > capacity) {
+    std::cout << "entity store: out of room for " << count << " entities\n";
+    range.end = range.begin;
+    return range;
+  }
+
+  for (int i = range.begin; i < range.end; i++) {
+    flags[i] = 0;
+    x[i] = 0.0f;
+    y[i] = 0.0f;
+    vx[i] = 0.0f;
+    vy[i] = 0.0f;
+    fromX[i] = 0.0f;
+    fromY[i] = 0.0f;
+    halfWidth[i] = 0.5f;
+    halfHeight[i] = 0.5f;
+    health[i] = 1;
+
+    entityType[i] = type;
+    enemyType[i] = BOMBER;
+    enemyState[i] = IDLE;
+    moveX[i] = 0.0f;
+    moveY[i] = 0.0f;
+    speed[i] = 0.0f;
+    timer[i] = 0.0f;
+    timer2[i] = 0.0f;
+    shotPower[i] = 0;
+    textureID[i] = 0;
+    onHit[i] = NULL;
+    onDeath[i] = NULL;
+  }
+  this->count = range.end;
+  return range;
+}
+
+template <typename Real>
+BasicEntity<Real> BasicEntityStore<Real>::Get(int index) {
+  return BasicEntity<Real>(this, index);
+}
+
+//writes the rows in range that have all the required flags to out, returns how many
+template <typename Real>
+int BasicEntityStore<Real>::Query(EntityRange range, Uint8 required, int *out) {
+  int found = 0;
+  for (int i = range.begin; i < range.end; i++) {
+    out[found] = i;
+    found += (int)((flags[i] & required) == required);
+  }
+  return found;
+}
+
+template <typename Real>
+struct IntegrateJob {
+    BasicEntityStore<Real> *store;
+    BasicEntityPool<Real> *pool;
+    Real deltaTime;
+};
+
+template <typename Real>
+static void IntegrateRows(void *data, int begin, int end) {
+  IntegrateJob<Real> *job = (IntegrateJob<Real> *)data;
+  BasicEntityStore<Real> *store = job->store;
+  for (int k = begin; k < end; k++) {
+    int i = job->pool->Row(k);
+    store->fromX[i] = store->x[i];
+    store->fromY[i] = store->y[i];
+    store->y[i] += store->vy[i] * job->deltaTime;
+    store->x[i] += store->vx[i] * job->deltaTime;
+    job->pool->leaving[k] = Abs(store->y[i]) > 16.0f || Abs(store->x[i]) > 21.0f;
+  }
+}
+
+//straight line movement for bullets, given back to the pool once they leave the arena
+//the moving is spread over the workers, the giving back is done here afterwards
+template <typename Real>
+void BasicEntityStore<Real>::Integrate(BasicEntityPool<Real> &pool, Real deltaTime, JobSystem *jobs) {
+  IntegrateJob<Real> job = { this, &pool, deltaTime };
+  if (jobs != NULL) { jobs->ParallelFor(pool.Count(), INTEGRATE_GRAIN, IntegrateRows<Real>, &job); }
+  else { IntegrateRows<Real>(&job, 0, pool.Count()); }
+
+  //backwards, so the row swapped in by a release has already been looked at
+  for (int k = pool.Count() - 1; k >= 0; k--) {
+    if (pool.leaving[k]) { pool.Release(pool.Row(k)); }
+  }
+}
+
+//the batch kernel for float columns
+static int OverlapBatch(float x, float y, float halfWidth, float halfHeight,
+                        const float *xs, const float *ys, const float *halfWidths, const float *halfHeights, int count) {
+  return AabbOverlap(x, y, halfWidth, halfHeight, xs, ys, halfWidths, halfHeights, count);
+}
+
+//and the same test one box at a time in fixed point, where it is a few integer compares
+template <int FractionBits>
+static int OverlapBatch(Fixed<FractionBits> x, Fixed<FractionBits> y, Fixed<FractionBits> halfWidth,
+                        Fixed<FractionBits> halfHeight, const Fixed<FractionBits> *xs, const Fixed<FractionBits> *ys,
+                        const Fixed<FractionBits> *halfWidths, const Fixed<FractionBits> *halfHeights, int count) {
+  int mask = 0;
+  for (int b = 0; b < count; b++) {
+    bool overlap = Abs(x - xs[b]) < halfWidth + halfWidths[b] && Abs(y - ys[b]) < halfHeight + halfHeights[b];
+    mask |= (int)overlap << b;
+  }
+  return mask;
+}
+
+//tests one row against a range and adds every overlap to events, returns how many
+template <typename Real>
+int BasicEntityStore<Real>::Collide(int index, EntityRange others, CollisionEvents &events) {
+  if ((flags[index] & ENTITY_ACTIVE) == 0) { return 0; }
+
+  int found = 0;
+  for (int first = others.begin; first < others.end; first += AABB_BATCH) {
+    int count = others.end - first < AABB_BATCH ? others.end - first : AABB_BATCH;
+    int mask = OverlapBatch(x[index], y[index], halfWidth[index], halfHeight[index],
+                            x + first, y + first, halfWidth + first, halfHeight + first, count);
+    for (int b = 0; mask != 0; b++, mask >>= 1) {
+      if ((mask & 1) && (flags[first + b] & ENTITY_ACTIVE)) {
+        events.Add(entityType[index], index, entityType[first + b], first + b);
+        found++;
+      }
+    }
+  }
+  return found;
+}
+
+//true if row other overlaps row index at some point while moving from fromX, fromY to x, y
+//index is taken to be standing still, *impact is the fraction of the step where they first touch
+template <typename Real>
+bool BasicEntityStore<Real>::Sweep(int index, int other, Real *impact) {
+  //shrink other to a point and grow index by its size, then clip the path against each axis
+  Real extent[2] = { halfWidth[index] + halfWidth[other], halfHeight[index] + halfHeight[other] };
+  Real start[2] = { fromX[other] - x[index], fromY[other] - y[index] };
+  Real move[2] = { x[other] - fromX[other], y[other] - fromY[other] };
+
+  Real enter = 0.0f;
+  Real exit = 1.0f;
+  for (int axis = 0; axis < 2; axis++) {
+    if (move[axis] == 0.0f) {
+      if (Abs(start[axis]) >= extent[axis]) { return false; }
+      continue;
+    }
+    Real t0 = (-extent[axis] - start[axis]) / move[axis];
+    Real t1 = (extent[axis] - start[axis]) / move[axis];
+    if (t0 > t1) { std::swap(t0, t1); }
+    if (t0 > enter) { enter = t0; }
+    if (t1 < exit) { exit = t1; }
+    //only touching edges, or never inside on both axes at once
+    if (enter >= exit) { return false; }
+  }
+
+  if (impact != NULL) { *impact = enter; }
+  return true;
+}
+
+//same as above against a pool, only looking in the grid cells near the row
+//bullets are tested along the path they took this step, so a fast one can't skip through
+//candidates come in cell order, CollisionEvents::Sort puts them back in row order
+//the grid keeps float boxes either way, they only pick candidates and are grown a little, so
+//which hits count is still decided by the tests in Real below
+template <typename Real>
+int BasicEntityStore<Real>::Collide(int index, BasicEntityPool<Real> &others, CollisionEvents &events) {
+  if ((flags[index] & ENTITY_ACTIVE) == 0) { return 0; }
+
+  SpatialGrid &grid = others.grid;
+  float boxX = ToFloat(x[index]);
+  float boxY = ToFloat(y[index]);
+  float boxHalfWidth = ToFloat(halfWidth[index]);
+  float boxHalfHeight = ToFloat(halfHeight[index]);
+  int column0, row0, column1, row1;
+  grid.CellRange(boxX - boxHalfWidth, boxY - boxHalfHeight, boxX + boxHalfWidth, boxY + boxHalfHeight,
+                 &column0, &row0, &column1, &row1);
+
+  int found = 0;
+  int tests = 0;
+  int swept = 0;
+  for (int row = row0; row <= row1; row++) {
+    //the cells along one grid row sit next to each other
+    int begin = grid.cellStart[row * grid.columns + column0];
+    int end = grid.cellStart[row * grid.columns + column1 + 1];
+    for (int first = begin; first < end; first += AABB_BATCH) {
+      int count = end - first < AABB_BATCH ? end - first : AABB_BATCH;
+      int mask = AabbOverlap(boxX, boxY, boxHalfWidth, boxHalfHeight, grid.itemX + first,
+                             grid.itemY + first, grid.itemHalfWidth + first, grid.itemHalfHeight + first, count);
+      tests += count;
+      for (int b = 0; mask != 0; b++, mask >>= 1) {
+        int i = grid.items[first + b];
+        //released since the grid was built
+        if ((mask & 1) == 0 || (flags[i] & ENTITY_ACTIVE) == 0) { continue; }
+
+        //where it ended up, the same test as before, then the path it took to get there
+        //the path also says when in the step it first touched, for hits found either way
+        Real xdist = Abs(x[index] - x[i]) - (halfWidth[index] + halfWidth[i]);
+        Real ydist = Abs(y[index] - y[i]) - (halfHeight[index] + halfHeight[i]);
+        bool hit = xdist < 0 && ydist < 0;
+        Real impact = 1.0f;
+        bool crossed = Sweep(index, i, &impact);
+        if (hit == false && crossed) {
+          hit = true;
+          swept++;
+        }
+        if (hit) {
+          events.Add(entityType[index], index, entityType[i], i, ToFloat(impact));
+          found++;
+        }
+      }
+    }
+  }
+  //enemies are collided from several workers, so these are added once per call
+  grid.pairTests += tests;
+  grid.bruteTests += others.Count();
+  if (swept > 0) { grid.sweptHits += swept; }
+  return found;
+}
+
+//draws the active rows of a range, offset moves them on screen only
+template <typename Real>
+void BasicEntityStore<Real>::Render(ShaderProgram *program, EntityRange range, glm::vec3 offset) {
+  float vertices[]  = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
+  float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
+
+  //every entity is the same quad, so the arrays are set up once for the whole range
+  glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
+  glEnableVertexAttribArray(program->positionAttribute);
+  glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
+  glEnableVertexAttribArray(program->texCoordAttribute);
+
+  for (int i = range.begin; i < range.end; i++) {
+    if ((flags[i] & ENTITY_ACTIVE) == 0) { continue; }
+
+    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(ToFloat(x[i]), ToFloat(y[i]), 0.0f) + offset);
+    program->SetModelMatrix(modelMatrix);
+    glBindTexture(GL_TEXTURE_2D, textureID[i]);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+  }
+
+  glDisableVertexAttribArray(program->positionAttribute);
+  glDisableVertexAttribArray(program->texCoordAttribute);
+}
+
+template <typename Real>
+void BasicEntityStore<Real>::Render(ShaderProgram *program, BasicEntityPool<Real> &pool) {
+  float vertices[]  = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
+  float texCoords[] = { 0.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 1.0, 1.0, 0.0, 0.0, 0.0 };
+
+  glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices);
+  glEnableVertexAttribArray(program->positionAttribute);
+  glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords);
+  glEnableVertexAttribArray(program->texCoordAttribute);
+
+  for (int k = 0; k < pool.Count(); k++) {
+    int i = pool.Row(k);
+    glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(ToFloat(x[i]), ToFloat(y[i]), 0.0f));
+    program->SetModelMatrix(modelMatrix);
+    glBindTexture(GL_TEXTURE_2D, textureID[i]);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+  }
+
+  glDisableVertexAttribArray(program->positionAttribute);
+  glDisableVertexAttribArray(program->texCoordAttribute);
+}
+
+template <typename Real>
+void BasicEntityPool<Real>::Setup(BasicEntityStore<Real> *store, EntityRange range) {
+  this->store = store;
+  this->range = range;
+  rows.Allocate(range.Count());
+  for (int i = 0; i < range.Count(); i++) { rows[i] = range.begin + i; }
+  //a little past where Integrate drops bullets
+  grid.Allocate(range.Count(), -21.0f, -16.0f, 21.0f, 16.0f);
+  gathered = new int[range.Count()];
+  leaving = new Uint8[range.Count()];
+}
+
+template <typename Real>
+void BasicEntityPool<Real>::Rebuild(JobSystem *jobs) {
+  for (int k = 0; k < Count(); k++) { gathered[k] = Row(k); }
+  grid.Build(store->x, store->y, store->fromX, store->fromY, store->halfWidth, store->halfHeight, gathered, Count(), jobs);
+}
+
+template <typename Real>
+int BasicEntityPool<Real>::Acquire() {
+  int slot = rows.Acquire();
+  if (slot < 0) { return -1; }
+  int row = rows[slot];
+  store->flags[row] |= ENTITY_ACTIVE;
+  return row;
+}
+
+template <typename Real>
+void BasicEntityPool<Real>::Release(int row) {
+  store->flags[row] &= ~ENTITY_ACTIVE;
+  rows.Release(row - range.begin);
+}
+
+template class BasicEntityStore<float>;
+template class BasicEntityStore<Fixed16>;
+template struct BasicEntityPool<float>;
+template struct BasicEntityPool<Fixed16>;
+
+//a quarter of the bullets are topped back up every step from a fixed sequence, so both number
+//types see the same spawns and the hit counts should only differ by rounding
+template <typename Real>
+static void BenchmarkReal(const char *name, int count, int steps) {
+  const int targetCount = 64;
+  BasicEntityStore<Real> store;
+  store.Allocate(count + targetCount);
+  BasicEntityPool<Real> bullets;
+  bullets.Setup(&store, store.Add(BULLET, count));
+  EntityRange targets = store.Add(ENEMY, targetCount);
+  CollisionEvents events;
+  events.Allocate(count * targetCount);
+  for (int i = targets.begin; i < targets.end; i++) {
+    int k = i - targets.begin;
+    store.flags[i] = ENTITY_ACTIVE;
+    store.x[i] = -17.5f + (k % 8) * 5.0f;
+    store.y[i] = -10.5f + (k / 8) * 3.0f;
+    store.fromX[i] = store.x[i];
+    store.fromY[i] = store.y[i];
+    store.halfWidth[i] = 0.475f;
+    store.halfHeight[i] = 0.475f;
+  }
+
+  unsigned int seed = 1;
+  int hits = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  for (int step = 0; step < steps; step++) {
+    while (bullets.Count() < count) {
+      int i = bullets.Acquire();
+      seed = seed * 1103515245 + 12345;
+      store.x[i] = store.fromX[i] = (float)((seed >> 8) % 4000) / 100.0f - 20.0f;
+      store.y[i] = store.fromY[i] = (float)((seed >> 20) % 300) / 10.0f - 15.0f;
+      store.vx[i] = (float)((seed >> 4) % 33) - 16.0f;
+      store.vy[i] = (float)((seed >> 12) % 33) - 16.0f;
+      store.halfWidth[i] = 0.15f;
+      store.halfHeight[i] = 0.15f;
+    }
+
+    store.Integrate(bullets, 0.0166666f);
+    bullets.Rebuild();
+    events.Clear();
+    for (int i = targets.begin; i < targets.end; i++) { store.Collide(i, bullets, events); }
+    //a bullet touching two targets is only spent once
+    events.Sort();
+    for (int e = 0; e < events.Count(); e++) {
+      int bullet = events.events[e].other;
+      if (store.flags[bullet] & ENTITY_ACTIVE) {
+        hits++;
+        bullets.Release(bullet);
+      }
+    }
+  }
+  double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+  std::cout << "simulation: " << name << " " << ms / steps << " ms per step, "
+            << ms * 1000000.0 / ((double)steps * count) << " ns per bullet, " << hits << " hits\n";
+}
+
+void BenchmarkSimulation(int count, int steps) {
+  BenchmarkReal<float>("float", count, steps);
+  BenchmarkReal<Fixed16>("fixed", count, steps);
+}
@@ -0,0 +1,153 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+#include "ParticleSystem.h"
+#include "Fixed.h"
+#include "Pool.h"
+#include "SpatialGrid.h"
+#include "JobSystem.h"
+
+enum EntityType { PLAYER, ENEMY, BULLET, ENEMY_BULLET, NONE };
+enum EnemyType { BOMBER, SNIPER, BOSS };
+enum EnemyState { IDLE, ENTERING, DEFAULT, DEAD };
+
+//bullets per job when moving them across workers
+#define INTEGRATE_GRAIN 256
+
+//bits in the flags column
+#define ENTITY_ACTIVE 1
+//asked to shoot on its next update
+#define ENTITY_SHOT 4
+//set during a step for the game to react to, cleared at the start of the next one
+//a bullet actually left this entity
+#define ENTITY_FIRED 8
+//took damage from a bullet
+#define ENTITY_HIT 16
+//health ran out
+#define ENTITY_DIED 32
+
+//entities of one kind are added together, so a kind is just a run of rows
+struct EntityRange {
+    int begin = 0;
+    int end = 0;
+
+    int Count() const { return end - begin; }
+};
+
+template <typename Real> class BasicEntity;
+template <typename Real> class BasicEntityStore;
+class CollisionEvents;
+
+//a range whose rows are handed out and taken back through a pool instead of searched for,
+//a row is active exactly while it is acquired
+template <typename Real>
+struct BasicEntityPool {
+    BasicEntityStore<Real> *store = NULL;
+    EntityRange range;
+    //slot i holds row range.begin + i
+    Pool<int> rows;
+    //the active rows as of the last Rebuild
+    SpatialGrid grid;
+    int *gathered = NULL;
+    //set by Integrate's jobs for the rows it has to give back, per live slot
+    Uint8 *leaving = NULL;
+
+    void Setup(BasicEntityStore<Real> *store, EntityRange range);
+    //call after the last Acquire and before colliding against the pool, rows released in
+    //between are still skipped
+    void Rebuild(JobSystem *jobs = NULL);
+    //an inactive row switched on, -1 when they are all in use
+    int Acquire();
+    void Release(int row);
+
+    int Count() const { return rows.count; }
+    //the i'th active row, for 0 <= i < Count()
+    int Row(int i) { return rows.Live(i); }
+};
+
+//every entity is a row across these columns, so a loop that only needs positions and
+//flags only touches positions and flags
+//the columns a step can change all live in one block, so copying block copies the simulation
+//Real is the number type of positions, velocities, sizes, timers and the collision math, float
+//or fixed point, see SimReal
+template <typename Real>
+class BasicEntityStore {
+public:
+    int count = 0;
+    int capacity = 0;
+
+    //holds every column but the textures and effects, which only the game's drawing uses
+    Uint8 *block = NULL;
+    size_t blockSize = 0;
+
+    //hot columns, read every step by movement, collision and drawing
+    Uint8 *flags;
+    Real *x;
+    Real *y;
+    Real *vx;
+    Real *vy;
+    //where the row was at the start of the step, bullets are tested along the whole path
+    Real *fromX;
+    Real *fromY;
+    Real *halfWidth;
+    Real *halfHeight;
+    int *health;
+
+    //cold columns, only read by the entity's own logic
+    EntityType *entityType;
+    EnemyType *enemyType;
+    EnemyState *enemyState;
+    Real *moveX;
+    Real *moveY;
+    Real *speed;
+    Real *timer;
+    Real *timer2;
+    int *shotPower;
+
+    //set once by the game, outside block
+    GLuint *textureID;
+    //effects played by the game when these happen, NULL for none
+    ParticleEmitter **onHit;
+    ParticleEmitter **onDeath;
+
+    void Allocate(int capacity);
+    EntityRange Add(EntityType type, int count);
+    BasicEntity<Real> Get(int index);
+
+    int Query(EntityRange range, Uint8 required, int *out);
+    void Integrate(BasicEntityPool<Real> &pool, Real deltaTime, JobSystem *jobs = NULL);
+    int Collide(int index, EntityRange others, CollisionEvents &events);
+    int Collide(int index, BasicEntityPool<Real> &others, CollisionEvents &events);
+    bool Sweep(int index, int other, Real *impact);
+    void Render(ShaderProgram *program, EntityRange range, glm::vec3 offset = glm::vec3(0));
+    void Render(ShaderProgram *program, BasicEntityPool<Real> &pool);
+
+private:
+    size_t LayOut(Uint8 *base);
+};
+
+//the number type the game runs on, build with SIM_FIXED_POINT for fixed point that steps the
+//same on every compiler and cpu, which lockstep play and replays across machines need
+//both are compiled either way, BenchmarkSimulation times one against the other
+#ifdef SIM_FIXED_POINT
+typedef Fixed16 SimReal;
+#else
+typedef float SimReal;
+#endif
+
+typedef BasicEntityStore<SimReal> EntityStore;
+typedef BasicEntityPool<SimReal> EntityPool;
+
+//steps count bullets through movement, the grid and collision against a row of targets with
+//each number type and prints the throughput of both
+void BenchmarkSimulation(int count, int steps);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+//a number kept as a whole count of 1 / 2^FractionBits, so adding, multiplying and comparing
+//give the same bits on every compiler, optimisation level and cpu, there is nothing for
+//fused multiply-adds or extra precision to change
+//floats only come in through the constructors, which round to the nearest step, so setup values
+//and constants written as float literals land on the same value everywhere
+//multiplies go through 64 bits and round down, divides round toward zero and clamp to the range
+template <int FractionBits>
+class Fixed {
+public:
+    static const int32_t One = (int32_t)1 << FractionBits;
+
+    int32_t raw = 0;
+
+    Fixed() {}
+    Fixed(int value) : raw(value * One) {}
+    Fixed(float value) : raw((int32_t)std::lround(value * (float)One)) {}
+    Fixed(double value) : raw((int32_t)std::llround(value * (double)One)) {}
+
+    static Fixed FromRaw(int32_t raw) {
+        Fixed value;
+        value.raw = raw;
+        return value;
+    }
+
+    //exact while the value is under 2^(24 - FractionBits), all of the arena is
+    float ToFloat() const { return (float)raw / (float)One; }
+
+    Fixed operator-() const { return FromRaw(-raw); }
+
+    Fixed &operator+=(Fixed other) { raw += other.raw; return *this; }
+    Fixed &operator-=(Fixed other) { raw -= other.raw; return *this; }
+    Fixed &operator*=(Fixed other) { *this = *this * other; return *this; }
+    Fixed &operator/=(Fixed other) { *this = *this / other; return *this; }
+
+    //friends so a float or int on either side is converted the same way
+    friend Fixed operator+(Fixed a, Fixed b) { return FromRaw(a.raw + b.raw); }
+    friend Fixed operator-(Fixed a, Fixed b) { return FromRaw(a.raw - b.raw); }
+    //>> on a negative number is an arithmetic shift on every compiler we build with
+    friend Fixed operator*(Fixed a, Fixed b) { return FromRaw((int32_t)(((int64_t)a.raw * b.raw) >> FractionBits)); }
+    friend Fixed operator/(Fixed a, Fixed b) {
+        int64_t quotient = (int64_t)a.raw * One / b.raw;
+        if (quotient > INT32_MAX) { quotient = INT32_MAX; }
+        if (quotient < -INT32_MAX) { quotient = -INT32_MAX; }
+        return FromRaw((int32_t)quotient);
+    }
+
+    friend bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+    friend bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+    friend bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+    friend bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+};
+
+//16.16, a step of 0.000015 and a range of +-32768, plenty for a 40 by 30 arena
+typedef Fixed<16> Fixed16;
+
+//the same calls for either number type, so simulation code can be written once for both
+inline float ToFloat(float value) { return value; }
+template <int FractionBits>
+float ToFloat(Fixed<FractionBits> value) { return value.ToFloat(); }
+
+inline float Abs(float value) { return std::fabs(value); }
+template <int FractionBits>
+Fixed<FractionBits> Abs(Fixed<FractionBits> value) { return value.raw < 0 ? -value : value; }
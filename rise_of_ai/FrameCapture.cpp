@@ -0,0 +1,202 @@
+#include "FrameCapture.h"
+
+#include <cstring>
+#include <iostream>
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+bool FrameCapture::Start(const char *filePath, int width, int height, int fps) {
+  file = fopen(filePath, "wb");
+  if (file == NULL) {
+    std::cout << "Unable to open capture file " << filePath << "\n";
+    return false;
+  }
+
+  this->width = width;
+  this->height = height;
+
+  //pick the output from the extension, anything that isn't .y4m is written as raw rgba
+  const char *ext = strrchr(filePath, '.');
+  format = (ext != NULL && strcmp(ext, ".y4m") == 0) ? CAPTURE_Y4M : CAPTURE_RGBA;
+  if (format == CAPTURE_Y4M) {
+    fprintf(file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+  }
+
+  int frameSize = width * height * 4;
+
+  glGenBuffers(CAPTURE_PBO_COUNT, pbos);
+  for (int i = 0; i < CAPTURE_PBO_COUNT; i++) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, NULL, GL_STREAM_READ);
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  for (int i = 0; i < CAPTURE_QUEUE_SIZE; i++) {
+    slots[i] = new unsigned char[frameSize];
+    freeSlots[i] = i;
+  }
+  freeCount = CAPTURE_QUEUE_SIZE;
+  planes = new unsigned char[width * height * 3];
+
+  stopWriter = false;
+  writer = std::thread(&FrameCapture::WriterLoop, this);
+
+  isCapturing = true;
+  return true;
+}
+
+//call after the frame is drawn and before SDL_GL_SwapWindow
+void FrameCapture::Capture() {
+  if (isCapturing == false) { return; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  frameCount++;
+
+  //queue an async read of this frame into the current pbo, glReadPixels returns right away
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pboIndex]);
+  glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+  pendingReads++;
+
+  //the oldest pbo was read CAPTURE_PBO_COUNT - 1 frames ago so it should be ready by now
+  pboIndex = (pboIndex + 1) % CAPTURE_PBO_COUNT;
+  if (pendingReads == CAPTURE_PBO_COUNT) {
+    ReadBack(pboIndex);
+    pendingReads--;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  double ms = ElapsedMs(start);
+  totalCaptureMs += ms;
+  if (ms > maxCaptureMs) { maxCaptureMs = ms; }
+}
+
+void FrameCapture::ReadBack(int pbo) {
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo]);
+
+  int slot = -1;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (freeCount > 0) { slot = freeSlots[--freeCount]; }
+  }
+  //writer is behind, drop the frame instead of stalling the game
+  if (slot < 0) {
+    framesDropped++;
+    return;
+  }
+
+  void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+  if (pixels != NULL) {
+    memcpy(slots[slot], pixels, width * height * 4);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (pixels != NULL) {
+      queue[(queueHead + queueCount) % CAPTURE_QUEUE_SIZE] = slot;
+      queueCount++;
+    } else {
+      freeSlots[freeCount++] = slot;
+    }
+  }
+  if (pixels != NULL) {
+    framesCaptured++;
+    wake.notify_one();
+  } else {
+    framesDropped++;
+  }
+}
+
+void FrameCapture::WriterLoop() {
+  while (true) {
+    int slot;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      wake.wait(guard, [this] { return queueCount > 0 || stopWriter; });
+      if (queueCount == 0) { return; }
+      slot = queue[queueHead];
+      queueHead = (queueHead + 1) % CAPTURE_QUEUE_SIZE;
+      queueCount--;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    WriteFrame(slots[slot]);
+    totalWriteMs += ElapsedMs(start);
+    framesWritten++;
+
+    std::lock_guard<std::mutex> guard(lock);
+    freeSlots[freeCount++] = slot;
+  }
+}
+
+void FrameCapture::WriteFrame(const unsigned char *pixels) {
+  int stride = width * 4;
+
+  //gl gives us the rows bottom up
+  if (format == CAPTURE_RGBA) {
+    for (int y = height - 1; y >= 0; y--) {
+      fwrite(pixels + y * stride, 1, stride, file);
+    }
+    return;
+  }
+
+  //bt.601 studio range 4:4:4
+  unsigned char *yPlane = planes;
+  unsigned char *uPlane = planes + width * height;
+  unsigned char *vPlane = planes + width * height * 2;
+  for (int y = 0; y < height; y++) {
+    const unsigned char *row = pixels + (height - 1 - y) * stride;
+    int out = y * width;
+    for (int x = 0; x < width; x++) {
+      int r = row[x * 4];
+      int g = row[x * 4 + 1];
+      int b = row[x * 4 + 2];
+      yPlane[out + x] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+      uPlane[out + x] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+      vPlane[out + x] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+  }
+  fputs("FRAME\n", file);
+  fwrite(planes, 1, width * height * 3, file);
+}
+
+void FrameCapture::Stop() {
+  if (isCapturing == false) { return; }
+  isCapturing = false;
+
+  //flush the frames still sitting in the ring
+  while (pendingReads > 0) {
+    ReadBack((pboIndex + CAPTURE_PBO_COUNT - pendingReads) % CAPTURE_PBO_COUNT);
+    pendingReads--;
+  }
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopWriter = true;
+  }
+  wake.notify_one();
+  writer.join();
+
+  glDeleteBuffers(CAPTURE_PBO_COUNT, pbos);
+  for (int i = 0; i < CAPTURE_QUEUE_SIZE; i++) {
+    delete[] slots[i];
+  }
+  delete[] planes;
+  fclose(file);
+  file = NULL;
+}
+
+void FrameCapture::Report() {
+  if (frameCount == 0) { return; }
+
+  double avg = totalCaptureMs / frameCount;
+  std::cout << "capture: " << framesCaptured << " frames, " << framesDropped << " dropped\n";
+  std::cout << "capture: game thread avg " << avg << " ms, max " << maxCaptureMs << " ms (budget "
+            << CAPTURE_BUDGET_MS << " ms) " << (avg <= CAPTURE_BUDGET_MS ? "OK" : "OVER BUDGET") << "\n";
+  if (framesWritten > 0) {
+    std::cout << "capture: writer thread avg " << totalWriteMs / framesWritten << " ms per frame\n";
+  }
+}
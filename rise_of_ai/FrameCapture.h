@@ -0,0 +1,75 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//number of pixel buffers in the readback ring, a frame is mapped CAPTURE_PBO_COUNT - 1 frames after it was read
+#define CAPTURE_PBO_COUNT 3
+//number of frames that can wait for the writer thread before we start dropping
+#define CAPTURE_QUEUE_SIZE 8
+//time the capture is allowed to take on the game thread per frame
+#define CAPTURE_BUDGET_MS 1.0f
+
+enum CaptureFormat { CAPTURE_Y4M, CAPTURE_RGBA };
+
+class FrameCapture {
+public:
+    bool isCapturing = false;
+
+    int width = 0;
+    int height = 0;
+    CaptureFormat format = CAPTURE_Y4M;
+
+    //game thread stats
+    int frameCount = 0;
+    int framesCaptured = 0;
+    int framesDropped = 0;
+    double totalCaptureMs = 0.0;
+    double maxCaptureMs = 0.0;
+
+    //writer thread stats
+    int framesWritten = 0;
+    double totalWriteMs = 0.0;
+
+    bool Start(const char *filePath, int width, int height, int fps);
+    void Capture();
+    void Stop();
+    void Report();
+
+private:
+    FILE *file = NULL;
+
+    GLuint pbos[CAPTURE_PBO_COUNT];
+    int pboIndex = 0;
+    int pendingReads = 0;
+
+    //frames handed between the game thread and the writer thread
+    unsigned char *slots[CAPTURE_QUEUE_SIZE];
+    int queue[CAPTURE_QUEUE_SIZE];
+    int queueHead = 0;
+    int queueCount = 0;
+    int freeSlots[CAPTURE_QUEUE_SIZE];
+    int freeCount = 0;
+    bool stopWriter = false;
+
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable wake;
+
+    unsigned char *planes = NULL;
+
+    void ReadBack(int pbo);
+    void WriterLoop();
+    void WriteFrame(const unsigned char *pixels);
+};
@@ -0,0 +1,73 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+#include <string>
+#include <vector>
+
+#include "ImageDiff.h"
+
+#define GOLDEN_MAX_KEYS 8
+
+enum GoldenCommandType { GOLDEN_HOLD, GOLDEN_PRESS, GOLDEN_CAPTURE, GOLDEN_END };
+
+struct GoldenCommand {
+    int frame;
+    GoldenCommandType type;
+    int keyCount;
+    SDL_Scancode scancodes[GOLDEN_MAX_KEYS];
+    SDL_Keycode keycodes[GOLDEN_MAX_KEYS];
+};
+
+//drives the game from a script with one fixed step per frame, rendering offscreen,
+//and checks the captured frames against reference images
+class GoldenTest {
+public:
+    bool isRunning = false;
+    bool updateReferences = false;
+    int frame = 0;
+
+    //keyboard state for the current frame, used in place of SDL_GetKeyboardState
+    Uint8 keys[SDL_NUM_SCANCODES];
+
+    unsigned char tolerance[4] = { 2, 2, 2, 0 };
+
+    int framesChecked = 0;
+    int framesFailed = 0;
+    double diffMs = 0.0;
+
+    bool Start(const char *scriptPath, const char *referenceDir, bool update, int width, int height);
+    void BeginFrame();
+    bool PollEvent(SDL_Event *event);
+    bool EndFrame();
+    int Finish();
+
+private:
+    std::vector<GoldenCommand> commands;
+    size_t nextCommand = 0;
+    std::vector<SDL_Keycode> pressed;
+
+    std::string referenceDir;
+    //capture commands in the script, every one has to be checked for the run to pass
+    int captures = 0;
+    int width = 0;
+    int height = 0;
+
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    unsigned char *pixels = NULL;
+    unsigned char *flipped = NULL;
+    unsigned char *heatmap = NULL;
+
+    bool LoadScript(const char *scriptPath);
+    bool FindReferences();
+    std::string ReferencePath(int captureFrame);
+    void CheckFrame();
+};
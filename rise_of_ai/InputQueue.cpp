@@ -0,0 +1,93 @@
+#include "InputQueue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+InputQueue::InputQueue() {
+  memset(keys, 0, sizeof(keys));
+  memset(latestKeys, 0, sizeof(latestKeys));
+}
+
+void InputQueue::Pump(bool (*poll)(SDL_Event *event)) {
+  Uint64 now = SDL_GetPerformanceCounter();
+  Uint32 nowTicks = SDL_GetTicks();
+  Uint64 frequency = SDL_GetPerformanceFrequency();
+  lastKeyDown = 0;
+
+  SDL_Event event;
+  while (poll(&event)) {
+    //sdl stamps events in milliseconds when they are queued, carry that over to the counter
+    Uint64 time = now;
+    if (event.common.timestamp != 0 && event.common.timestamp <= nowTicks) {
+      Uint64 age = (Uint64)(nowTicks - event.common.timestamp) * frequency / 1000;
+      if (age < now) { time = now - age; }
+    }
+    //millisecond stamps can tie or go backwards against the last pump, keep the queue in order
+    if (time < lastTime) { time = lastTime; }
+    lastTime = time;
+
+    if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) {
+      latestKeys[event.key.keysym.scancode] = event.type == SDL_KEYDOWN;
+      if (event.type == SDL_KEYDOWN && event.key.repeat == 0) { lastKeyDown = time; }
+    }
+
+    if (count == INPUT_QUEUE_SIZE) {
+      dropped++;
+      continue;
+    }
+    TimedEvent &timed = events[(head + count) % INPUT_QUEUE_SIZE];
+    timed.time = time;
+    timed.event = event;
+    count++;
+  }
+}
+
+//hands out the oldest event from up to the given time and applies it to keys
+bool InputQueue::Next(Uint64 before, TimedEvent *timed) {
+  if (count == 0 || events[head].time > before) { return false; }
+
+  *timed = events[head];
+  SDL_Event *event = &timed->event;
+  head = (head + 1) % INPUT_QUEUE_SIZE;
+  count--;
+
+  if (event->type == SDL_KEYDOWN || event->type == SDL_KEYUP) {
+    keys[event->key.keysym.scancode] = event->type == SDL_KEYDOWN;
+  }
+  return true;
+}
+
+void LatencyMeter::Input(Uint64 time) {
+  //a press is only measured once, the first frame that shows it
+  if (isRunning == false || pending || time <= lastMeasured) { return; }
+  inputTime = time;
+  pending = true;
+}
+
+//call right after the swap
+void LatencyMeter::Presented() {
+  if (isRunning == false || pending == false) { return; }
+
+  glFinish();
+  Uint64 now = SDL_GetPerformanceCounter();
+  samples.push_back((double)(now - inputTime) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+  lastMeasured = inputTime;
+  pending = false;
+}
+
+void LatencyMeter::Report() {
+  if (isRunning == false) { return; }
+  if (samples.empty()) {
+    std::cout << "latency: no key presses measured\n";
+    return;
+  }
+
+  std::vector<double> sorted = samples;
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0.0;
+  for (size_t i = 0; i < sorted.size(); i++) { total += sorted[i]; }
+  std::cout << "latency: " << sorted.size() << " presses, input to photon avg " << total / sorted.size()
+            << " ms, p50 " << sorted[sorted.size() / 2] << " ms, p95 " << sorted[sorted.size() * 95 / 100]
+            << " ms, max " << sorted.back() << " ms\n";
+}
@@ -0,0 +1,63 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+#include <vector>
+
+#define INPUT_QUEUE_SIZE 256
+
+struct TimedEvent {
+    //performance counter time the event happened at
+    Uint64 time;
+    SDL_Event event;
+};
+
+//events stamped in performance counter time as they come off the sdl queue, then handed out
+//in order to the fixed step whose time window they fall in
+class InputQueue {
+public:
+    //key state as of the last event handed out, what a step should see
+    Uint8 keys[SDL_NUM_SCANCODES];
+    //key state as of the last event pumped, what the screen should see
+    Uint8 latestKeys[SDL_NUM_SCANCODES];
+    //newest key press found by the last Pump, 0 if there wasn't one
+    Uint64 lastKeyDown = 0;
+
+    int dropped = 0;
+
+    InputQueue();
+    void Pump(bool (*poll)(SDL_Event *event));
+    bool Next(Uint64 before, TimedEvent *timed);
+
+private:
+    TimedEvent events[INPUT_QUEUE_SIZE];
+    int head = 0;
+    int count = 0;
+    Uint64 lastTime = 0;
+};
+
+//input to photon: time from a key press to the end of the first frame that shows it,
+//waiting on the gpu after the swap so the frame has really been handed to the display
+class LatencyMeter {
+public:
+    bool isRunning = false;
+
+    //true while a press is waiting to be shown, the game draws a marker so a camera can check us
+    bool pending = false;
+
+    void Input(Uint64 time);
+    void Presented();
+    void Report();
+
+private:
+    Uint64 inputTime = 0;
+    Uint64 lastMeasured = 0;
+    std::vector<double> samples;
+};
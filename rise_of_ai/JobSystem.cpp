@@ -0,0 +1,157 @@
+#include "JobSystem.h"
+
+#include <SDL.h>
+#include <iostream>
+
+bool JobDeque::Push(const Job &job) {
+  int b = bottom.load(std::memory_order_relaxed);
+  int t = top.load(std::memory_order_acquire);
+  if (b - t >= JOB_DEQUE_SIZE) { return false; }
+  jobs[b & (JOB_DEQUE_SIZE - 1)] = job;
+  bottom.store(b + 1, std::memory_order_release);
+  return true;
+}
+
+bool JobDeque::Pop(Job *job) {
+  int b = bottom.load(std::memory_order_relaxed) - 1;
+  bottom.store(b, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int t = top.load(std::memory_order_relaxed);
+
+  if (t > b) {
+    //empty
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return false;
+  }
+
+  *job = jobs[b & (JOB_DEQUE_SIZE - 1)];
+  if (t == b) {
+    //last one, a thief may be after it too
+    bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+  }
+  return true;
+}
+
+bool JobDeque::Steal(Job *job) {
+  int t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  int b = bottom.load(std::memory_order_acquire);
+  if (t >= b) { return false; }
+
+  *job = jobs[t & (JOB_DEQUE_SIZE - 1)];
+  return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+void JobSystem::Start(int workers) {
+  if (workers <= 0) { workers = SDL_GetCPUCount(); }
+  if (workers < 1) { workers = 1; }
+  if (workers > JOB_WORKERS_MAX) { workers = JOB_WORKERS_MAX; }
+  workerCount = workers;
+  stopping = false;
+
+  //worker 0 is whoever calls ParallelFor
+  for (int i = 1; i < workerCount; i++) {
+    threads[i] = std::thread(&JobSystem::WorkerLoop, this, i);
+  }
+}
+
+void JobSystem::Stop() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (int i = 1; i < workerCount; i++) {
+    if (threads[i].joinable()) { threads[i].join(); }
+  }
+  workerCount = 1;
+}
+
+void JobSystem::ParallelFor(int count, int grain, JobFunction function, void *data) {
+  if (count <= 0) { return; }
+  if (grain < 1) { grain = 1; }
+  parallelFors++;
+
+  //not worth waking anyone
+  if (workerCount == 1 || count <= grain) {
+    for (int begin = 0; begin < count; begin += grain) {
+      function(data, begin, begin + grain < count ? begin + grain : count);
+      chunksRun++;
+    }
+    return;
+  }
+
+  Job job = { function, data, 0, count, grain };
+  pending.store(count, std::memory_order_relaxed);
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    generation++;
+  }
+  wake.notify_all();
+
+  //help out until every item is done
+  Run(0, job);
+  Job next;
+  while (pending.load(std::memory_order_acquire) > 0) {
+    if (FindJob(0, &next)) { Run(0, next); }
+    else { std::this_thread::yield(); }
+  }
+}
+
+bool JobSystem::FindJob(int worker, Job *job) {
+  if (deques[worker].Pop(job)) { return true; }
+  for (int i = 1; i < workerCount; i++) {
+    int victim = (worker + i) % workerCount;
+    if (deques[victim].Steal(job)) {
+      steals++;
+      return true;
+    }
+  }
+  return false;
+}
+
+void JobSystem::Run(int worker, Job job) {
+  //keep the front half and leave the back half for whoever is free, splitting on chunk edges
+  int chunks = ChunkCount(job.end - job.begin, job.grain);
+  while (chunks > 1) {
+    int split = job.begin + (chunks / 2) * job.grain;
+    Job back = job;
+    back.begin = split;
+    if (deques[worker].Push(back) == false) { break; }
+    job.end = split;
+    chunks = ChunkCount(job.end - job.begin, job.grain);
+  }
+
+  //deque full, do the rest here a chunk at a time
+  for (int begin = job.begin; begin < job.end; begin += job.grain) {
+    int end = begin + job.grain < job.end ? begin + job.grain : job.end;
+    job.function(job.data, begin, end);
+    chunksRun++;
+    pending.fetch_sub(end - begin, std::memory_order_acq_rel);
+  }
+}
+
+void JobSystem::WorkerLoop(int worker) {
+  int seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      wake.wait(guard, [&] { return stopping || generation != seen; });
+      if (stopping) { return; }
+      seen = generation;
+    }
+
+    Job job;
+    while (pending.load(std::memory_order_acquire) > 0) {
+      if (FindJob(worker, &job)) { Run(worker, job); }
+      else { std::this_thread::yield(); }
+    }
+  }
+}
+
+void JobSystem::Report() {
+  std::cout << "jobs: " << workerCount << " workers, " << parallelFors << " parallel fors, " << chunksRun
+            << " chunks, " << steals << " stolen\n";
+}
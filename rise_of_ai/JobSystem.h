@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//jobs a deque can hold before Push says no, a power of two
+#define JOB_DEQUE_SIZE 1024
+#define JOB_WORKERS_MAX 32
+
+//runs over items begin to end, always one whole chunk so begin / grain can index per chunk results
+typedef void (*JobFunction)(void *data, int begin, int end);
+
+struct Job {
+    JobFunction function;
+    void *data;
+    int begin;
+    int end;
+    int grain;
+};
+
+//chase-lev deque, the owning worker pushes and pops at the bottom and everyone else steals
+//from the top, only the last job left needs a compare and swap to settle who gets it
+class JobDeque {
+public:
+    bool Push(const Job &job);
+    bool Pop(Job *job);
+    bool Steal(Job *job);
+
+private:
+    Job jobs[JOB_DEQUE_SIZE];
+    alignas(64) std::atomic<int> top{ 0 };
+    alignas(64) std::atomic<int> bottom{ 0 };
+};
+
+//a fixed set of threads working through parallel-for ranges
+//a range is split in half until it is one chunk, the halves are left on the splitting worker's
+//deque for idle workers to steal, so big ranges spread out and small ones stay put
+//jobs must only write their own items, anything shared is collected per item or per chunk
+//and applied by the caller afterwards in a fixed order, so the results don't depend on who ran what
+class JobSystem {
+public:
+    //threads including the one calling ParallelFor, 1 runs everything inline
+    int workerCount = 1;
+
+    //telemetry
+    long long parallelFors = 0;
+    std::atomic<long long> chunksRun{ 0 };
+    std::atomic<long long> steals{ 0 };
+
+    //0 picks one worker per cpu
+    void Start(int workers);
+    void Stop();
+
+    //calls function on every chunk of grain items in 0 to count and returns when they are all done
+    void ParallelFor(int count, int grain, JobFunction function, void *data);
+    static int ChunkCount(int count, int grain) { return (count + grain - 1) / grain; }
+
+    void Report();
+
+private:
+    JobDeque deques[JOB_WORKERS_MAX];
+    std::thread threads[JOB_WORKERS_MAX];
+
+    std::mutex lock;
+    std::condition_variable wake;
+    //bumped for every ParallelFor, sleeping workers wake when it changes
+    int generation = 0;
+    bool stopping = false;
+    //items of the current ParallelFor not done yet
+    std::atomic<int> pending{ 0 };
+
+    void WorkerLoop(int worker);
+    bool FindJob(int worker, Job *job);
+    void Run(int worker, Job job);
+};
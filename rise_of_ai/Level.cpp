@@ -0,0 +1,224 @@
+#include "Level.h"
+#include "Simulation.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static const char LEVEL_MAGIC[4] = { 'R', 'A', 'I', 'L' };
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+//snipers come in from the top a little faster each, bombers sweep in from the left one after
+//another, and the boss waits above the screen
+static const LevelSpawn DEFAULT_ENEMIES[ENEMY_COUNT] = {
+  { SNIPER, ENTERING, 0.0f, 40.0f, 1.0f, 0.0f, 0.95f, 2.0f, 1, 1 },
+  { SNIPER, ENTERING, 0.0f, 41.0f, 1.0f, 0.0f, 0.95f, 3.0f, 1, 1 },
+  { SNIPER, ENTERING, 0.0f, 42.0f, 1.0f, 0.0f, 0.95f, 4.0f, 1, 1 },
+  { SNIPER, ENTERING, 0.0f, 43.0f, 1.0f, 0.0f, 0.95f, 5.0f, 1, 1 },
+  { BOMBER, ENTERING, -19.5f, 98.0f, 0.0f, 0.0f, 0.95f, 15.0f, 1, 1 },
+  { BOMBER, ENTERING, -19.5f, 125.0f, 0.0f, 0.0f, 0.95f, 15.0f, 1, 1 },
+  { BOMBER, ENTERING, -19.5f, 152.0f, 0.0f, 0.0f, 0.95f, 15.0f, 1, 1 },
+  { BOMBER, ENTERING, -19.5f, 179.0f, 0.0f, 0.0f, 0.95f, 15.0f, 1, 1 },
+  { BOMBER, ENTERING, -19.5f, 206.0f, 0.0f, 0.0f, 0.95f, 15.0f, 1, 1 },
+  { BOSS, IDLE, 0.0f, 18.0f, 0.0f, 0.0f, 0.95f, 4.0f, 1, 3 },
+};
+
+static const LevelHeader DEFAULT_HEADER = {
+  { 'R', 'A', 'I', 'L' }, LEVEL_VERSION,
+  BULLET_COUNT, 16.0f, 0.3f,
+  ENEMY_BULLET_COUNT, 16.0f, 0.3f,
+  4,
+  { 0, 0, 0.0f, -10.0f, 0.0f, 0.0f, 0.95f, 8.0f, 3, 1 },
+  ENEMY_COUNT, 0,
+  { "player.png", "goon2.png", "goon1.png", "boss.png", "bullet.png", "enemy_bullet.png" },
+};
+
+const Level &DefaultLevel() {
+  static Level level;
+  level.header = &DEFAULT_HEADER;
+  level.enemies = DEFAULT_ENEMIES;
+  return level;
+}
+
+//64 bit fnv-1a
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t size) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001B3ull;
+  }
+  return hash;
+}
+
+uint64_t LevelHash(const Level &level) {
+  LevelHeader header = *level.header;
+  header.enemyOffset = 0;
+  uint64_t hash = HashBytes(0xCBF29CE484222325ull, &header, sizeof(header));
+  return HashBytes(hash, level.enemies, header.enemyCount * sizeof(LevelSpawn));
+}
+
+bool LevelFile::Open(const char *filePath) {
+  Close();
+  Uint64 start = SDL_GetPerformanceCounter();
+  if (file.Open(filePath) == false) { return false; }
+
+  const LevelHeader *header = (const LevelHeader *)file.data;
+  const char *problem = NULL;
+  if (file.size < sizeof(LevelHeader) || memcmp(header->magic, LEVEL_MAGIC, 4) != 0) {
+    problem = "it isn't a level from this game";
+  } else if (header->version != LEVEL_VERSION) {
+    problem = "it was compiled for a different version, compile it again";
+  } else if (header->enemyOffset % 4 != 0 ||
+             (size_t)header->enemyOffset + (size_t)header->enemyCount * sizeof(LevelSpawn) > file.size) {
+    problem = "its enemies are past the end of the file";
+  } else if (header->bulletCount == 0 || header->enemyBulletCount == 0) {
+    problem = "it has no room for bullets";
+  }
+  for (int t = 0; t < LEVEL_TEXTURE_COUNT && problem == NULL; t++) {
+    if (memchr(header->textures[t], 0, LEVEL_PATH_LENGTH) == NULL) { problem = "a texture path isn't terminated"; }
+  }
+
+  const LevelSpawn *enemies = (const LevelSpawn *)(file.data + (problem == NULL ? header->enemyOffset : 0));
+  int bosses = 0;
+  for (uint32_t i = 0; i < header->enemyCount && problem == NULL; i++) {
+    if (enemies[i].enemyType > BOSS) { problem = "an enemy has a type this game doesn't have"; }
+    if (enemies[i].enemyType == BOSS) { bosses++; }
+  }
+  if (problem == NULL && bosses != 1) { problem = "it needs exactly one boss"; }
+
+  if (problem != NULL) {
+    std::cout << "Unable to load level " << filePath << ", " << problem << "\n";
+    Close();
+    return false;
+  }
+
+  level.header = header;
+  level.enemies = enemies;
+  openMs = ElapsedMs(start);
+  return true;
+}
+
+void LevelFile::Close() {
+  file.Close();
+  level = Level();
+}
+
+static bool ReadSpawn(std::istringstream &words, LevelSpawn *spawn, bool isEnemy) {
+  if (isEnemy) {
+    float vx;
+    float vy;
+    if (!(words >> spawn->x >> spawn->y >> vx >> vy)) { return false; }
+    spawn->vx = vx;
+    spawn->vy = vy;
+  } else if (!(words >> spawn->x >> spawn->y)) {
+    return false;
+  }
+  return (bool)(words >> spawn->size >> spawn->speed >> spawn->health >> spawn->shotPower);
+}
+
+bool CompileLevel(const char *sourcePath, const char *outPath) {
+  std::ifstream infile(sourcePath);
+  if (infile.fail()) {
+    std::cout << "level: unable to open " << sourcePath << "\n";
+    return false;
+  }
+
+  LevelHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, LEVEL_MAGIC, 4);
+  header.version = LEVEL_VERSION;
+  std::vector<LevelSpawn> enemies;
+  const char *textureNames[LEVEL_TEXTURE_COUNT] = { "player", "sniper", "bomber", "boss", "bullet", "enemy_bullet" };
+  const char *enemyNames[] = { "bomber", "sniper", "boss" };
+  bool hasPlayer = false;
+
+  std::string line;
+  int lineNumber = 0;
+  while (std::getline(infile, line)) {
+    lineNumber++;
+    std::istringstream words(line);
+    std::string first;
+    if (!(words >> first) || first[0] == '#') { continue; }
+
+    bool valid = false;
+    if (first == "texture") {
+      std::string name;
+      std::string path;
+      words >> name >> path;
+      for (int t = 0; t < LEVEL_TEXTURE_COUNT; t++) {
+        if (name == textureNames[t] && path.empty() == false && path.size() < LEVEL_PATH_LENGTH) {
+          memset(header.textures[t], 0, LEVEL_PATH_LENGTH);
+          memcpy(header.textures[t], path.c_str(), path.size());
+          valid = true;
+        }
+      }
+    } else if (first == "bullets") {
+      valid = (bool)(words >> header.bulletCount >> header.bulletSpeed >> header.bulletSize);
+    } else if (first == "enemy_bullets") {
+      valid = (bool)(words >> header.enemyBulletCount >> header.enemyBulletSpeed >> header.enemyBulletSize);
+    } else if (first == "boss_after") {
+      valid = (bool)(words >> header.bossAfter);
+    } else if (first == "player") {
+      valid = ReadSpawn(words, &header.player, false);
+      hasPlayer = valid;
+    } else if (first == "enemy") {
+      std::string type;
+      words >> type;
+      LevelSpawn enemy;
+      memset(&enemy, 0, sizeof(enemy));
+      for (uint32_t e = 0; e < 3; e++) {
+        if (type == enemyNames[e]) { enemy.enemyType = e; }
+      }
+      //the boss waits for boss_after enemies to die, everyone else flies straight in
+      enemy.enemyState = enemy.enemyType == BOSS ? IDLE : ENTERING;
+      valid = (type == "bomber" || type == "sniper" || type == "boss") && ReadSpawn(words, &enemy, true);
+      if (valid) { enemies.push_back(enemy); }
+    }
+
+    if (valid == false) {
+      std::cout << "level: " << sourcePath << " line " << lineNumber << " doesn't make sense: " << line << "\n";
+      return false;
+    }
+  }
+
+  int bosses = 0;
+  for (size_t i = 0; i < enemies.size(); i++) { bosses += enemies[i].enemyType == BOSS ? 1 : 0; }
+  const char *problem = NULL;
+  if (hasPlayer == false) { problem = "has no player"; }
+  else if (bosses != 1) { problem = "needs exactly one boss"; }
+  else if (header.bulletCount == 0 || header.enemyBulletCount == 0) { problem = "needs bullets and enemy_bullets"; }
+  for (int t = 0; t < LEVEL_TEXTURE_COUNT && problem == NULL; t++) {
+    if (header.textures[t][0] == 0) { problem = "is missing a texture"; }
+  }
+  if (problem != NULL) {
+    std::cout << "level: " << sourcePath << " " << problem << "\n";
+    return false;
+  }
+
+  header.enemyCount = (uint32_t)enemies.size();
+  header.enemyOffset = sizeof(header);
+
+  FILE *file = fopen(outPath, "wb");
+  if (file == NULL) {
+    std::cout << "level: unable to open " << outPath << "\n";
+    return false;
+  }
+  fwrite(&header, sizeof(header), 1, file);
+  if (enemies.empty() == false) { fwrite(enemies.data(), sizeof(LevelSpawn), enemies.size(), file); }
+  bool written = ferror(file) == 0;
+  fclose(file);
+  if (written == false) {
+    std::cout << "level: unable to write " << outPath << "\n";
+    return false;
+  }
+  std::cout << "level: " << outPath << ", " << enemies.size() << " enemies, "
+            << sizeof(header) + enemies.size() * sizeof(LevelSpawn) << " bytes\n";
+  return true;
+}
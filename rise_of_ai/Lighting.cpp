@@ -0,0 +1,164 @@
+#include "Lighting.h"
+
+#include <cstring>
+
+void Lighting::Load(int width, int height, float orthoWidth, float orthoHeight) {
+  this->width = width;
+  this->height = height;
+  this->orthoWidth = orthoWidth;
+  this->orthoHeight = orthoHeight;
+
+  //fullscreen quad is given in clip space
+  program.Load("shaders/vertex.glsl", "shaders/fragment_lights.glsl");
+  program.SetProjectionMatrix(glm::mat4(1.0f));
+  program.SetViewMatrix(glm::mat4(1.0f));
+  program.SetModelMatrix(glm::mat4(1.0f));
+
+  tileLightsUniform = glGetUniformLocation(program.programID, "tileLights");
+  tileTextureSizeUniform = glGetUniformLocation(program.programID, "tileTextureSize");
+  lightsUniform = glGetUniformLocation(program.programID, "lights");
+  lightColorsUniform = glGetUniformLocation(program.programID, "lightColors");
+
+  tilesX = (width + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+  tilesY = (height + LIGHT_TILE_SIZE - 1) / LIGHT_TILE_SIZE;
+  tileData = new unsigned char[tilesX * tilesY * 8];
+  memset(tileData, 0, tilesX * tilesY * 8);
+
+  glGenTextures(1, &tileTexture);
+  glBindTexture(GL_TEXTURE_2D, tileTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tilesX * 2, tilesY, 0, GL_RGBA, GL_UNSIGNED_BYTE, tileData);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glUseProgram(program.programID);
+  glUniform1i(tileLightsUniform, 0);
+  glUniform2f(tileTextureSizeUniform, (float)(tilesX * 2), (float)tilesY);
+}
+
+//the tile grid is sized at load, a smaller viewport just leaves the outer tiles unused
+void Lighting::SetViewport(int width, int height) {
+  this->width = width;
+  this->height = height;
+}
+
+//light that only lasts for the frame it was added in, like a bullet glow
+void Lighting::AddLight(glm::vec3 position, float radius, glm::vec3 color, float intensity) {
+  if (frameLightCount == LIGHT_MAX) { return; }
+
+  Light &light = frameLights[frameLightCount++];
+  light.position = position;
+  light.radius = radius;
+  light.color = color;
+  light.intensity = intensity;
+}
+
+//light that fades out over its life, like a muzzle flash or an explosion
+void Lighting::AddFlash(glm::vec3 position, float radius, glm::vec3 color, float intensity, float life) {
+  if (flashCount == FLASH_MAX) { return; }
+
+  Flash &flash = flashes[flashCount++];
+  flash.light.position = position;
+  flash.light.radius = radius;
+  flash.light.color = color;
+  flash.light.intensity = intensity;
+  flash.life = life;
+  flash.maxLife = life;
+}
+
+void Lighting::Update(float deltaTime) {
+  for (int i = 0; i < flashCount; i++) {
+    flashes[i].life -= deltaTime;
+    if (flashes[i].life <= 0.0f) {
+      flashes[i] = flashes[--flashCount];
+      i--;
+    }
+  }
+}
+
+void Lighting::Build() {
+  //flashes go first since they are the ones that matter most when we run out of room
+  lightCount = 0;
+  for (int i = 0; i < flashCount && lightCount < maxLights; i++) {
+    lights[lightCount] = flashes[i].light;
+    lights[lightCount].intensity *= flashes[i].life / flashes[i].maxLife;
+    lightCount++;
+  }
+  for (int i = 0; i < frameLightCount && lightCount < maxLights; i++) {
+    lights[lightCount++] = frameLights[i];
+  }
+  frameLightCount = 0;
+
+  memset(tileData, 0, tilesX * tilesY * 8);
+  tileRefs = 0;
+  tileOverflows = 0;
+
+  float pixelsPerUnit = width / (orthoWidth * 2.0f);
+  for (int i = 0; i < lightCount; i++) {
+    //world to window pixels, same mapping as the ortho projection
+    float x = (lights[i].position.x + orthoWidth) * pixelsPerUnit;
+    float y = (lights[i].position.y + orthoHeight) * (height / (orthoHeight * 2.0f));
+    float radius = lights[i].radius * pixelsPerUnit;
+
+    lightData[i * 4] = x;
+    lightData[i * 4 + 1] = y;
+    lightData[i * 4 + 2] = radius;
+    lightData[i * 4 + 3] = lights[i].intensity;
+    colorData[i * 3] = lights[i].color.r;
+    colorData[i * 3 + 1] = lights[i].color.g;
+    colorData[i * 3 + 2] = lights[i].color.b;
+
+    int x0 = (int)((x - radius) / LIGHT_TILE_SIZE);
+    int x1 = (int)((x + radius) / LIGHT_TILE_SIZE);
+    int y0 = (int)((y - radius) / LIGHT_TILE_SIZE);
+    int y1 = (int)((y + radius) / LIGHT_TILE_SIZE);
+    if (x0 < 0) { x0 = 0; }
+    if (y0 < 0) { y0 = 0; }
+    if (x1 >= tilesX) { x1 = tilesX - 1; }
+    if (y1 >= tilesY) { y1 = tilesY - 1; }
+
+    for (int ty = y0; ty <= y1; ty++) {
+      for (int tx = x0; tx <= x1; tx++) {
+        //skip the corner tiles the circle's bounding box covers but the circle doesn't
+        float nearX = glm::clamp(x, (float)(tx * LIGHT_TILE_SIZE), (float)((tx + 1) * LIGHT_TILE_SIZE));
+        float nearY = glm::clamp(y, (float)(ty * LIGHT_TILE_SIZE), (float)((ty + 1) * LIGHT_TILE_SIZE));
+        if ((nearX - x) * (nearX - x) + (nearY - y) * (nearY - y) > radius * radius) { continue; }
+
+        unsigned char *tile = tileData + (ty * tilesX + tx) * 8;
+        if (tile[0] == LIGHT_TILE_MAX) {
+          tileOverflows++;
+          continue;
+        }
+        tile[1 + tile[0]] = (unsigned char)i;
+        tile[0]++;
+        tileRefs++;
+      }
+    }
+  }
+
+  glBindTexture(GL_TEXTURE_2D, tileTexture);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tilesX * 2, tilesY, GL_RGBA, GL_UNSIGNED_BYTE, tileData);
+}
+
+//call after the scene is drawn
+void Lighting::Render() {
+  Build();
+  if (lightCount == 0) { return; }
+
+  glUseProgram(program.programID);
+  glUniform4fv(lightsUniform, lightCount, lightData);
+  glUniform3fv(lightColorsUniform, lightCount, colorData);
+
+  float vertices[] = { -1.0f, -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, 1.0f };
+
+  glBindTexture(GL_TEXTURE_2D, tileTexture);
+  glBlendFunc(GL_ONE, GL_ONE);
+
+  glVertexAttribPointer(program.positionAttribute, 2, GL_FLOAT, false, 0, vertices);
+  glEnableVertexAttribArray(program.positionAttribute);
+  glDrawArrays(GL_TRIANGLES, 0, 6);
+  glDisableVertexAttribArray(program.positionAttribute);
+
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
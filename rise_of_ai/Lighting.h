@@ -0,0 +1,82 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "ShaderProgram.h"
+
+//these have to match shaders/fragment_lights.glsl
+#define LIGHT_MAX 64
+#define LIGHT_TILE_SIZE 32
+//a tile is 2 rgba texels, one byte for the count and 7 light indices
+#define LIGHT_TILE_MAX 7
+
+#define FLASH_MAX 32
+
+struct Light {
+    glm::vec3 position;
+    float radius;
+    glm::vec3 color;
+    float intensity;
+};
+
+struct Flash {
+    Light light;
+    float life;
+    float maxLife;
+};
+
+//2d lights binned into screen tiles on the cpu, then shaded in one additive fullscreen pass
+//where each pixel only looks at the lights of its own tile
+class Lighting {
+public:
+    //lights past this are ignored for the frame
+    int maxLights = LIGHT_MAX;
+
+    //stats for the last built frame
+    int lightCount = 0;
+    int tileRefs = 0;
+    int tileOverflows = 0;
+
+    void Load(int width, int height, float orthoWidth, float orthoHeight);
+    void SetViewport(int width, int height);
+    void AddLight(glm::vec3 position, float radius, glm::vec3 color, float intensity);
+    void AddFlash(glm::vec3 position, float radius, glm::vec3 color, float intensity, float life);
+    void Update(float deltaTime);
+    void Render();
+
+private:
+    ShaderProgram program;
+    GLuint tileLightsUniform;
+    GLuint tileTextureSizeUniform;
+    GLuint lightsUniform;
+    GLuint lightColorsUniform;
+
+    int width;
+    int height;
+    float orthoWidth;
+    float orthoHeight;
+
+    int tilesX;
+    int tilesY;
+    GLuint tileTexture;
+    unsigned char *tileData;
+
+    Light lights[LIGHT_MAX];
+    Light frameLights[LIGHT_MAX];
+    int frameLightCount = 0;
+    float lightData[LIGHT_MAX * 4];
+    float colorData[LIGHT_MAX * 3];
+
+    Flash flashes[FLASH_MAX];
+    int flashCount = 0;
+
+    void Build();
+};
@@ -0,0 +1,307 @@
+#include "MusicStream.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+bool MusicPlayer::Start(int frequency) {
+  this->frequency = frequency;
+
+  //allocated once here, nothing the worker or the callback does after this allocates
+  for (int d = 0; d < MUSIC_DECKS; d++) {
+    decks[d].ring = new float[MUSIC_RING_FRAMES * 2];
+  }
+
+  isRunning = true;
+  worker = std::thread(&MusicPlayer::WorkerLoop, this);
+  return true;
+}
+
+//crossfades from whatever is playing over fadeSeconds
+void MusicPlayer::Play(const char *path, bool loop, float fadeSeconds) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (isRunning == false) { return; }
+
+  request.path = path;
+  request.loop = loop;
+  request.fadeSeconds = fadeSeconds;
+  hasRequest = true;
+  wake.notify_one();
+}
+
+void MusicPlayer::Stop(float fadeSeconds) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (isRunning == false) { return; }
+
+  request.path.clear();
+  request.fadeSeconds = fadeSeconds;
+  hasRequest = true;
+  wake.notify_one();
+}
+
+void MusicPlayer::Close() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (isRunning == false) { return; }
+    isRunning = false;
+  }
+  wake.notify_one();
+  worker.join();
+
+  for (int d = 0; d < MUSIC_DECKS; d++) {
+    delete[] decks[d].ring;
+    decks[d].ring = NULL;
+  }
+}
+
+static Uint32 ReadLE(const unsigned char *bytes, int count) {
+  Uint32 value = 0;
+  for (int i = count - 1; i >= 0; i--) { value = (value << 8) | bytes[i]; }
+  return value;
+}
+
+//reads the wav header and leaves the file at the start of the samples
+bool MusicPlayer::OpenTrack(MusicDeck &deck, const MusicRequest &request) {
+  deck.file = fopen(request.path.c_str(), "rb");
+  if (deck.file == NULL) {
+    std::cout << "Unable to open music " << request.path << "\n";
+    return false;
+  }
+
+  unsigned char header[16];
+  if (fread(header, 1, 12, deck.file) != 12 || memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0) {
+    std::cout << "Unable to read music " << request.path << ", not a wav file\n";
+    CloseTrack(deck);
+    return false;
+  }
+
+  SDL_AudioFormat format = 0;
+  int channels = 0;
+  int rate = 0;
+  deck.dataSize = 0;
+  while (fread(header, 1, 8, deck.file) == 8) {
+    Uint32 size = ReadLE(header + 4, 4);
+    if (memcmp(header, "fmt ", 4) == 0 && size >= 16) {
+      if (fread(header, 1, 16, deck.file) != 16) { break; }
+      int tag = ReadLE(header, 2);
+      int bits = ReadLE(header + 14, 2);
+      channels = ReadLE(header + 2, 2);
+      rate = ReadLE(header + 4, 4);
+      if (tag == 1 && bits == 16) { format = AUDIO_S16LSB; }
+      if (tag == 1 && bits == 8) { format = AUDIO_U8; }
+      fseek(deck.file, size - 16 + (size & 1), SEEK_CUR);
+    } else if (memcmp(header, "data", 4) == 0) {
+      deck.dataStart = ftell(deck.file);
+      deck.dataSize = size;
+      break;
+    } else {
+      fseek(deck.file, size + (size & 1), SEEK_CUR);
+    }
+  }
+
+  if (format == 0 || channels < 1 || channels > 2 || deck.dataSize == 0) {
+    std::cout << "Unable to read music " << request.path << ", only 8 and 16 bit pcm wav is supported\n";
+    CloseTrack(deck);
+    return false;
+  }
+
+  //the converter only takes whole frames
+  int frameBytes = channels * (format == AUDIO_U8 ? 1 : 2);
+  deck.dataSize -= deck.dataSize % frameBytes;
+  deck.dataLeft = deck.dataSize;
+
+  deck.stream = SDL_NewAudioStream(format, (Uint8)channels, rate, AUDIO_F32SYS, 2, frequency);
+  if (deck.stream == NULL) {
+    std::cout << "Unable to convert music " << request.path << ": " << SDL_GetError() << "\n";
+    CloseTrack(deck);
+    return false;
+  }
+
+  deck.loop = request.loop;
+  deck.fileDone = false;
+  deck.ended.store(false, std::memory_order_relaxed);
+  deck.writeIndex.store(0, std::memory_order_relaxed);
+  deck.readIndex.store(0, std::memory_order_relaxed);
+  return true;
+}
+
+void MusicPlayer::CloseTrack(MusicDeck &deck) {
+  if (deck.stream != NULL) {
+    SDL_FreeAudioStream(deck.stream);
+    deck.stream = NULL;
+  }
+  if (deck.file != NULL) {
+    fclose(deck.file);
+    deck.file = NULL;
+  }
+}
+
+//decodes until the ring is full or the track is done
+void MusicPlayer::Fill(MusicDeck &deck) {
+  if (deck.stream == NULL) { return; }
+
+  while (true) {
+    Uint32 write = deck.writeIndex.load(std::memory_order_relaxed);
+    Uint32 space = MUSIC_RING_FRAMES - (write - deck.readIndex.load(std::memory_order_acquire));
+    if (space < MUSIC_CHUNK_FRAMES) { return; }
+
+    int frames = SDL_AudioStreamGet(deck.stream, chunk, sizeof(chunk)) / (int)(sizeof(float) * 2);
+    if (frames <= 0) {
+      if (deck.fileDone) {
+        deck.ended.store(true, std::memory_order_release);
+        return;
+      }
+
+      Uint32 want = deck.dataLeft < MUSIC_READ_BYTES ? deck.dataLeft : MUSIC_READ_BYTES;
+      size_t bytes = want > 0 ? fread(readBuffer, 1, want, deck.file) : 0;
+      if (bytes > 0) {
+        deck.dataLeft -= (Uint32)bytes;
+        SDL_AudioStreamPut(deck.stream, readBuffer, (int)bytes);
+      } else if (deck.loop) {
+        //keep feeding the same converter from the top, so the loop point has no gap or reset in it
+        fseek(deck.file, deck.dataStart, SEEK_SET);
+        deck.dataLeft = deck.dataSize;
+        loops++;
+      } else {
+        SDL_AudioStreamFlush(deck.stream);
+        deck.fileDone = true;
+      }
+      continue;
+    }
+
+    for (int i = 0; i < frames; i++) {
+      Uint32 index = (write + i) & (MUSIC_RING_FRAMES - 1);
+      deck.ring[index * 2] = chunk[i * 2];
+      deck.ring[index * 2 + 1] = chunk[i * 2 + 1];
+    }
+    deck.writeIndex.store(write + frames, std::memory_order_release);
+  }
+}
+
+//returns false if the request has to wait for a deck to free up
+bool MusicPlayer::StartTrack(const MusicRequest &request) {
+  int fade = (int)(request.fadeSeconds * frequency);
+  if (fade < 1) { fade = 1; }
+
+  int target = -1;
+  if (request.path.empty() == false) {
+    for (int d = 0; d < MUSIC_DECKS; d++) {
+      if (decks[d].state.load(std::memory_order_acquire) == DECK_IDLE) {
+        target = d;
+        break;
+      }
+    }
+    //both decks busy means one is still fading out, it will be idle shortly
+    if (target < 0) { return false; }
+
+    MusicDeck &deck = decks[target];
+    CloseTrack(deck);
+    deck.state.store(DECK_LOADING, std::memory_order_relaxed);
+    if (OpenTrack(deck, request) == false) {
+      deck.state.store(DECK_IDLE, std::memory_order_release);
+      return true;
+    }
+    //start with a full ring so the fade in never waits on the disk
+    Fill(deck);
+  }
+
+  //the callback may be moving these from fading in to playing or from playing to idle at the same time
+  for (int d = 0; d < MUSIC_DECKS; d++) {
+    if (d == target) { continue; }
+    int state = decks[d].state.load(std::memory_order_acquire);
+    if (state == DECK_FADING_IN || state == DECK_PLAYING) {
+      decks[d].fadeFrames.store(fade, std::memory_order_relaxed);
+      decks[d].state.compare_exchange_strong(state, DECK_FADING_OUT, std::memory_order_release);
+    }
+  }
+
+  if (target >= 0) {
+    decks[target].fadeFrames.store(fade, std::memory_order_relaxed);
+    decks[target].state.store(DECK_FADING_IN, std::memory_order_release);
+    tracksStarted++;
+  }
+  return true;
+}
+
+void MusicPlayer::WorkerLoop() {
+  MusicRequest pending;
+  bool hasPending = false;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      //wake up on requests, otherwise often enough to keep the rings well ahead of the callback
+      wake.wait_for(guard, std::chrono::milliseconds(5), [this] { return hasRequest || isRunning == false; });
+      if (isRunning == false) { break; }
+      if (hasRequest) {
+        pending = request;
+        hasPending = true;
+        hasRequest = false;
+      }
+    }
+
+    if (hasPending && StartTrack(pending)) { hasPending = false; }
+
+    for (int d = 0; d < MUSIC_DECKS; d++) {
+      int state = decks[d].state.load(std::memory_order_acquire);
+      if (state == DECK_IDLE) {
+        CloseTrack(decks[d]);
+      } else if (state != DECK_LOADING) {
+        Fill(decks[d]);
+      }
+    }
+  }
+
+  for (int d = 0; d < MUSIC_DECKS; d++) { CloseTrack(decks[d]); }
+}
+
+//runs in the audio callback, adds the decks on top of the effects
+void MusicPlayer::Mix(float *out, int frames) {
+  bool starved = false;
+
+  for (int d = 0; d < MUSIC_DECKS; d++) {
+    MusicDeck &deck = decks[d];
+    int state = deck.state.load(std::memory_order_acquire);
+    if (state == DECK_IDLE || state == DECK_LOADING) { continue; }
+
+    Uint32 read = deck.readIndex.load(std::memory_order_relaxed);
+    Uint32 write = deck.writeIndex.load(std::memory_order_acquire);
+    bool ended = deck.ended.load(std::memory_order_acquire);
+    int count = (int)(write - read);
+    if (count > frames) { count = frames; }
+    if (count < frames && ended == false) { starved = true; }
+
+    float step = 1.0f / deck.fadeFrames.load(std::memory_order_relaxed);
+    float gain = deck.gain;
+    for (int i = 0; i < count; i++) {
+      if (state == DECK_FADING_IN) {
+        gain += step;
+        if (gain > 1.0f) { gain = 1.0f; }
+      } else if (state == DECK_FADING_OUT) {
+        gain -= step;
+        if (gain < 0.0f) { gain = 0.0f; }
+      }
+      Uint32 index = (read + i) & (MUSIC_RING_FRAMES - 1);
+      out[i * 2] += deck.ring[index * 2] * gain * volume;
+      out[i * 2 + 1] += deck.ring[index * 2 + 1] * gain * volume;
+    }
+    deck.gain = gain;
+    read += count;
+    deck.readIndex.store(read, std::memory_order_release);
+
+    if (state == DECK_FADING_IN && gain >= 1.0f) {
+      deck.state.compare_exchange_strong(state, DECK_PLAYING, std::memory_order_acq_rel);
+    } else if ((state == DECK_FADING_OUT && gain <= 0.0f) || (ended && read == write)) {
+      //hand the deck back to the worker
+      if (deck.state.compare_exchange_strong(state, DECK_IDLE, std::memory_order_acq_rel)) { deck.gain = 0.0f; }
+    }
+  }
+
+  if (starved) { starvedCallbacks++; }
+}
+
+void MusicPlayer::Report() {
+  if (frequency == 0) { return; }
+  std::cout << "music: " << tracksStarted << " tracks started, " << loops << " loops, " << starvedCallbacks
+            << " starved callbacks, " << MUSIC_RING_FRAMES * 2 * sizeof(float) / 1024 << " KB ring per deck\n";
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//frames of decoded stereo the worker keeps ahead of the callback, about 370 ms at 44100
+#define MUSIC_RING_FRAMES 16384
+//frames the worker decodes at a time
+#define MUSIC_CHUNK_FRAMES 1024
+#define MUSIC_READ_BYTES 4096
+#define MUSIC_DECKS 2
+
+enum DeckState { DECK_IDLE, DECK_LOADING, DECK_FADING_IN, DECK_PLAYING, DECK_FADING_OUT };
+
+//one track being streamed, the worker writes the ring and the callback reads it
+struct MusicDeck {
+    std::atomic<int> state{ DECK_IDLE };
+    std::atomic<int> fadeFrames{ 1 };
+    //set once a track that doesn't loop has been fully decoded
+    std::atomic<bool> ended{ false };
+
+    //frame counters that only grow, the ring position is the counter masked
+    std::atomic<Uint32> writeIndex{ 0 };
+    std::atomic<Uint32> readIndex{ 0 };
+    float *ring = NULL;
+
+    //callback only
+    float gain = 0.0f;
+
+    //worker only
+    FILE *file = NULL;
+    SDL_AudioStream *stream = NULL;
+    long dataStart = 0;
+    Uint32 dataSize = 0;
+    Uint32 dataLeft = 0;
+    bool loop = false;
+    bool fileDone = false;
+};
+
+struct MusicRequest {
+    std::string path;
+    bool loop;
+    float fadeSeconds;
+};
+
+//streams wav tracks from disk through a worker thread into fixed rings, so memory stays the same
+//however long the track is. switching tracks crossfades between the two decks
+class MusicPlayer {
+public:
+    float volume = 0.5f;
+
+    //callback stats
+    std::atomic<int> starvedCallbacks{ 0 };
+    //worker stats
+    int tracksStarted = 0;
+    int loops = 0;
+
+    bool Start(int frequency);
+    void Play(const char *path, bool loop, float fadeSeconds);
+    void Stop(float fadeSeconds);
+    void Mix(float *out, int frames);
+    void Close();
+    void Report();
+
+private:
+    int frequency = 0;
+    MusicDeck decks[MUSIC_DECKS];
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool isRunning = false;
+    bool hasRequest = false;
+    MusicRequest request;
+
+    //worker only
+    unsigned char readBuffer[MUSIC_READ_BYTES];
+    float chunk[MUSIC_CHUNK_FRAMES * 2];
+
+    void WorkerLoop();
+    bool StartTrack(const MusicRequest &request);
+    bool OpenTrack(MusicDeck &deck, const MusicRequest &request);
+    void CloseTrack(MusicDeck &deck);
+    void Fill(MusicDeck &deck);
+};
@@ -0,0 +1,96 @@
+#include "Net.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef _WINDOWS
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+static sockaddr_in LoopbackAddress(int port) {
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons((unsigned short)port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+bool UdpSocket::Open(int localPort) {
+  Close();
+#ifdef _WINDOWS
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+    std::cout << "Unable to start winsock\n";
+    return false;
+  }
+  SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s == INVALID_SOCKET) {
+    std::cout << "Unable to make a udp socket\n";
+    return false;
+  }
+  u_long nonBlocking = 1;
+  ioctlsocket(s, FIONBIO, &nonBlocking);
+#else
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) {
+    std::cout << "Unable to make a udp socket\n";
+    return false;
+  }
+  fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#endif
+  handle = (intptr_t)s;
+
+  sockaddr_in address = LoopbackAddress(localPort);
+  if (bind(s, (sockaddr *)&address, sizeof(address)) != 0) {
+    std::cout << "Unable to listen on port " << localPort << ", is something else using it?\n";
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void UdpSocket::Close() {
+  if (handle == -1) { return; }
+#ifdef _WINDOWS
+  closesocket((SOCKET)handle);
+  WSACleanup();
+#else
+  close((int)handle);
+#endif
+  handle = -1;
+}
+
+void UdpSocket::SendTo(int port, const Uint8 *data, int size) {
+  if (handle == -1) { return; }
+  sockaddr_in address = LoopbackAddress(port);
+  //a full buffer or nobody listening is the same as a lost packet
+#ifdef _WINDOWS
+  sendto((SOCKET)handle, (const char *)data, size, 0, (sockaddr *)&address, sizeof(address));
+#else
+  sendto((int)handle, data, size, 0, (sockaddr *)&address, sizeof(address));
+#endif
+}
+
+int UdpSocket::Receive(Uint8 *data, int capacity, int *fromPort) {
+  if (handle == -1) { return -1; }
+  sockaddr_in address;
+#ifdef _WINDOWS
+  int addressSize = sizeof(address);
+  int size = recvfrom((SOCKET)handle, (char *)data, capacity, 0, (sockaddr *)&address, &addressSize);
+#else
+  socklen_t addressSize = sizeof(address);
+  int size = (int)recvfrom((int)handle, data, capacity, 0, (sockaddr *)&address, &addressSize);
+#endif
+  if (size < 0) { return -1; }
+  *fromPort = ntohs(address.sin_port);
+  return size;
+}
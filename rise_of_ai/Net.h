@@ -0,0 +1,21 @@
+#pragma once
+
+#include <SDL.h>
+
+#include <cstdint>
+
+//a non blocking udp socket on 127.0.0.1 that talks to other ports on the same machine
+class UdpSocket {
+public:
+    bool Open(int localPort);
+    void Close();
+    bool IsOpen() const { return handle != -1; }
+    void SendTo(int port, const Uint8 *data, int size);
+    //copies the next waiting datagram into data and returns its size, -1 when nothing is waiting
+    //fromPort is set to the port it came from
+    int Receive(Uint8 *data, int capacity, int *fromPort);
+
+private:
+    //a SOCKET on windows, a file descriptor everywhere else
+    intptr_t handle = -1;
+};
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+
+//slots of T handed out and taken back in O(1)
+//a free slot holds the id of the next free slot, so the free list needs no memory of its own,
+//and live slots are also kept in a dense list so walking them never touches free ones
+//slots live in chunks of ChunkSize that are never moved, so a T& stays good while the pool grows
+template <typename T, int ChunkSize = 256>
+class Pool {
+public:
+    //live slot ids, in no particular order, releasing one moves the last into its place
+    int *live = NULL;
+    int count = 0;
+    //slots made so far, and how far the pool may grow, equal for a fixed pool
+    int capacity = 0;
+    int maxCapacity = 0;
+
+    Pool() {}
+    //the chunks are owned, copying would free them twice
+    Pool(const Pool &) = delete;
+    Pool &operator=(const Pool &) = delete;
+    ~Pool() { Free(); }
+
+    void Allocate(int capacity, int maxCapacity = 0) {
+        Free();
+        if (maxCapacity < capacity) { maxCapacity = capacity; }
+        this->maxCapacity = maxCapacity;
+        maxChunks = (maxCapacity + ChunkSize - 1) / ChunkSize;
+        chunks = new Slot *[maxChunks];
+        live = new int[maxCapacity];
+        while (this->capacity < capacity) { Grow(); }
+
+        //rethread so the first acquires come out lowest id first across chunks too
+        freeHead = -1;
+        for (int id = this->capacity - 1; id >= 0; id--) {
+            At(id).link = freeHead;
+            freeHead = id;
+        }
+    }
+
+    void Free() {
+        for (int c = 0; c < chunkCount; c++) { delete[] chunks[c]; }
+        delete[] chunks;
+        delete[] live;
+        chunks = NULL;
+        live = NULL;
+        chunkCount = 0;
+        maxChunks = 0;
+        count = 0;
+        capacity = 0;
+        maxCapacity = 0;
+        freeHead = -1;
+    }
+
+    //id of a slot nobody is using, -1 when the pool is full and can't grow
+    int Acquire() {
+        if (freeHead < 0 && Grow() == false) { return -1; }
+        int id = freeHead;
+        Slot &slot = At(id);
+        freeHead = slot.link;
+        slot.link = count;
+        slot.isLive = true;
+        live[count++] = id;
+        return id;
+    }
+
+    void Release(int id) {
+        Slot &slot = At(id);
+        if (slot.isLive == false) { return; }
+
+        //swap the last live id into the hole
+        int last = live[--count];
+        live[slot.link] = last;
+        At(last).link = slot.link;
+
+        slot.isLive = false;
+        slot.link = freeHead;
+        freeHead = id;
+    }
+
+    //everything that decides what the pool hands out next, so it can be put back exactly as it was
+    //the size only depends on capacity, T has to be trivially copyable
+    size_t StateSize() const { return sizeof(int) * (2 + capacity) + (sizeof(T) + sizeof(int) + 1) * capacity; }
+
+    void SaveState(unsigned char *out) {
+        Put(&out, &count, sizeof(int));
+        Put(&out, &freeHead, sizeof(int));
+        //only the live part of live means anything, the rest is zeroed so equal pools give equal bytes
+        Put(&out, live, sizeof(int) * count);
+        memset(out, 0, sizeof(int) * (capacity - count));
+        out += sizeof(int) * (capacity - count);
+        //field by field, so the padding in a Slot never ends up in the bytes
+        for (int id = 0; id < capacity; id++) {
+            Slot &slot = At(id);
+            unsigned char isLive = slot.isLive ? 1 : 0;
+            Put(&out, &slot.value, sizeof(T));
+            Put(&out, &slot.link, sizeof(int));
+            Put(&out, &isLive, 1);
+        }
+    }
+
+    //bytes from SaveState of a pool with the same capacity
+    void LoadState(const unsigned char *in) {
+        Take(&in, &count, sizeof(int));
+        Take(&in, &freeHead, sizeof(int));
+        Take(&in, live, sizeof(int) * count);
+        in += sizeof(int) * (capacity - count);
+        for (int id = 0; id < capacity; id++) {
+            Slot &slot = At(id);
+            unsigned char isLive;
+            Take(&in, &slot.value, sizeof(T));
+            Take(&in, &slot.link, sizeof(int));
+            Take(&in, &isLive, 1);
+            slot.isLive = isLive != 0;
+        }
+    }
+
+    bool IsLive(int id) { return At(id).isLive; }
+    T &operator[](int id) { return At(id).value; }
+    //the i'th live slot, for 0 <= i < count
+    T &Live(int i) { return At(live[i]).value; }
+
+private:
+    struct Slot {
+        T value;
+        //next free id while free, position in live while live
+        int link;
+        bool isLive;
+    };
+
+    Slot **chunks = NULL;
+    int chunkCount = 0;
+    int maxChunks = 0;
+    int freeHead = -1;
+
+    Slot &At(int id) { return chunks[id / ChunkSize][id % ChunkSize]; }
+
+    static void Put(unsigned char **out, const void *from, size_t size) {
+        memcpy(*out, from, size);
+        *out += size;
+    }
+
+    static void Take(const unsigned char **in, void *to, size_t size) {
+        memcpy(to, *in, size);
+        *in += size;
+    }
+
+    //adds a chunk and threads its slots onto the free list lowest id first
+    bool Grow() {
+        if (chunkCount == maxChunks) { return false; }
+
+        Slot *chunk = new Slot[ChunkSize];
+        chunks[chunkCount++] = chunk;
+        int first = capacity;
+        int made = maxCapacity - first < ChunkSize ? maxCapacity - first : ChunkSize;
+        for (int i = made - 1; i >= 0; i--) {
+            chunk[i].value = T();
+            chunk[i].isLive = false;
+            chunk[i].link = freeHead;
+            freeHead = first + i;
+        }
+        capacity += made;
+        return true;
+    }
+};
@@ -0,0 +1,79 @@
+#include "QualityGovernor.h"
+
+#include <algorithm>
+#include <iostream>
+
+QualityGovernor::QualityGovernor() {
+  levels[0] = { 131072, 64, 1.0f, 1 };
+  levels[1] = { 32768, 32, 1.0f, 4 };
+  levels[2] = { 8192, 16, 0.75f, 8 };
+  levels[3] = { 2048, 8, 0.5f, 15 };
+}
+
+void QualityGovernor::AddFrame(float frameMs) {
+  samples[nextSample] = frameMs;
+  nextSample = (nextSample + 1) % GOVERNOR_WINDOW;
+  if (sampleCount < GOVERNOR_WINDOW) { sampleCount++; }
+
+  framesSinceDecision++;
+  if (framesSinceDecision >= GOVERNOR_INTERVAL) {
+    framesSinceDecision = 0;
+    Decide();
+  }
+}
+
+void QualityGovernor::Decide() {
+  float sorted[GOVERNOR_WINDOW];
+  std::copy(samples, samples + sampleCount, sorted);
+  std::sort(sorted, sorted + sampleCount);
+  p50 = sorted[sampleCount * 50 / 100];
+  p95 = sorted[sampleCount * 95 / 100];
+  p99 = sorted[sampleCount * 99 / 100];
+
+  if (enabled == false) { return; }
+  if (cooldownLeft > 0) {
+    cooldownLeft--;
+    return;
+  }
+
+  //a vote only counts if the ones before it agreed
+  if (p95 > targetMs * downThreshold) {
+    downVotes++;
+    upVotes = 0;
+  } else if (p95 < targetMs * upThreshold) {
+    upVotes++;
+    downVotes = 0;
+  } else {
+    downVotes = 0;
+    upVotes = 0;
+  }
+
+  if (downVotes >= downVotesNeeded && level < QUALITY_LEVELS - 1) {
+    SetLevel(level + 1);
+  } else if (upVotes >= upVotesNeeded && level > 0) {
+    SetLevel(level - 1);
+  }
+}
+
+void QualityGovernor::SetLevel(int level) {
+  if (level < 0) { level = 0; }
+  if (level >= QUALITY_LEVELS) { level = QUALITY_LEVELS - 1; }
+  if (level == this->level) { return; }
+
+  std::cout << "quality: level " << this->level << " -> " << level << " (p50 " << p50 << " ms, p95 "
+            << p95 << " ms, target " << targetMs << " ms)\n";
+  this->level = level;
+  changes++;
+  downVotes = 0;
+  upVotes = 0;
+  cooldownLeft = cooldown;
+}
+
+const QualitySettings &QualityGovernor::Settings() {
+  return levels[level];
+}
+
+void QualityGovernor::Report() {
+  std::cout << "quality: level " << level << ", " << changes << " changes, p50 " << p50 << " ms, p95 "
+            << p95 << " ms, p99 " << p99 << " ms\n";
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+//frames kept for the rolling percentiles
+#define GOVERNOR_WINDOW 120
+//frames between decisions
+#define GOVERNOR_INTERVAL 30
+#define QUALITY_LEVELS 4
+
+//optional work we are allowed to scale back, level 0 is full quality
+struct QualitySettings {
+    int maxParticles;
+    int maxLights;
+    float renderScale;
+    //frames between rebuilding the hud text
+    int textInterval;
+};
+
+//watches frame times and moves the quality level against a target, with separate
+//thresholds and a number of agreeing decisions needed each way so it doesn't flip back and forth
+class QualityGovernor {
+public:
+    float targetMs = 16.6f;
+    //go down a level when p95 is above target * downThreshold
+    float downThreshold = 1.0f;
+    //go up a level when p95 is below target * upThreshold
+    float upThreshold = 0.7f;
+    int downVotesNeeded = 2;
+    int upVotesNeeded = 4;
+    //decisions skipped after a change so the new level shows up in the samples first
+    int cooldown = 2;
+
+    bool enabled = true;
+
+    //telemetry
+    int level = 0;
+    int changes = 0;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+
+    QualitySettings levels[QUALITY_LEVELS];
+
+    QualityGovernor();
+    void AddFrame(float frameMs);
+    void SetLevel(int level);
+    const QualitySettings &Settings();
+    void Report();
+
+private:
+    float samples[GOVERNOR_WINDOW];
+    int sampleCount = 0;
+    int nextSample = 0;
+    int framesSinceDecision = 0;
+    int downVotes = 0;
+    int upVotes = 0;
+    int cooldownLeft = 0;
+
+    void Decide();
+};
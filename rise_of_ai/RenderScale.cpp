@@ -0,0 +1,52 @@
+#include "RenderScale.h"
+
+#include <iostream>
+
+bool RenderScale::Load(int width, int height) {
+  this->width = width;
+  this->height = height;
+  renderWidth = width;
+  renderHeight = height;
+
+  //full size so any scale fits, lower scales just use the bottom left of it
+  glGenFramebuffers(1, &framebuffer);
+  glGenRenderbuffers(1, &colorBuffer);
+  glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+  bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (complete == false) {
+    std::cout << "render scale: unable to create offscreen framebuffer\n";
+    framebuffer = 0;
+    return false;
+  }
+  return true;
+}
+
+void RenderScale::Begin(float scale) {
+  if (framebuffer == 0 || scale >= 1.0f) { scale = 1.0f; }
+  this->scale = scale;
+  isScaled = scale < 1.0f;
+  renderWidth = (int)(width * scale);
+  renderHeight = (int)(height * scale);
+
+  if (isScaled) {
+    //the golden harness renders into its own framebuffer, so blit back to whatever was bound
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &outputFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  }
+  glViewport(0, 0, renderWidth, renderHeight);
+}
+
+void RenderScale::End() {
+  if (isScaled == false) { return; }
+
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+  glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+  glViewport(0, 0, width, height);
+}
@@ -0,0 +1,34 @@
+#pragma once
+#define GL_SILENCE_DEPRECATION
+
+#ifdef _WINDOWS
+#include <GL/glew.h>
+#endif
+
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL.h>
+#include <SDL_opengl.h>
+
+//draws the scene into a smaller offscreen buffer and stretches it over the real one,
+//at a scale of 1 everything goes straight to whatever framebuffer is bound
+class RenderScale {
+public:
+    float scale = 1.0f;
+
+    //size of the region being drawn into this frame
+    int renderWidth = 0;
+    int renderHeight = 0;
+
+    bool Load(int width, int height);
+    void Begin(float scale);
+    void End();
+
+private:
+    int width = 0;
+    int height = 0;
+
+    GLuint framebuffer = 0;
+    GLuint colorBuffer = 0;
+    GLint outputFramebuffer = 0;
+    bool isScaled = false;
+};
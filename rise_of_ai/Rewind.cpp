@@ -0,0 +1,211 @@
+#include "Rewind.h"
+
+#include <cstring>
+#include <iostream>
+
+//what is left of REWIND_BYTES once the index has its share
+#define REWIND_RING_BYTES ((int)(REWIND_BYTES - REWIND_MAX_STEPS * sizeof(Entry)))
+
+static double ElapsedMs(Uint64 start) {
+  return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static Uint8 *WriteCount(Uint8 *out, size_t value) {
+  while (value >= 0x80) {
+    *out++ = (Uint8)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (Uint8)value;
+  return out;
+}
+
+static const Uint8 *ReadCount(const Uint8 *in, size_t *value) {
+  *value = 0;
+  for (int shift = 0; ; shift += 7) {
+    Uint8 byte = *in++;
+    *value |= (size_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) { return in; }
+  }
+}
+
+//current xor base as runs, each a count of zero bytes to skip, a count of bytes that changed and
+//those bytes, trailing zeros aren't written since the size is known
+//base NULL is all zeros, which is how keyframes are stored
+//out needs room for size * 2 + 16 bytes in the worst case
+static size_t EncodeDelta(const Uint8 *current, const Uint8 *base, size_t size, Uint8 *out) {
+  Uint8 *start = out;
+  size_t i = 0;
+  while (i < size) {
+    size_t zeros = 0;
+    while (i + zeros < size && current[i + zeros] == (base != NULL ? base[i + zeros] : 0)) { zeros++; }
+    if (i + zeros == size) { break; }
+    i += zeros;
+
+    //a changed run carries on over short gaps, a lone equal byte costs less inside it than a new run
+    size_t changed = 0;
+    while (i + changed < size) {
+      size_t same = 0;
+      while (same < 3 && i + changed + same < size &&
+             current[i + changed + same] == (base != NULL ? base[i + changed + same] : 0)) { same++; }
+      if (same == 3 || i + changed + same == size) { break; }
+      changed += same + 1;
+    }
+
+    out = WriteCount(out, zeros);
+    out = WriteCount(out, changed);
+    for (size_t k = 0; k < changed; k++) {
+      *out++ = current[i + k] ^ (base != NULL ? base[i + k] : 0);
+    }
+    i += changed;
+  }
+  return out - start;
+}
+
+//applies a delta from EncodeDelta to state, which holds the base and ends up holding current
+static void DecodeDelta(const Uint8 *in, size_t inSize, Uint8 *state) {
+  const Uint8 *end = in + inSize;
+  size_t at = 0;
+  while (in < end) {
+    size_t zeros;
+    size_t changed;
+    in = ReadCount(in, &zeros);
+    in = ReadCount(in, &changed);
+    at += zeros;
+    for (size_t k = 0; k < changed; k++) { state[at++] ^= *in++; }
+  }
+}
+
+void RewindBuffer::Allocate() {
+  ring = new Uint8[REWIND_RING_BYTES];
+  entries = new Entry[REWIND_MAX_STEPS];
+  Clear();
+}
+
+void RewindBuffer::Clear() {
+  first = 0;
+  count = 0;
+  writePos = 0;
+  previous.clear();
+}
+
+//where a record of size bytes can go, dropping the oldest steps until there is room
+int RewindBuffer::Reserve(int size) {
+  while (true) {
+    if (count == 0) {
+      writePos = 0;
+      return 0;
+    }
+    //in use runs from the oldest record round to writePos
+    int oldest = At(0).offset;
+    if (oldest >= writePos) {
+      if (writePos + size <= oldest) { return writePos; }
+    } else {
+      if (writePos + size <= REWIND_RING_BYTES) { return writePos; }
+      if (size <= oldest) { return 0; }
+    }
+    DropOldest();
+  }
+}
+
+//a delta is no use without the keyframe before it, so they go together
+void RewindBuffer::DropOldest() {
+  first = (first + 1) % REWIND_MAX_STEPS;
+  count--;
+  while (count > 0 && At(0).isKeyframe == false) {
+    first = (first + 1) % REWIND_MAX_STEPS;
+    count--;
+  }
+}
+
+void RewindBuffer::Push(GameState &state) {
+  if (ring == NULL) { return; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  SaveState(state, &current);
+  int step = count == 0 ? 0 : Newest() + 1;
+
+  bool isKeyframe = count == 0 || previous.size() != current.size();
+  if (isKeyframe == false) {
+    //the newest keyframe is at most REWIND_KEYFRAME_INTERVAL entries back
+    int k = count - 1;
+    while (At(k).isKeyframe == false) { k--; }
+    isKeyframe = step - At(k).step >= REWIND_KEYFRAME_INTERVAL;
+  }
+
+  encoded.resize(current.size() * 2 + 16);
+  int size = (int)EncodeDelta(current.data(), isKeyframe ? NULL : previous.data(), current.size(), encoded.data());
+  if (size > REWIND_RING_BYTES / 2) {
+    std::cout << "rewind: a " << size << " byte state doesn't fit in the history\n";
+    return;
+  }
+
+  if (count == REWIND_MAX_STEPS) { DropOldest(); }
+  int offset = Reserve(size);
+  memcpy(ring + offset, encoded.data(), size);
+  writePos = offset + size;
+
+  Entry &entry = At(count);
+  entry.step = step;
+  entry.offset = offset;
+  entry.size = size;
+  entry.isKeyframe = isKeyframe;
+  count++;
+  previous.swap(current);
+
+  pushCount++;
+  totalBytes += size;
+  if (isKeyframe) {
+    keyframeCount++;
+    keyframeBytes += size;
+  }
+  double ms = ElapsedMs(start);
+  totalPushMs += ms;
+  if (ms > maxPushMs) { maxPushMs = ms; }
+}
+
+bool RewindBuffer::Restore(GameState &state, int step) {
+  if (count == 0 || step < Oldest() || step > Newest()) { return false; }
+
+  Uint64 start = SDL_GetPerformanceCounter();
+  //steps are pushed one after another, so the entry is found by counting
+  int target = step - Oldest();
+  int k = target;
+  while (At(k).isKeyframe == false) { k--; }
+
+  current.assign(previous.size(), 0);
+  for (int i = k; i <= target; i++) {
+    DecodeDelta(ring + At(i).offset, At(i).size, current.data());
+  }
+  if (LoadState(state, current.data(), current.size()) == false) { return false; }
+
+  //the steps after this one never happened now
+  count = target + 1;
+  writePos = At(target).offset + At(target).size;
+  previous.swap(current);
+
+  lastRestoreMs = ElapsedMs(start);
+  lastRestoreSteps = target - k + 1;
+  return true;
+}
+
+int RewindBuffer::BytesHeld() const {
+  int bytes = 0;
+  for (int i = 0; i < count; i++) { bytes += entries[(first + i) % REWIND_MAX_STEPS].size; }
+  return bytes;
+}
+
+void RewindBuffer::Report() {
+  if (pushCount == 0) { return; }
+
+  std::cout << "rewind: " << count << " steps held (" << count * FIXED_TIMESTEP << " s), " << BytesHeld() << " of "
+            << REWIND_RING_BYTES << " bytes\n";
+  std::cout << "rewind: avg " << totalBytes / pushCount << " bytes per step, keyframes avg "
+            << (keyframeCount > 0 ? keyframeBytes / keyframeCount : 0.0) << " bytes, deltas avg "
+            << (pushCount > keyframeCount ? (totalBytes - keyframeBytes) / (pushCount - keyframeCount) : 0.0)
+            << " bytes, state is " << previous.size() << " bytes\n";
+  std::cout << "rewind: push avg " << totalPushMs * 1000.0 / pushCount << " us, max " << maxPushMs << " ms";
+  if (lastRestoreSteps > 0) {
+    std::cout << ", last rewind " << lastRestoreMs << " ms decoding " << lastRestoreSteps << " steps";
+  }
+  std::cout << "\n";
+}
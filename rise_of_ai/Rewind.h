@@ -0,0 +1,72 @@
+#pragma once
+
+#include "Simulation.h"
+
+#include <vector>
+
+//memory the history may use, records and their index together, about half a minute of play
+#define REWIND_BYTES (1024 * 1024)
+//most steps the history can hold however small they are
+#define REWIND_MAX_STEPS 7200
+//steps between full states, going back decodes at most this many deltas
+#define REWIND_KEYFRAME_INTERVAL 60
+
+//the state after every fixed step, newest last, in a fixed amount of memory
+//a step is stored as the xor of its state with the step before, where most bytes are the same,
+//so the xor is mostly zero and is stored as runs, with a full state every REWIND_KEYFRAME_INTERVAL
+//steps to start decoding from
+//when it is full the oldest keyframe and the deltas that need it are dropped together
+class RewindBuffer {
+public:
+    //pushes and how many bytes they came to
+    int pushCount = 0;
+    double totalBytes = 0.0;
+    double keyframeBytes = 0.0;
+    int keyframeCount = 0;
+    double totalPushMs = 0.0;
+    double maxPushMs = 0.0;
+
+    double lastRestoreMs = 0.0;
+    int lastRestoreSteps = 0;
+
+    void Allocate();
+    //forgets every step, the next push starts the history again
+    void Clear();
+    //call with the state after every step
+    void Push(GameState &state);
+    //puts state back to step, which has to be between Oldest and Newest, and forgets the steps
+    //after it so play carries on from there
+    bool Restore(GameState &state, int step);
+
+    bool IsEmpty() const { return count == 0; }
+    int Oldest() const { return count == 0 ? 0 : entries[first].step; }
+    int Newest() const { return count == 0 ? 0 : entries[(first + count - 1) % REWIND_MAX_STEPS].step; }
+    //bytes in use by records right now
+    int BytesHeld() const;
+    void Report();
+
+private:
+    struct Entry {
+        int step;
+        int offset;
+        int size;
+        bool isKeyframe;
+    };
+
+    Uint8 *ring = NULL;
+    //where the next record goes, records are never split across the end
+    int writePos = 0;
+
+    Entry *entries = NULL;
+    int first = 0;
+    int count = 0;
+
+    //last pushed state, what the next delta is taken against
+    std::vector<Uint8> previous;
+    std::vector<Uint8> current;
+    std::vector<Uint8> encoded;
+
+    Entry &At(int i) { return entries[(first + i) % REWIND_MAX_STEPS]; }
+    int Reserve(int size);
+    void DropOldest();
+};
@@ -0,0 +1,231 @@
+#include "Simulation.h"
+
+#include <cstring>
+
+//written with a saved state so one can't be loaded into the other number type
+#ifdef SIM_FIXED_POINT
+#define STATE_NUMBER_TYPE 1
+#else
+#define STATE_NUMBER_TYPE 0
+#endif
+
+static void SetupShip(Entity ship, const LevelSpawn &spawn) {
+  ship.SetActive(true);
+  ship.SetPosition(glm::vec3(spawn.x, spawn.y, 0.0f));
+  ship.SetVelocity(glm::vec3(spawn.vx, spawn.vy, 0.0f));
+  ship.SetMovement(glm::vec3(0));
+  ship.SetSize(spawn.size, spawn.size);
+  ship.speed = spawn.speed;
+  ship.health = spawn.health;
+  ship.shotPower = spawn.shotPower;
+}
+
+static void SetupBullets(GameState &state, EntityPool &pool, EntityType type, int count, float speed, float size) {
+  pool.Setup(&state.entities, state.entities.Add(type, count));
+  for (int i = pool.range.begin; i < pool.range.end; i++) {
+    Entity bullet = state.entities.Get(i);
+    bullet.speed = speed;
+    bullet.SetSize(size, size);
+  }
+}
+
+void SetupState(GameState &state, const Level &level) {
+  const LevelHeader &header = *level.header;
+  EntityStore &entities = state.entities;
+  entities.Allocate(1 + header.bulletCount + header.enemyBulletCount + header.enemyCount);
+  state.mode = PLAYING;
+
+  //player
+  state.player = entities.Add(PLAYER, 1).begin;
+  SetupShip(entities.Get(state.player), header.player);
+
+  SetupBullets(state, state.bullets, BULLET, header.bulletCount, header.bulletSpeed, header.bulletSize);
+  SetupBullets(state, state.enemyBullets, ENEMY_BULLET, header.enemyBulletCount, header.enemyBulletSpeed,
+               header.enemyBulletSize);
+
+  //enemies, in the order the level lists them
+  state.enemies = entities.Add(ENEMY, header.enemyCount);
+  //room for every contact there can be in a step: the player on every enemy and enemy bullet,
+  //and every enemy on every bullet
+  state.collisions.Allocate(header.enemyCount + header.enemyBulletCount + header.enemyCount * header.bulletCount);
+  state.bossAfter = header.bossAfter;
+  for (int i = 0; i < (int)header.enemyCount; i++) {
+    const LevelSpawn &spawn = level.enemies[i];
+    Entity enemy = entities.Get(state.enemies.begin + i);
+    SetupShip(enemy, spawn);
+    enemy.enemyType = (EnemyType)spawn.enemyType;
+    enemy.enemyState = (EnemyState)spawn.enemyState;
+    if (enemy.enemyType == BOSS) { state.boss = enemy.index; }
+  }
+}
+
+struct EnemyJob {
+    GameState *state;
+    float deltaTime;
+};
+
+//one enemy's ai and collision only touches its own row, so they can run on any worker
+static void UpdateEnemies(void *data, int begin, int end) {
+  EnemyJob *job = (EnemyJob *)data;
+  GameState &state = *job->state;
+  for (int i = begin; i < end; i++) {
+    state.entities.Get(state.enemies.begin + i).Update(job->deltaTime, state.player, state.enemies, state.enemyBullets,
+                                                       state.bullets, state.collisions);
+  }
+}
+
+//a bullet is spent on the first enemy it touched, in row order, so one that touched two at
+//once only damages one of them
+static void EnemiesHitByBullets(GameState &state, const CollisionEvent *events, int count) {
+  EntityStore &entities = state.entities;
+  for (int e = 0; e < count; e++) {
+    int bullet = events[e].other;
+    if ((entities.flags[bullet] & ENTITY_ACTIVE) == 0) { continue; }
+    entities.health[events[e].row] -= entities.shotPower[bullet];
+    state.bullets.Release(bullet); //deactivate bullet that hit us
+  }
+}
+
+static void PlayerHitEnemies(GameState &state, const CollisionEvent *events, int count) {
+  for (int e = 0; e < count; e++) {
+    state.entities.health[events[e].row] = 0;
+  }
+}
+
+static void PlayerHitByBullets(GameState &state, const CollisionEvent *events, int count) {
+  EntityStore &entities = state.entities;
+  for (int e = 0; e < count; e++) {
+    int bullet = events[e].other;
+    if ((entities.flags[bullet] & ENTITY_ACTIVE) == 0) { continue; }
+    entities.health[events[e].row] -= entities.shotPower[bullet];
+    entities.flags[events[e].row] |= ENTITY_HIT;
+    state.enemyBullets.Release(bullet); //deactive bullet that hit us
+  }
+}
+
+//what happens when a row of one type touches a row of another, pairs not listed are ignored
+struct CollisionResponse {
+    EntityType type;
+    EntityType otherType;
+    void (*respond)(GameState &state, const CollisionEvent *events, int count);
+};
+
+static const CollisionResponse RESPONSES[] = {
+  { PLAYER, ENEMY, PlayerHitEnemies },
+  { PLAYER, ENEMY_BULLET, PlayerHitByBullets },
+  { ENEMY, BULLET, EnemiesHitByBullets },
+};
+
+void Step(GameState &state, const InputFrame &input, float deltaTime) {
+  EntityStore &entities = state.entities;
+
+  //effects are only left up for the step they happened in
+  for (int i = 0; i < entities.count; i++) {
+    entities.flags[i] &= ~(ENTITY_FIRED | ENTITY_HIT | ENTITY_DIED);
+  }
+  state.collisions.Clear();
+
+  Entity player = entities.Get(state.player);
+  player.SetMovement(glm::vec3(input.moveX, input.moveY, 0.0f));
+  if (input.shoot && state.mode == PLAYING) { player.Set(ENTITY_SHOT, true); }
+
+  //update bullets
+  entities.Integrate(state.bullets, deltaTime, state.jobs);
+
+  //update enemy bullets
+  entities.Integrate(state.enemyBullets, deltaTime, state.jobs);
+  state.bullets.Rebuild(state.jobs);
+
+  //update enemies: every enemy's ai and collision at once, then their shots in order so the
+  //pool hands out the same rows however the work was split
+  EnemyJob job = { &state, deltaTime };
+  if (state.jobs != NULL) { state.jobs->ParallelFor(state.enemies.Count(), ENEMY_GRAIN, UpdateEnemies, &job); }
+  else { UpdateEnemies(&job, 0, state.enemies.Count()); }
+
+  for (int i = 0; i < state.enemies.Count(); i++) {
+    Entity enemy = entities.Get(state.enemies.begin + i);
+    if (enemy.Has(ENTITY_SHOT)) {
+      enemy.Set(ENTITY_SHOT, false);
+      enemy.Fire(state.enemyBullets, entities.fromX[enemy.index], entities.fromY[enemy.index]);
+    }
+  }
+
+  //enemies have all fired, so the player can be checked against their bullets
+  state.enemyBullets.Rebuild(state.jobs);
+
+  //update player
+  player.Update(deltaTime, state.player, state.enemies, state.enemyBullets, state.bullets, state.collisions);
+
+  //respond to every contact of the step, one pair of types at a time
+  state.collisions.Sort();
+  for (size_t r = 0; r < sizeof(RESPONSES) / sizeof(RESPONSES[0]); r++) {
+    int found;
+    const CollisionEvent *events = state.collisions.Pair(RESPONSES[r].type, RESPONSES[r].otherType, &found);
+    if (found > 0) { RESPONSES[r].respond(state, events, found); }
+  }
+
+  //deaths in order
+  int deadCount = 0;
+  Entity boss = entities.Get(state.boss);
+  for (int i = 0; i < state.enemies.Count(); i++) {
+    Entity enemy = entities.Get(state.enemies.begin + i);
+    if (enemy.health <= 0 && enemy.enemyState != DEAD) {
+      enemy.SetActive(false);
+      enemy.enemyState = DEAD;
+      enemy.Set(ENTITY_DIED, true);
+    }
+
+    //check if boss should enter
+    if (boss.enemyState == IDLE) {
+      if (enemy.enemyState == DEAD) { deadCount++;}
+      if (deadCount >= state.bossAfter) { boss.enemyState = ENTERING; }
+    }
+  }
+  if (player.health <= 0 && state.mode != LOSE) { state.mode = LOSE; }
+
+  //if boss dies, victory
+  if (boss.enemyState == DEAD) { state.mode = WIN; }
+}
+
+//entity count, number type and mode
+#define STATE_HEADER_SIZE (3 * sizeof(int))
+
+size_t StateSize(GameState &state) {
+  return STATE_HEADER_SIZE + state.entities.blockSize + state.bullets.rows.StateSize() +
+         state.enemyBullets.rows.StateSize();
+}
+
+void SaveState(GameState &state, Uint8 *out) {
+  EntityStore &entities = state.entities;
+  int header[3] = { entities.count, STATE_NUMBER_TYPE, (int)state.mode };
+  memcpy(out, header, STATE_HEADER_SIZE);
+  out += STATE_HEADER_SIZE;
+  //rows hold indices rather than pointers, so the columns can be taken as they are
+  memcpy(out, entities.block, entities.blockSize);
+  out += entities.blockSize;
+  state.bullets.rows.SaveState(out);
+  out += state.bullets.rows.StateSize();
+  state.enemyBullets.rows.SaveState(out);
+}
+
+void SaveState(GameState &state, std::vector<Uint8> *out) {
+  out->resize(StateSize(state));
+  SaveState(state, out->data());
+}
+
+bool LoadState(GameState &state, const Uint8 *data, size_t size) {
+  EntityStore &entities = state.entities;
+  int header[3];
+  if (size != StateSize(state)) { return false; }
+  memcpy(header, data, STATE_HEADER_SIZE);
+  if (header[0] != entities.count || header[1] != STATE_NUMBER_TYPE) { return false; }
+
+  state.mode = (GameMode)header[2];
+  data += STATE_HEADER_SIZE;
+  memcpy(entities.block, data, entities.blockSize);
+  data += entities.blockSize;
+  state.bullets.rows.LoadState(data);
+  data += state.bullets.rows.StateSize();
+  state.enemyBullets.rows.LoadState(data);
+  return true;
+}
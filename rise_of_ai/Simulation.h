@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CollisionEvents.h"
+#include "Entity.h"
+#include "JobSystem.h"
+#include "Level.h"
+
+#include <vector>
+
+//pool sizes and enemy count of the built in level, a level file brings its own
+#define BULLET_COUNT 3
+#define ENEMY_COUNT 10
+#define ENEMY_BULLET_COUNT 50
+//enemies per job, their updates are small so a few go together
+#define ENEMY_GRAIN 2
+
+#define FIXED_TIMESTEP 0.0166666f
+
+enum GameMode { PLAYING, WIN, LOSE };
+
+//everything the player can ask for in one fixed step
+struct InputFrame {
+    float moveX = 0.0f;
+    float moveY = 0.0f;
+    bool shoot = false;
+};
+
+//the game as the simulation sees it
+//rows also carry textures and effects, those are filled in and used by whoever draws the game
+struct GameState {
+    EntityStore entities;
+    int player;
+    EntityRange enemies;
+    //the boss's row and how many dead enemies bring it in, both from the level
+    int boss = -1;
+    int bossAfter = 0;
+    EntityPool bullets;
+    EntityPool enemyBullets;
+    //every contact of the current step, empty between steps
+    CollisionEvents collisions;
+    GameMode mode = PLAYING;
+    //spreads a step over workers, NULL runs it all on the calling thread
+    JobSystem *jobs = NULL;
+};
+
+//every entity in the level in its starting place, without textures or effects
+//the level is only read here, it can be closed once the state is set up
+void SetupState(GameState &state, const Level &level);
+
+//advances the game one fixed step from nothing but its arguments, it doesn't read the clock,
+//poll devices, play sounds or draw, so it can be run by the real time loop or as fast as it goes
+//what happened that the game might want to show is left in ENTITY_FIRED, ENTITY_HIT and
+//ENTITY_DIED until the next step
+//contacts are found while everything moves and responded to at the end of the same step, so
+//there is nothing left over between steps that SaveState would have to keep
+void Step(GameState &state, const InputFrame &input, float deltaTime);
+
+//the part of the state a step reads and writes as bytes, textures, effects and the grids are
+//left out since they are set once by the game or rebuilt every step
+//that is a header, the entity store's block in one piece and the bullet pools' bookkeeping
+size_t StateSize(GameState &state);
+//out has room for StateSize bytes
+void SaveState(GameState &state, Uint8 *out);
+void SaveState(GameState &state, std::vector<Uint8> *out);
+//bytes from SaveState put back into a state from SetupState, false if they came from a build
+//with a different entity count or number type
+bool LoadState(GameState &state, const Uint8 *data, size_t size);
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Simulation.h"
+
+#include <cstdint>
+#include <vector>
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    //LevelHash of the level it was taken on, the rows only mean anything on that level
+    uint64_t levelHash;
+    //bytes of SaveState that follow the header
+    uint32_t stateSize;
+    //time the real time driver had left over, so a restored game steps at the same moments
+    float accumulator;
+    //the boss warning is up
+    uint32_t bossText;
+};
+
+//the whole simulation and the loop state around it as one block of plain bytes, rows refer to
+//each other by index so the block means the same thing in any run, it can be kept in memory,
+//copied with memcpy or written to disk as it is and read back for an instant resume
+class Snapshot {
+public:
+    //header then state, empty until the first Take or Read
+    std::vector<Uint8> bytes;
+
+    //how long the last of each took
+    double takeMs = 0.0;
+    double restoreMs = 0.0;
+    double writeMs = 0.0;
+    double readMs = 0.0;
+
+    void Take(GameState &state, uint64_t levelHash, float accumulator, bool bossText);
+    //false if there is nothing to restore, it came from a different build or another level
+    bool Restore(GameState &state, uint64_t levelHash, float *accumulator, bool *bossText);
+    bool Write(const char *filePath);
+    bool Read(const char *filePath);
+    void Report();
+};
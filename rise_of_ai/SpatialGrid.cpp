@@ -0,0 +1,130 @@
+#include "SpatialGrid.h"
+#include "AabbBatch.h"
+#include "Fixed.h"
+#include "JobSystem.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+void SpatialGrid::Allocate(int capacity, float minX, float minY, float maxX, float maxY) {
+  this->capacity = capacity;
+  this->minX = minX;
+  this->minY = minY;
+  columns = (int)std::ceil((maxX - minX) / cellSize);
+  rows = (int)std::ceil((maxY - minY) / cellSize);
+
+  cellStart = new int[columns * rows + 1];
+  cursor = new int[columns * rows];
+  items = new int[capacity];
+  itemX = new float[capacity];
+  itemY = new float[capacity];
+  itemHalfWidth = new float[capacity];
+  itemHalfHeight = new float[capacity];
+  itemCell = new int[capacity];
+  int chunks = JobSystem::ChunkCount(capacity, GRID_GRAIN) + 1;
+  chunkHalfWidth = new float[chunks];
+  chunkHalfHeight = new float[chunks];
+  count = 0;
+}
+
+int SpatialGrid::Column(float x) {
+  int column = (int)std::floor((x - minX) / cellSize);
+  if (column < 0) { return 0; }
+  if (column >= columns) { return columns - 1; }
+  return column;
+}
+
+int SpatialGrid::Row(float y) {
+  int row = (int)std::floor((y - minY) / cellSize);
+  if (row < 0) { return 0; }
+  if (row >= rows) { return rows - 1; }
+  return row;
+}
+
+//box covering a row at both ends of its step, grown a hair so rounding in the centre and
+//half extents can't cut off something the exact tests would find
+static void SweptBox(float x, float fromX, float halfWidth, float *centre, float *half) {
+  *centre = (x + fromX) * 0.5f;
+  *half = halfWidth + std::fabs(x - fromX) * 0.5f + GRID_SWEEP_MARGIN;
+}
+
+template <typename Real>
+void SpatialGrid::Classify(void *data, int begin, int end) {
+  BuildJob<Real> *job = (BuildJob<Real> *)data;
+  SpatialGrid *grid = job->grid;
+  float maxHalfWidth = 0.0f;
+  float maxHalfHeight = 0.0f;
+  for (int k = begin; k < end; k++) {
+    int i = job->source[k];
+    float centreX, centreY, halfX, halfY;
+    SweptBox(ToFloat(job->x[i]), ToFloat(job->fromX[i]), ToFloat(job->halfWidth[i]), &centreX, &halfX);
+    SweptBox(ToFloat(job->y[i]), ToFloat(job->fromY[i]), ToFloat(job->halfHeight[i]), &centreY, &halfY);
+    grid->itemCell[k] = grid->Row(centreY) * grid->columns + grid->Column(centreX);
+    if (halfX > maxHalfWidth) { maxHalfWidth = halfX; }
+    if (halfY > maxHalfHeight) { maxHalfHeight = halfY; }
+  }
+  grid->chunkHalfWidth[begin / GRID_GRAIN] = maxHalfWidth;
+  grid->chunkHalfHeight[begin / GRID_GRAIN] = maxHalfHeight;
+}
+
+template <typename Real>
+void SpatialGrid::Build(const Real *x, const Real *y, const Real *fromX, const Real *fromY,
+                        const Real *halfWidth, const Real *halfHeight, const int *source, int count,
+                        JobSystem *jobs) {
+  if (count > capacity) { count = capacity; }
+  this->count = count;
+  int cells = columns * rows;
+
+  BuildJob<Real> job = { this, x, y, fromX, fromY, halfWidth, halfHeight, source };
+  if (jobs != NULL) { jobs->ParallelFor(count, GRID_GRAIN, Classify<Real>, &job); }
+  else {
+    for (int begin = 0; begin < count; begin += GRID_GRAIN) {
+      Classify<Real>(&job, begin, begin + GRID_GRAIN < count ? begin + GRID_GRAIN : count);
+    }
+  }
+
+  maxHalfWidth = 0.0f;
+  maxHalfHeight = 0.0f;
+  for (int c = 0; c < JobSystem::ChunkCount(count, GRID_GRAIN); c++) {
+    if (chunkHalfWidth[c] > maxHalfWidth) { maxHalfWidth = chunkHalfWidth[c]; }
+    if (chunkHalfHeight[c] > maxHalfHeight) { maxHalfHeight = chunkHalfHeight[c]; }
+  }
+
+  //count rows per cell, shifted up one so the prefix sum below leaves the starts
+  std::memset(cellStart, 0, sizeof(int) * (cells + 1));
+  for (int k = 0; k < count; k++) { cellStart[itemCell[k] + 1]++; }
+
+  for (int c = 0; c < cells; c++) {
+    cellStart[c + 1] += cellStart[c];
+    cursor[c] = cellStart[c];
+  }
+
+  for (int k = 0; k < count; k++) {
+    int i = source[k];
+    int slot = cursor[itemCell[k]]++;
+    items[slot] = i;
+    SweptBox(ToFloat(x[i]), ToFloat(fromX[i]), ToFloat(halfWidth[i]), &itemX[slot], &itemHalfWidth[slot]);
+    SweptBox(ToFloat(y[i]), ToFloat(fromY[i]), ToFloat(halfHeight[i]), &itemY[slot], &itemHalfHeight[slot]);
+  }
+}
+
+template void SpatialGrid::Build<float>(const float *, const float *, const float *, const float *, const float *,
+                                        const float *, const int *, int, JobSystem *);
+template void SpatialGrid::Build<Fixed16>(const Fixed16 *, const Fixed16 *, const Fixed16 *, const Fixed16 *,
+                                          const Fixed16 *, const Fixed16 *, const int *, int, JobSystem *);
+
+void SpatialGrid::CellRange(float minX, float minY, float maxX, float maxY, int *column0, int *row0, int *column1, int *row1) {
+  *column0 = Column(minX - maxHalfWidth);
+  *column1 = Column(maxX + maxHalfWidth);
+  *row0 = Row(minY - maxHalfHeight);
+  *row1 = Row(maxY + maxHalfHeight);
+}
+
+void SpatialGrid::Report(const char *name) {
+  long long tests = pairTests;
+  long long brute = bruteTests;
+  std::cout << "broadphase: " << name << " " << tests << " pair tests, " << brute << " without the grid";
+  if (brute > 0) { std::cout << " (" << (100.0 * tests / brute) << "%)"; }
+  std::cout << ", " << sweptHits.load() << " hits found along the path, " << AabbOverlapPath() << " overlap tests\n";
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+class JobSystem;
+
+//bullets are 0.3 across and enemies 0.95, so a cell holds a handful of either
+#define GRID_CELL_SIZE 2.0f
+//swept boxes are grown by this, see SweptBox
+#define GRID_SWEEP_MARGIN 0.001f
+//rows per job when working out cells across workers
+#define GRID_GRAIN 256
+
+//uniform grid over the arena, rebuilt from scratch each step
+//rows are bucketed by the cell their centre is in with a counting sort, so a build is two
+//passes over the rows and one over the cells and never allocates
+//anything outside the grid is clamped into the edge cells
+class SpatialGrid {
+public:
+    float minX = 0.0f;
+    float minY = 0.0f;
+    float cellSize = GRID_CELL_SIZE;
+    int columns = 0;
+    int rows = 0;
+
+    //rows of cell c are items[cellStart[c]] up to items[cellStart[c + 1]]
+    int *cellStart = NULL;
+    int *items = NULL;
+    //copies of the rows' swept boxes in the same order, so the cells of one grid row are one
+    //contiguous run that can be tested in batches
+    float *itemX = NULL;
+    float *itemY = NULL;
+    float *itemHalfWidth = NULL;
+    float *itemHalfHeight = NULL;
+    int count = 0;
+    int capacity = 0;
+
+    //biggest half extents seen in the last build, queries grow by these since rows are
+    //only filed under their centre
+    float maxHalfWidth = 0.0f;
+    float maxHalfHeight = 0.0f;
+
+    //telemetry, pairs actually tested and pairs testing every row would have cost
+    //added to from several workers at once
+    std::atomic<long long> pairTests{ 0 };
+    std::atomic<long long> bruteTests{ 0 };
+    //hits only found by testing the path, where checking the end of the step would have missed
+    std::atomic<long long> sweptHits{ 0 };
+
+    void Allocate(int capacity, float minX, float minY, float maxX, float maxY);
+    //each row is filed as the box it swept going from fromX, fromY to x, y, pass x and y
+    //again for rows that are standing still
+    //Real is the store's number type, the boxes are kept as floats either way
+    //working out each row's cell is spread over the workers, the sort itself is done in order
+    template <typename Real>
+    void Build(const Real *x, const Real *y, const Real *fromX, const Real *fromY,
+               const Real *halfWidth, const Real *halfHeight, const int *source, int count,
+               JobSystem *jobs = NULL);
+    //cells a box could overlap something in, inclusive
+    void CellRange(float minX, float minY, float maxX, float maxY, int *column0, int *row0, int *column1, int *row1);
+    void Report(const char *name);
+
+private:
+    //cell of each row in the current build, then the fill cursor per cell
+    int *itemCell = NULL;
+    int *cursor = NULL;
+    //biggest half extents per job, folded together in job order after
+    float *chunkHalfWidth = NULL;
+    float *chunkHalfHeight = NULL;
+
+    template <typename Real>
+    struct BuildJob {
+        SpatialGrid *grid;
+        const Real *x;
+        const Real *y;
+        const Real *fromX;
+        const Real *fromY;
+        const Real *halfWidth;
+        const Real *halfHeight;
+        const int *source;
+    };
+    template <typename Real>
+    static void Classify(void *data, int begin, int end);
+
+    int Column(float x);
+    int Row(float y);
+};
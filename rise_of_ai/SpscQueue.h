@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+
+//single producer single consumer ring, the producer only ever writes tail and the consumer
+//only ever writes head, so neither side takes a lock or waits on the other
+template <typename T, int Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+public:
+    //producer side, false when full
+    bool Push(const T &item) {
+        int tail = this->tail.load(std::memory_order_relaxed);
+        int next = (tail + 1) & (Capacity - 1);
+        if (next == head.load(std::memory_order_acquire)) { return false; }
+        items[tail] = item;
+        this->tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    //consumer side, false when empty
+    bool Pop(T *item) {
+        int head = this->head.load(std::memory_order_relaxed);
+        if (head == tail.load(std::memory_order_acquire)) { return false; }
+        *item = items[head];
+        this->head.store((head + 1) & (Capacity - 1), std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+    //on separate cache lines so the two threads don't fight over one
+    alignas(64) std::atomic<int> head{ 0 };
+    alignas(64) std::atomic<int> tail{ 0 };
+};
@@ -0,0 +1,45 @@
+#include "StepScheduler.h"
+#include "Simulation.h"
+
+#include <cmath>
+#include <iostream>
+
+float StepScheduler::Limit(float deltaTime, float timeScale) {
+  frames++;
+  //slowed down the bound stays where it is, a frame then has fewer steps due anyway
+  float stretch = timeScale > 1.0f ? timeScale : 1.0f;
+  int maxSteps = (int)std::ceil(maxStepsPerFrame * stretch);
+  int budget = (int)std::ceil(catchUpBudget * stretch);
+  int fresh = (int)(deltaTime / FIXED_TIMESTEP);
+  int owed = backlog;
+  if (owed > 0) { catchUpFrames++; }
+  int due = fresh + owed;
+  backlog = 0;
+  if (due > mostStepsDue) { mostStepsDue = due; }
+  if (due == fresh && due <= maxSteps) { return deltaTime; }
+
+  if (due > maxSteps) {
+    clamps++;
+    int extra = due - maxSteps;
+    if (policy == SLOW_DOWN) {
+      backlog = extra < budget ? extra : budget;
+      //only what wasn't already owed is newly put off
+      if (backlog > owed) { deferredSteps += backlog - owed; }
+    }
+    droppedSteps += extra - backlog;
+    due = maxSteps;
+  }
+
+  //the part of a step left over carries on in the accumulator whatever happens to the rest
+  float remainder = deltaTime - fresh * FIXED_TIMESTEP;
+  return due * FIXED_TIMESTEP + remainder;
+}
+
+void StepScheduler::Report() {
+  if (frames == 0) { return; }
+
+  std::cout << "steps: " << clamps << " of " << frames << " frames had more than " << maxStepsPerFrame
+            << " frames' worth of steps due, the most was " << mostStepsDue << ", " << deferredSteps << " put off to later frames ("
+            << catchUpFrames << " frames catching up), " << droppedSteps << " dropped ("
+            << droppedSteps * FIXED_TIMESTEP << " s of game time)\n";
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL.h>
+
+//most fixed steps run in one frame, past this a frame would take long enough to make the next
+//one late too and the game would never catch up
+#define STEP_MAX_PER_FRAME 5
+//most steps owed that are kept to run in later frames, half a second, anything past it is dropped
+#define STEP_CATCH_UP_BUDGET 30
+
+//what happens to the steps over STEP_MAX_PER_FRAME after a stall
+//DROP_TIME forgets them, the game jumps over the stall as if it was paused
+//SLOW_DOWN keeps up to STEP_CATCH_UP_BUDGET of them and runs them a few extra per frame, the game
+//runs slow for a moment and then makes the time back
+enum CatchUpPolicy { DROP_TIME, SLOW_DOWN };
+
+//sits between the clock and the fixed step loop and bounds how many steps a frame runs
+class StepScheduler {
+public:
+    CatchUpPolicy policy = SLOW_DOWN;
+    int maxStepsPerFrame = STEP_MAX_PER_FRAME;
+    int catchUpBudget = STEP_CATCH_UP_BUDGET;
+
+    //steps owed from earlier frames
+    int backlog = 0;
+
+    //frames that had more steps due than they could run, what happened to the extra steps,
+    //and the most that were due at once
+    int frames = 0;
+    int clamps = 0;
+    int deferredSteps = 0;
+    int droppedSteps = 0;
+    int catchUpFrames = 0;
+    int mostStepsDue = 0;
+
+    //deltaTime is the game time due this frame, accumulator included, returns what of it the
+    //frame should run, at most maxStepsPerFrame steps and whatever is left under a step
+    //the bound and the budget are real frames' worth of steps, so with timeScale over 1 they grow
+    //with it, a game sped up 8 times runs 8 steps a frame without that counting as a stall
+    float Limit(float deltaTime, float timeScale);
+    //forgets the steps owed, for when the game jumps somewhere else
+    void Clear() { backlog = 0; }
+    void Report();
+};
@@ -14,34 +14,124 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "Entity.h"
+#include "AudioEngine.h"
+#include "Broadcast.h"
+#include "FrameCapture.h"
+#include "GoldenTest.h"
+#include "InputQueue.h"
+#include "JobSystem.h"
+#include "Level.h"
+#include "Lighting.h"
+#include "QualityGovernor.h"
+#include "RenderScale.h"
+#include "Replay.h"
+#include "Rewind.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "StepScheduler.h"
 
 #include <vector>
 
-#define BULLET_COUNT 3
-#define ENEMY_COUNT 10
-#define ENEMY_BULLET_COUNT 50
-
-enum GameMode { PLAYING, WIN, LOSE };
-GameMode mode = PLAYING;
-
 float ORTHO_WIDTH = 20.0f;
 float ORTHO_HEIGHT = 15.0f;
 
-struct GameState {
-    Entity *player;
-    Entity *enemies;
-    Entity *bullets;
-    Entity *enemyBullets;
-};
-
 GameState state;
 
+Entity Player() {
+  return state.entities.Get(state.player);
+}
+
+Entity Enemy(int i) {
+  return state.entities.Get(state.enemies.begin + i);
+}
+
+Entity Boss() {
+  return state.entities.Get(state.boss);
+}
+
 SDL_Window* displayWindow;
 bool gameIsRunning = true;
 
 ShaderProgram program;
 glm::mat4 viewMatrix, modelMatrix, projectionMatrix;
 
+FrameCapture capture;
+const char *capturePath = NULL;
+
+Lighting lighting;
+
+ParticleSystem particles;
+ParticleEmitter explosionEmitter;
+ParticleEmitter bossExplosionEmitter;
+ParticleEmitter sparkEmitter;
+
+AudioEngine audio;
+int shotSound = -1;
+int enemyShotSound = -1;
+int explosionSound = -1;
+int bossSound = -1;
+
+InputQueue input;
+LatencyMeter latency;
+
+JobSystem jobs;
+//0 is one worker per cpu
+int jobWorkers = 0;
+
+QualityGovernor governor;
+RenderScale renderScale;
+int pinnedQuality = -1;
+Uint64 frameStart = 0;
+
+GoldenTest golden;
+const char *goldenScript = NULL;
+const char *goldenDir = NULL;
+bool goldenUpdate = false;
+
+ReplayRecorder recorder;
+const char *recordPath = NULL;
+ReplayPlayer replay;
+const char *replayPath = NULL;
+int seekStep = 0;
+
+//F5 takes a snapshot and writes it to snapshotPath, F9 goes back to it
+Snapshot snapshot;
+const char *snapshotPath = "snapshot.bin";
+bool resumeSnapshot = false;
+bool takeSnapshot = false;
+bool restoreSnapshot = false;
+
+//every step's state for going back, hold backspace to play the game backwards, R jumps back
+//REWIND_JUMP_STEPS
+RewindBuffer history;
+#define REWIND_JUMP_STEPS 600
+bool rewindJump = false;
+
+//--broadcast sends every step out to spectators, --spectate watches one of those instead of playing
+BroadcastServer broadcast;
+int broadcastPort = 0;
+BroadcastViewer spectator;
+int spectatePort = 0;
+int spectateServerPort = 0;
+
+//--level plays a compiled level file instead of the built in one, it is mapped and read in place
+LevelFile levelFile;
+const char *levelPath = NULL;
+const Level *level = &DefaultLevel();
+double setupMs = 0.0;
+
+void SetupLevel() {
+  Uint64 start = SDL_GetPerformanceCounter();
+  SetupState(state, *level);
+  setupMs = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void ReportLevel() {
+  if (levelPath == NULL) { return; }
+  std::cout << "level: " << levelPath << ", " << level->header->enemyCount << " enemies, mapped in "
+            << levelFile.openMs * 1000.0 << " us, set up in " << setupMs * 1000.0 << " us\n";
+}
+
 GLuint LoadTexture(const char* filePath) {
   int w, h, n;
   unsigned char* image = stbi_load(filePath, &w, &h, &n, STBI_rgb_alpha);
@@ -66,14 +156,20 @@ GLuint LoadTexture(const char* filePath) {
 GLuint *fontTexID;
 bool BOSS_TEXT = false;
 
-void DrawText(ShaderProgram *program, GLuint fontTextureID, std::string text,
-              float size, float spacing, glm::vec3 position)
-{
+//quads for a string, kept around so hud text doesn't have to be rebuilt every frame
+struct TextMesh {
+    std::string text;
+    std::vector<float> vertices;
+    std::vector<float> texCoords;
+};
+
+void BuildText(TextMesh *mesh, std::string text, float size, float spacing) {
   float width = 1.0f / 16.0f;
   float height = 1.0f / 16.0f;
 
-  std::vector<float> vertices;
-  std::vector<float> texCoords;
+  mesh->text = text;
+  mesh->vertices.clear();
+  mesh->texCoords.clear();
 
   for(size_t i = 0; i < text.size(); i++) {
     int index = (int)text[i];
@@ -83,7 +179,7 @@ void DrawText(ShaderProgram *program, GLuint fontTextureID, std::string text,
     float u = (float)(index % 16) / 16.0f;
     float v = (float)(index / 16) / 16.0f;
 
-     vertices.insert(vertices.end(), {
+     mesh->vertices.insert(mesh->vertices.end(), {
          offset + (-0.5f * size), 0.5f * size,
          offset + (-0.5f * size), -0.5f * size,
          offset + (0.5f * size), 0.5f * size,
@@ -92,31 +188,56 @@ void DrawText(ShaderProgram *program, GLuint fontTextureID, std::string text,
          offset + (-0.5f * size), -0.5f * size,
      });
 
-     texCoords.insert(texCoords.end(), {u, v, u, v + height,u + width, v, u + width, v + height, u + width,
+     mesh->texCoords.insert(mesh->texCoords.end(), {u, v, u, v + height,u + width, v, u + width, v + height, u + width,
                       v, u, v + height
                       });
   }
+}
+
+void DrawTextMesh(ShaderProgram *program, GLuint fontTextureID, TextMesh *mesh, glm::vec3 position) {
   glm::mat4 modelMatrix = glm::mat4(1.0f);
   modelMatrix = glm::translate(modelMatrix, position);
   program->SetModelMatrix(modelMatrix);
   glUseProgram(program->programID);
-  glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, vertices.data());
+  glVertexAttribPointer(program->positionAttribute, 2, GL_FLOAT, false, 0, mesh->vertices.data());
   glEnableVertexAttribArray(program->positionAttribute);
-  glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, texCoords.data());
+  glVertexAttribPointer(program->texCoordAttribute, 2, GL_FLOAT, false, 0, mesh->texCoords.data());
   glEnableVertexAttribArray(program->texCoordAttribute);
   glBindTexture(GL_TEXTURE_2D, fontTextureID);
-  glDrawArrays(GL_TRIANGLES, 0, (int)(text.size() * 6));
+  glDrawArrays(GL_TRIANGLES, 0, (int)(mesh->text.size() * 6));
   glDisableVertexAttribArray(program->positionAttribute);
   glDisableVertexAttribArray(program->texCoordAttribute);
 }
 
+void DrawText(ShaderProgram *program, GLuint fontTextureID, std::string text,
+              float size, float spacing, glm::vec3 position)
+{
+  TextMesh mesh;
+  BuildText(&mesh, text, size, spacing);
+  DrawTextMesh(program, fontTextureID, &mesh, position);
+}
+
+//hud text, rebuilt every few frames depending on the quality level
+TextMesh healthText;
+TextMesh bossHealthText;
+int textFrames = 0;
+
+void ApplyQuality() {
+  const QualitySettings &settings = governor.Settings();
+  particles.maxParticles = settings.maxParticles;
+  lighting.maxLights = settings.maxLights;
+}
+
 int WIDTH = 640;
 int HEIGHT = 480;
 
 void Initialize() {
-  SDL_Init(SDL_INIT_VIDEO);
+  SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+  jobs.Start(jobWorkers);
   
-  displayWindow = SDL_CreateWindow("Rise of AI", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT, SDL_WINDOW_OPENGL);
+  Uint32 windowFlags = SDL_WINDOW_OPENGL;
+  if (goldenScript != NULL) { windowFlags |= SDL_WINDOW_HIDDEN; }
+  displayWindow = SDL_CreateWindow("Rise of AI", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, WIDTH, HEIGHT, windowFlags);
   SDL_GLContext context = SDL_GL_CreateContext(displayWindow);
   SDL_GL_MakeCurrent(displayWindow, context);
   
@@ -124,7 +245,7 @@ void Initialize() {
   glewInit();
 #endif
   
-  glViewport(0, 0, 640, 480);
+  glViewport(0, 0, WIDTH, HEIGHT);
   
   program.Load("shaders/vertex_textured.glsl", "shaders/fragment_textured.glsl");
   
@@ -141,247 +262,510 @@ void Initialize() {
   glEnable(GL_BLEND);
 
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+  lighting.Load(WIDTH, HEIGHT, ORTHO_WIDTH, ORTHO_HEIGHT);
+  renderScale.Load(WIDTH, HEIGHT);
+
+  particles.Load(PARTICLE_MAX);
+
+  //golden runs are checked on pixels only, no need for a sound device
+  if (goldenScript == NULL && audio.Open()) {
+    //bullets are the ones that pile up, so they get few voices and give way to everything else
+    shotSound = audio.LoadSound("shot.wav", 4, 0);
+    enemyShotSound = audio.LoadSound("enemy_shot.wav", 6, 0);
+    explosionSound = audio.LoadSound("explosion.wav", 8, 1);
+    bossSound = audio.LoadSound("boss.wav", 1, 2);
+    audio.music.Play("music_playing.wav", true, 0.5f);
+  }
+
+  explosionEmitter.system = &particles;
+  explosionEmitter.count = 200;
+  explosionEmitter.speedMin = 2.0f;
+  explosionEmitter.speedMax = 10.0f;
+  explosionEmitter.lifeMin = 0.3f;
+  explosionEmitter.lifeMax = 1.0f;
+  explosionEmitter.drag = 2.0f;
+  explosionEmitter.color[0] = 255;
+  explosionEmitter.color[1] = 160;
+  explosionEmitter.color[2] = 60;
+
+  bossExplosionEmitter = explosionEmitter;
+  bossExplosionEmitter.count = 2000;
+  bossExplosionEmitter.speedMax = 20.0f;
+  bossExplosionEmitter.lifeMax = 2.0f;
+  bossExplosionEmitter.size = 0.4f;
+
+  sparkEmitter.system = &particles;
+  sparkEmitter.count = 40;
+  sparkEmitter.speedMin = 4.0f;
+  sparkEmitter.speedMax = 8.0f;
+  sparkEmitter.lifeMin = 0.1f;
+  sparkEmitter.lifeMax = 0.3f;
+  sparkEmitter.size = 0.15f;
+  sparkEmitter.color[0] = 255;
+  sparkEmitter.color[1] = 80;
+  sparkEmitter.color[2] = 80;
   
  
   // Initialize Game Objects
   //load textures
-  GLuint playerTex = LoadTexture("player.png");
-  GLuint sniperTex = LoadTexture("goon2.png");
-  GLuint bomberTex = LoadTexture("goon1.png");
-  GLuint bossTex= LoadTexture("boss.png");
-  GLuint bulletTex = LoadTexture("bullet.png");
-  GLuint enemyBulletTex = LoadTexture("enemy_bullet.png");
+  const LevelHeader &header = *level->header;
+  GLuint playerTex = LoadTexture(header.textures[TEXTURE_PLAYER]);
+  GLuint sniperTex = LoadTexture(header.textures[TEXTURE_SNIPER]);
+  GLuint bomberTex = LoadTexture(header.textures[TEXTURE_BOMBER]);
+  GLuint bossTex= LoadTexture(header.textures[TEXTURE_BOSS]);
+  GLuint bulletTex = LoadTexture(header.textures[TEXTURE_BULLET]);
+  GLuint enemyBulletTex = LoadTexture(header.textures[TEXTURE_ENEMY_BULLET]);
   fontTexID = new GLuint(LoadTexture("font.png"));
   
-  // Initialize Player
-  state.player = new Entity();
-  state.player->isActive = true;
-  state.player->position = glm::vec3(0.0f, -10.0f, 0.0f);
-  state.player->movement = glm::vec3(0);
-  state.player->acceleration = glm::vec3(0.0f, 0.0f, 0.0f);
-  state.player->speed = 8.0f;
-  state.player->entityType = PLAYER;
-  state.player->health = 3;
-
-  state.player->textureID = playerTex;
-  
-  state.player->height = 0.95f;
-  state.player->width = 0.95f;
-
-  state.player->shotPower = 1.0f;
-
-  //init bullets
-  state.bullets = new Entity[BULLET_COUNT];
-  for (int i = 0; i < BULLET_COUNT; i++) {
-    state.bullets[i].entityType = BULLET;
-    state.bullets[i].textureID = bulletTex;
-    state.bullets[i].speed = 16.0f;
-    state.bullets[i].height = 0.3f;
-    state.bullets[i].width = 0.3f;
-  }
-
-  //init enemy bullets
-  state.enemyBullets = new Entity[ENEMY_BULLET_COUNT];
-  for (int i = 0; i < ENEMY_BULLET_COUNT; i++) {
-    state.enemyBullets[i].entityType = ENEMY_BULLET;
-    state.enemyBullets[i].textureID = enemyBulletTex;
-    state.enemyBullets[i].speed = 16.0f;
-    state.enemyBullets[i].height = 0.3f;
-    state.enemyBullets[i].width = 0.3f;
-  }
-
-  //init snipers
-  state.enemies = new Entity[ENEMY_COUNT];
-  for (int i = 0; i < 4; i++) {
-    state.enemies[i].entityType = ENEMY;
-    state.enemies[i].enemyState = ENTERING;
-    state.enemies[i].isActive = true;
-    state.enemies[i].enemyType = SNIPER;
-    state.enemies[i].textureID = sniperTex;
-    state.enemies[i].shotPower = 1;
-    state.enemies[i].height = 0.95f;
-    state.enemies[i].width = 0.95f;
-    state.enemies[i].speed = 2.0f + i;
-    state.enemies[i].position = glm::vec3(0.0f, 40.0f + i, 0.0f);
-    state.enemies[i].velocity.x = 1.0f;
-  }
-
-  //init bombers
-  for (int i = 4; i < 9; i++) {
-    state.enemies[i].entityType = ENEMY;
-    state.enemies[i].enemyState = ENTERING;
-    state.enemies[i].isActive = true;
-    state.enemies[i].enemyType = BOMBER;
-    state.enemies[i].textureID = bomberTex;
-    state.enemies[i].shotPower = 1;
-    state.enemies[i].height = 0.95f;
-    state.enemies[i].width = 0.95f;
-    state.enemies[i].speed = 15.0f;
-    state.enemies[i].position = glm::vec3(-19.5f, -10 + i*27, 0.0f);
-  }
-
-  //init boss
-  state.enemies[9].entityType = ENEMY;
-  state.enemies[9].enemyType = BOSS;
-  state.enemies[9].enemyState = IDLE;
-  state.enemies[9].isActive = true;
-  state.enemies[9].textureID = bossTex;
-  state.enemies[9].shotPower = 3;
-  state.enemies[9].height = 0.95f;
-  state.enemies[9].width = 0.95f;
-  state.enemies[9].speed = 4.0f;
-  state.enemies[9].position = glm::vec3(0.0f, 18.0f, 0.0f);
+  SetupLevel();
+  state.jobs = &jobs;
+
+  //looks and effects for the rows the simulation set up
+  Entity player = Player();
+  player.textureID = playerTex;
+  player.onHit = &sparkEmitter;
+  player.onDeath = &explosionEmitter;
+
+  for (int i = state.bullets.range.begin; i < state.bullets.range.end; i++) {
+    state.entities.Get(i).textureID = bulletTex;
+  }
+  for (int i = state.enemyBullets.range.begin; i < state.enemyBullets.range.end; i++) {
+    state.entities.Get(i).textureID = enemyBulletTex;
+  }
+
+  for (int i = 0; i < state.enemies.Count(); i++) {
+    Entity enemy = Enemy(i);
+    switch (enemy.enemyType) {
+      case SNIPER:
+        enemy.textureID = sniperTex;
+        enemy.onDeath = &explosionEmitter;
+        break;
+      case BOMBER:
+        enemy.textureID = bomberTex;
+        enemy.onDeath = &explosionEmitter;
+        break;
+      case BOSS:
+        enemy.textureID = bossTex;
+        enemy.onDeath = &bossExplosionEmitter;
+        break;
+    }
+  }
 
+  //start recording if asked to on the command line
+  if (capturePath != NULL) {
+    capture.Start(capturePath, WIDTH, HEIGHT, 60);
+  }
+
+  //record this session's input, or play back a recorded one from seekStep on
+  if (recordPath != NULL) { recorder.Start(recordPath, LevelHash(*level)); }
+  if (replayPath != NULL) {
+    if (replay.Open(replayPath, LevelHash(*level)) == false) { gameIsRunning = false; }
+    else if (seekStep > 0) { replay.Seek(state, seekStep); }
+  }
+
+  history.Allocate();
+  history.Push(state);
+
+  //headless scripted run checked against reference frames
+  if (goldenScript != NULL && golden.Start(goldenScript, goldenDir, goldenUpdate, WIDTH, HEIGHT) == false) {
+    gameIsRunning = false;
+  }
+
+  //golden frames have to come out the same on any machine, so they stay at full quality
+  if (golden.isRunning || pinnedQuality >= 0) {
+    governor.enabled = false;
+    if (golden.isRunning == false) { governor.SetLevel(pinnedQuality); }
+  }
+  ApplyQuality();
 }
 
-void ProcessInput() {
-  SDL_Event event;
-  switch(mode) {
-    case WIN:
-    case LOSE:
-      while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-          case SDL_QUIT:
-          case SDL_WINDOWEVENT_CLOSE:
-            gameIsRunning = false;
-            break;
+//scripted input replaces the real event queue and keyboard during a golden run
+bool PollEvent(SDL_Event *event) {
+  if (golden.isRunning) { return golden.PollEvent(event); }
+  return SDL_PollEvent(event) != 0;
+}
+
+const Uint8 *GetKeyboardState() {
+  if (golden.isRunning) { return golden.keys; }
+  return SDL_GetKeyboardState(NULL);
+}
+
+//input for the next fixed step, filled in from the queued events the step covers
+InputFrame stepInput;
+
+//game seconds per real second, below 1 is slow motion and above 1 fast forward
+//steps stay FIXED_TIMESTEP long either way, there are just fewer or more of them per frame
+#define TIME_SCALE_MIN 0.125f
+#define TIME_SCALE_MAX 8.0f
+float timeScale = 1.0f;
+
+void SetTimeScale(float scale) {
+  if (scale < TIME_SCALE_MIN) { scale = TIME_SCALE_MIN; }
+  if (scale > TIME_SCALE_MAX) { scale = TIME_SCALE_MAX; }
+  timeScale = scale;
+}
+
+void HandleEvent(const SDL_Event &event, Uint64 time) {
+  switch (event.type) {
+    case SDL_QUIT:
+    case SDL_WINDOWEVENT_CLOSE:
+      gameIsRunning = false;
+      break;
+
+    case SDL_KEYDOWN:
+      //[ and ] slow the game down and speed it up against the clock
+      if (event.key.keysym.sym == SDLK_LEFTBRACKET) { SetTimeScale(timeScale * 0.5f); }
+      else if (event.key.keysym.sym == SDLK_RIGHTBRACKET) { SetTimeScale(timeScale * 2.0f); }
+      //done by Update between steps
+      else if (event.key.keysym.sym == SDLK_F5) { takeSnapshot = true; }
+      else if (event.key.keysym.sym == SDLK_F9) { restoreSnapshot = true; }
+      else if (event.key.keysym.sym == SDLK_r) { rewindJump = true; }
+
+      if (state.mode != PLAYING) { break; }
+      switch (event.key.keysym.sym) {
+        case SDLK_SPACE:
+          stepInput.shoot = true;
+          latency.Input(time);
+          break;
         }
-      }
       break;
-    case PLAYING:
-      state.player->movement = glm::vec3(0);
-      
-      while (SDL_PollEvent(&event)) {
-        switch (event.type) {
-          case SDL_QUIT:
-          case SDL_WINDOWEVENT_CLOSE:
-            gameIsRunning = false;
-            break;
-            
-          case SDL_KEYDOWN:
-            switch (event.key.keysym.sym) {
-              case SDLK_SPACE:
-                state.player->shot = true;
-                break;
-              }
-            break;
-          }
-      }
-      
-      const Uint8 *keys = SDL_GetKeyboardState(NULL);
+  }
+}
 
-      if (keys[SDL_SCANCODE_LEFT]) {
-        state.player->movement.x = -1.0f;
-      } else if (keys[SDL_SCANCODE_RIGHT]) {
-        state.player->movement.x = 1.0f;
-      }
+glm::vec3 MovementFromKeys(const Uint8 *keys) {
+  glm::vec3 movement = glm::vec3(0);
 
-      if (keys[SDL_SCANCODE_UP]) {
-        state.player->movement.y = 1.0f;
-      } else if (keys[SDL_SCANCODE_DOWN]) {
-        state.player->movement.y = -1.0f;
-      }
-      
-      if (glm::length(state.player->movement) > 1.0f) {
-        state.player->movement = glm::normalize(state.player->movement);
-      }
-      break;
+  if (keys[SDL_SCANCODE_LEFT]) {
+    movement.x = -1.0f;
+  } else if (keys[SDL_SCANCODE_RIGHT]) {
+    movement.x = 1.0f;
+  }
+
+  if (keys[SDL_SCANCODE_UP]) {
+    movement.y = 1.0f;
+  } else if (keys[SDL_SCANCODE_DOWN]) {
+    movement.y = -1.0f;
+  }
+
+  if (glm::length(movement) > 1.0f) {
+    movement = glm::normalize(movement);
+  }
+  return movement;
+}
+
+//gives a fixed step the events from before the moment it ends, so each one lands in the
+//step it happened during instead of all of them landing in the first step of the frame
+void ApplyInput(Uint64 stepEnd) {
+  TimedEvent timed;
+  while (input.Next(stepEnd, &timed)) {
+    HandleEvent(timed.event, timed.time);
+  }
+  glm::vec3 movement = MovementFromKeys(golden.isRunning ? golden.keys : input.keys);
+  stepInput.moveX = movement.x;
+  stepInput.moveY = movement.y;
+}
+
+void ProcessInput() {
+  if (golden.isRunning) { golden.BeginFrame(); }
+
+  //stamp everything that came in, the fixed steps in Update take them from here
+  input.Pump(PollEvent);
+
+  //nothing is stepping, so there is no step to wait for
+  if (state.mode != PLAYING) {
+    TimedEvent timed;
+    while (input.Next(SDL_MAX_UINT64, &timed)) { HandleEvent(timed.event, timed.time); }
   }
 }
 
-#define FIXED_TIMESTEP 0.0166666f
 float lastTicks = 0;
 float accumulator = 0.0f;
+//bounds the steps a frame runs after a stall, --catch-up picks what happens to the rest
+StepScheduler scheduler;
+
+//sounds, lights and particles for what the last step left flagged
+void PlayStepEffects(GameMode lastMode, bool bossWaiting) {
+  for (int i = 0; i < state.enemies.Count(); i++) {
+    Entity enemy = Enemy(i);
+    if (enemy.Has(ENTITY_DIED)) {
+      lighting.AddFlash(enemy.Position(), 6.0f, glm::vec3(1.0f, 0.6f, 0.2f), 1.2f, 0.6f);
+      audio.Play(explosionSound, enemy.enemyType == BOSS ? 1.0f : 0.6f, enemy.Position().x / ORTHO_WIDTH);
+      if (enemy.onDeath != NULL) { enemy.onDeath->Emit(enemy.Position()); }
+    }
+  }
+
+  if (bossWaiting && Boss().enemyState != IDLE) {
+    BOSS_TEXT = true;
+    audio.Play(bossSound, 0.8f, 0.0f);
+  }
+
+  for (int i = 0; i < state.enemies.Count(); i++) {
+    Entity enemy = Enemy(i);
+    if (enemy.Has(ENTITY_FIRED)) {
+      lighting.AddFlash(enemy.Position(), 2.5f, glm::vec3(1.0f, 0.3f, 0.3f), 0.8f, 0.1f);
+      audio.Play(enemyShotSound, 0.3f, enemy.Position().x / ORTHO_WIDTH);
+    }
+  }
+
+  Entity player = Player();
+  if (player.Has(ENTITY_HIT) && player.onHit != NULL) { player.onHit->Emit(player.Position()); }
+  if (state.mode == LOSE && lastMode != LOSE) {
+    audio.music.Play("music_lose.wav", false, 1.0f);
+    if (player.onDeath != NULL) { player.onDeath->Emit(player.Position()); }
+  }
+  if (player.Has(ENTITY_FIRED)) {
+    lighting.AddFlash(player.Position(), 2.5f, glm::vec3(1.0f, 0.9f, 0.5f), 0.8f, 0.1f);
+    audio.Play(shotSound, 0.4f, player.Position().x / ORTHO_WIDTH);
+  }
+
+  if (state.mode == WIN && lastMode != WIN) { audio.music.Play("music_win.wav", false, 1.0f); }
+}
+
+//music for a mode the game jumped to rather than played into
+void PlayModeMusic(GameMode lastMode) {
+  if (state.mode == lastMode) { return; }
+  switch (state.mode) {
+    case PLAYING:
+      audio.music.Play("music_playing.wav", true, 0.5f);
+      break;
+    case WIN:
+      audio.music.Play("music_win.wav", false, 1.0f);
+      break;
+    case LOSE:
+      audio.music.Play("music_lose.wav", false, 1.0f);
+      break;
+  }
+}
+
+//goes back to the snapshot taken this run, or the one on disk if there isn't one
+void RestoreSnapshot() {
+  if (snapshot.bytes.empty() && snapshot.Read(snapshotPath) == false) { return; }
+
+  GameMode lastMode = state.mode;
+  if (snapshot.Restore(state, LevelHash(*level), &accumulator, &BOSS_TEXT) == false) { return; }
+  scheduler.Clear();
+  PlayModeMusic(lastMode);
+  //the history led up to the state we just left
+  history.Clear();
+  history.Push(state);
+}
+
+//back to step, or as far back as the history goes
+void RewindTo(int step) {
+  if (history.IsEmpty()) { return; }
+  if (step < history.Oldest()) { step = history.Oldest(); }
+
+  GameMode lastMode = state.mode;
+  if (history.Restore(state, step) == false) { return; }
+  //the boss only ever leaves IDLE once, so whether its health is up follows from the state
+  BOSS_TEXT = Boss().enemyState != IDLE;
+  //time owed to the steps we just threw away isn't owed to the ones after the restored step
+  scheduler.Clear();
+  accumulator = 0.0f;
+  PlayModeMusic(lastMode);
+}
+
+//the spectator's driver, the frames come from the server and all that runs here is the effects
+void WatchBroadcast() {
+  float ticks = (float)SDL_GetTicks() / 1000.0f;
+  float deltaTime = ticks - lastTicks;
+  lastTicks = ticks;
 
+  //nothing steps, so the queued events are all handled here
+  TimedEvent timed;
+  while (input.Next(SDL_MAX_UINT64, &timed)) { HandleEvent(timed.event, timed.time); }
+
+  GameMode lastMode = state.mode;
+  if (spectator.Poll(state, &BOSS_TEXT)) { PlayStepEffects(lastMode, false); }
+  lighting.Update(deltaTime);
+  particles.Update(deltaTime);
+  if (spectator.ended) { gameIsRunning = false; }
+}
+
+//the real time driver, runs however many fixed steps the clock says are due
 void Update() {
+  if (spectator.isWatching) {
+    WatchBroadcast();
+    return;
+  }
+  //recordings and replays have to stay in step with their input, so like rewinding, F5 and F9
+  //do nothing while one is going
+  bool canJump = recorder.isRecording == false && replay.isPlaying == false;
+  if (takeSnapshot && canJump) {
+    snapshot.Take(state, LevelHash(*level), accumulator, BOSS_TEXT);
+    snapshot.Write(snapshotPath);
+  }
+  if (restoreSnapshot && canJump) { RestoreSnapshot(); }
+  takeSnapshot = false;
+  restoreSnapshot = false;
+
+  Uint64 now = SDL_GetPerformanceCounter();
   float ticks = (float)SDL_GetTicks() / 1000.0f;
   float deltaTime = ticks - lastTicks;
   lastTicks = ticks;
 
-  switch (mode) {
+  //golden runs advance exactly one step per frame so they don't depend on the clock
+  float scale = golden.isRunning ? 1.0f : timeScale;
+  if (golden.isRunning) { deltaTime = FIXED_TIMESTEP; }
+  else { deltaTime *= scale; }
+
+  //and for the same reason they can't be rewound
+  if (canJump) {
+    if (rewindJump) { RewindTo(history.Newest() - REWIND_JUMP_STEPS); }
+
+    //backwards as fast as the game went forwards, the keys pressed meanwhile are used up here
+    const Uint8 *keys = golden.isRunning ? golden.keys : input.latestKeys;
+    if (keys[SDL_SCANCODE_BACKSPACE]) {
+      ApplyInput(now);
+      stepInput.shoot = false;
+
+      particles.Update(deltaTime);
+
+      deltaTime += accumulator;
+      int steps = (int)(deltaTime / FIXED_TIMESTEP);
+      if (steps > 0) { RewindTo(history.Newest() - steps); }
+      //after RewindTo, so the part of a step left over goes towards the next frame's rewind
+      accumulator = deltaTime - steps * FIXED_TIMESTEP;
+      rewindJump = false;
+      return;
+    }
+  }
+  rewindJump = false;
+
+  switch (state.mode) {
     case WIN:
     case LOSE:
+      //let the last explosions play out
+      particles.Update(deltaTime);
       break;
     case PLAYING:
       deltaTime += accumulator;
+      deltaTime = scheduler.Limit(deltaTime, scale);
 
       if (deltaTime < FIXED_TIMESTEP) { accumulator = deltaTime; return; }
 
       // Update using fixed time step
       while (deltaTime >= FIXED_TIMESTEP) {
-
-        //update bullets
-        for (int i = 0; i < BULLET_COUNT; i++) {
-          state.bullets[i].Update(FIXED_TIMESTEP, NULL, NULL, 0, NULL, 0, NULL, 0);
-        }
-
-        //update enemy bullets
-        for (int i = 0; i < ENEMY_BULLET_COUNT; i++) {
-          state.enemyBullets[i].Update(FIXED_TIMESTEP, NULL, NULL, 0, NULL, 0, NULL, 0);
+        //this step ends deltaTime - FIXED_TIMESTEP game seconds before now
+        ApplyInput(now - (Uint64)((deltaTime - FIXED_TIMESTEP) / scale * SDL_GetPerformanceFrequency()));
+        //a replay still lets the keys change the time scale, but the step gets the recorded input
+        if (replay.isPlaying && replay.Read(state, &stepInput) == false) {
+          gameIsRunning = false;
+          break;
         }
+        recorder.Record(state, stepInput);
 
-        //update enemies
-        int deadCount = 0;
-        for (int i = 0; i < ENEMY_COUNT; i++) {
-          if (state.enemies[i].collided) {
-            switch (state.enemies[i].lastCollision->entityType) {
-              case PLAYER:
-                state.enemies[i].health = 0;
-                break;
-              case BULLET:
-                state.enemies[i].health -= state.enemies[i].lastCollision->shotPower;
-                state.enemies[i].lastCollision->isActive = false; //deactivate bullet that hit us
-                break;
-            }
-            state.enemies[i].collided = false;
-            state.enemies[i].lastCollision = NULL;
-          }
-
-          if (state.enemies[i].health <= 0) { state.enemies[i].isActive = false; state.enemies[i].enemyState = DEAD; }
-          state.enemies[i].Update(FIXED_TIMESTEP, state.player, NULL, 0, state.enemyBullets, ENEMY_BULLET_COUNT, state.bullets, BULLET_COUNT);
-
-          //check if boss should enter
-          if (state.enemies[9].enemyState == IDLE) {
-            if (state.enemies[i].enemyState == DEAD) { deadCount++;} 
-            if (deadCount >= 4) {
-              state.enemies[9].enemyState = ENTERING;
-              BOSS_TEXT = true;
-            }
-          }
-        }
+        GameMode lastMode = state.mode;
+        bool bossWaiting = Boss().enemyState == IDLE;
+        Step(state, stepInput, FIXED_TIMESTEP);
+        history.Push(state);
+        stepInput.shoot = false;
+        PlayStepEffects(lastMode, bossWaiting);
+        broadcast.Send(state, BOSS_TEXT);
 
-        //update player
-        if (state.player->collided) {
-          switch (state.player->lastCollision->entityType) {
-            case ENEMY:
-              state.player->health = 0;
-              break;
-            case ENEMY_BULLET:
-              state.player->health -= state.player->lastCollision->shotPower; 
-              state.player->lastCollision->isActive = false; //deactive bullet that hit us
-          }
-          state.player->collided = false;
-          state.player->lastCollision = NULL;
-        }
-        if (state.player->health <= 0) { mode = LOSE; }
-        state.player->Update(FIXED_TIMESTEP, state.player, state.enemies, ENEMY_COUNT, state.enemyBullets, ENEMY_BULLET_COUNT, state.bullets, BULLET_COUNT);
+        lighting.Update(FIXED_TIMESTEP);
+        particles.Update(FIXED_TIMESTEP);
 
         deltaTime -= FIXED_TIMESTEP;
       }
       accumulator = deltaTime;
+      break;
+  }
 
+}
 
-      //if boss dies, victory
-      if (state.enemies[9].enemyState == DEAD) {mode = WIN;}
-      break;
+//made up input that wanders around and shoots now and then, the same for the same seed
+InputFrame BotInput(unsigned int *seed) {
+  *seed = *seed * 1103515245 + 12345;
+  int r = (*seed >> 16) & 255;
+  InputFrame frame;
+  frame.moveX = (float)((r & 3) == 0 ? -1 : (r & 3) == 1 ? 1 : 0);
+  frame.moveY = (float)(((r >> 2) & 3) == 0 ? -1 : ((r >> 2) & 3) == 1 ? 1 : 0);
+  glm::vec3 movement = glm::vec3(frame.moveX, frame.moveY, 0.0f);
+  if (glm::length(movement) > 1.0f) {
+    movement = glm::normalize(movement);
+    frame.moveX = movement.x;
+    frame.moveY = movement.y;
+  }
+  frame.shoot = (r >> 4) < 3;
+  return frame;
+}
+
+int batchSteps = 0;
+
+//the batch driver, runs steps fixed steps on the bot's input as fast as they go, with no
+//window, sound or drawing, the game keeps going after it is won or lost so every run is steps long
+//with --replay the input comes from the recording instead and the run stops where it does
+void RunBatch(int steps) {
+  jobs.Start(jobWorkers);
+  SetupLevel();
+  state.jobs = &jobs;
+
+  if (replayPath != NULL) {
+    if (replay.Open(replayPath, LevelHash(*level)) == false) { return; }
+    if (seekStep > 0) { replay.Seek(state, seekStep); }
+  }
+  if (recordPath != NULL) { recorder.Start(recordPath, LevelHash(*level)); }
+
+  unsigned int seed = 1;
+  int endStep = -1;
+  int step = 0;
+  Uint64 start = SDL_GetPerformanceCounter();
+  Uint32 startTicks = SDL_GetTicks();
+  for (; step < steps; step++) {
+    InputFrame frame = BotInput(&seed);
+    if (replay.isPlaying && replay.Read(state, &frame) == false) { break; }
+    recorder.Record(state, frame);
+    Step(state, frame, FIXED_TIMESTEP);
+    if (state.mode != PLAYING && endStep < 0) { endStep = step; }
+
+    //spectators watch at the speed the game is played, so a broadcast batch keeps to the clock
+    if (broadcast.isRunning) {
+      broadcast.Send(state, Boss().enemyState != IDLE);
+      Uint32 due = startTicks + (Uint32)((step + 1) * FIXED_TIMESTEP * 1000.0f);
+      Uint32 now = SDL_GetTicks();
+      if ((int)(due - now) > 0) { SDL_Delay(due - now); }
+    }
   }
+  double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+  const char *modes[] = { "playing", "won", "lost" };
+  std::cout << "batch: " << step << " steps in " << ms << " ms, " << step * 1000.0 / ms << " steps per second ("
+            << step * FIXED_TIMESTEP * 1000.0 / ms << "x real time), " << modes[state.mode];
+  if (endStep >= 0) { std::cout << " at step " << endStep; }
+  std::cout << "\n";
+  ReportLevel();
+  recorder.Finish();
+  recorder.Report();
+  replay.Report();
+  broadcast.Stop();
+  broadcast.Report();
+  jobs.Report();
+  jobs.Stop();
+  state.bullets.grid.Report("player bullets");
+  state.enemyBullets.grid.Report("enemy bullets");
+  state.collisions.Report();
+}
 
+void AddBulletLights(EntityPool &pool, glm::vec3 color, float intensity) {
+  if (spectator.isWatching) {
+    for (int i = pool.range.begin; i < pool.range.end; i++) {
+      if (state.entities.flags[i] & ENTITY_ACTIVE) { lighting.AddLight(state.entities.Get(i).Position(), 1.5f, color, intensity); }
+    }
+    return;
+  }
+  for (int i = 0; i < pool.Count(); i++) {
+    lighting.AddLight(state.entities.Get(pool.Row(i)).Position(), 1.5f, color, intensity);
+  }
 }
 
 void Render() {
+  renderScale.Begin(governor.Settings().renderScale);
+  lighting.SetViewport(renderScale.renderWidth, renderScale.renderHeight);
   glClear(GL_COLOR_BUFFER_BIT);
 
-  switch (mode) {
+  switch (state.mode) {
     case WIN:
       DrawText(&program, *fontTexID, "VICTORY!", 2.0f, -0.25f, glm::vec3(-7.0f, 1.0f, 0.0f));
       break;
@@ -389,50 +773,246 @@ void Render() {
       DrawText(&program, *fontTexID, "YOU DIED", 2.0f, -0.25f, glm::vec3(-5.0f, 1.0f, 0.0f));
       break;
   }
+
+  //rebuild the hud text on its interval, or straight away the first time
+  if (textFrames % governor.Settings().textInterval == 0 || healthText.text.empty()) {
+    BuildText(&healthText, "HEALTH:" + std::to_string(Player().health), 1.5f, -0.25f);
+    BuildText(&bossHealthText, "BOSS HEALTH:" + std::to_string(Boss().health), 1.5f, -0.25f);
+  }
+  textFrames++;
+
   //draw health
-  DrawText(&program, *fontTexID, "HEALTH:" + std::to_string(state.player->health), 1.5f, -0.25f, glm::vec3(-19.0f, -14.5f, 0.0f));
+  DrawTextMesh(&program, *fontTexID, &healthText, glm::vec3(-19.0f, -14.5f, 0.0f));
 
   //draw boss health
   if (BOSS_TEXT) {
-    DrawText(&program, *fontTexID, "BOSS HEALTH:" + std::to_string(state.enemies[9].health), 1.5f, -0.25f, glm::vec3(-19.0f, 14.0f, 0.0f));
-  }
-
-  //render bullets
-  for (int i = 0; i < BULLET_COUNT; i++) {
-    state.bullets[i].Render(&program);
+    DrawTextMesh(&program, *fontTexID, &bossHealthText, glm::vec3(-19.0f, 14.0f, 0.0f));
   }
 
-  //render enemy bullets
-  for (int i = 0; i < ENEMY_BULLET_COUNT; i++) {
-    state.enemyBullets[i].Render(&program);
+  //render bullets and enemy bullets, a spectator's pools are never filled in so it goes by the
+  //active flags instead
+  if (spectator.isWatching) {
+    state.entities.Render(&program, state.bullets.range);
+    state.entities.Render(&program, state.enemyBullets.range);
+  } else {
+    state.entities.Render(&program, state.bullets);
+    state.entities.Render(&program, state.enemyBullets);
   }
 
   //render enemies
-  for (int i = 0; i < ENEMY_COUNT; i++) {
-    state.enemies[i].Render(&program);
+  state.entities.Render(&program, state.enemies);
+
+  //render player, late latched: pick up input that came in after the update and draw the player
+  //where the newest keys will have moved it by the next step, the simulation doesn't see this
+  glm::vec3 latch = glm::vec3(0);
+  if (state.mode == PLAYING && golden.isRunning == false && spectator.isWatching == false) {
+    input.Pump(PollEvent);
+    glm::vec3 movement = MovementFromKeys(input.latestKeys);
+    if (input.lastKeyDown != 0 && glm::length(movement) > 0.0f) { latency.Input(input.lastKeyDown); }
+    latch = movement * ToFloat(Player().speed) * accumulator;
+  }
+  EntityRange playerRange;
+  playerRange.begin = state.player;
+  playerRange.end = state.player + 1;
+  state.entities.Render(&program, playerRange, latch);
+
+  particles.Render(viewMatrix, projectionMatrix);
+
+  //bullet glows, then light everything in one pass
+  AddBulletLights(state.bullets, glm::vec3(0.4f, 0.6f, 1.0f), 0.5f);
+  AddBulletLights(state.enemyBullets, glm::vec3(1.0f, 0.2f, 0.2f), 0.4f);
+  lighting.Render();
+
+  //latency marker in the corner for a photodiode or camera to check the numbers against
+  if (latency.pending) {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(renderScale.renderWidth - 32, 0, 32, 32);
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(0.2f, 0.2f, 0.2f, 1.0f);
+    glDisable(GL_SCISSOR_TEST);
   }
 
-  //render player
-  state.player->Render(&program);
+  renderScale.End();
+
+  //work for the frame, not counting the wait on the swap so vsync doesn't look like load
+  float frameMs = (float)((double)(SDL_GetPerformanceCounter() - frameStart) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+  governor.AddFrame(frameMs);
+  ApplyQuality();
+
+  //read back before the swap so the back buffer still holds this frame
+  capture.Capture();
+  if (golden.isRunning && golden.EndFrame() == false) { gameIsRunning = false; }
   
   SDL_GL_SwapWindow(displayWindow);
+  latency.Presented();
 }
 
 
-void Shutdown() {
+//a spectator without a window, watches until the broadcast ends or steps frames have been shown
+void RunSpectator(int steps) {
+  SetupLevel();
+  if (spectator.Start(spectatePort, spectateServerPort) == false) { return; }
+
+  Uint32 lastHeard = SDL_GetTicks();
+  while (spectator.ended == false && spectator.framesApplied < steps) {
+    if (spectator.Poll(state, &BOSS_TEXT)) { lastHeard = SDL_GetTicks(); }
+    //the server may never have started, or gone without saying so
+    if (SDL_GetTicks() - lastHeard > BROADCAST_TIMEOUT_MS) {
+      std::cout << "spectate: nothing from port " << spectateServerPort << " for a while, giving up\n";
+      break;
+    }
+    SDL_Delay(1);
+  }
+  spectator.Report();
+  ReportLevel();
+}
+
+int Shutdown() {
+  capture.Stop();
+  capture.Report();
+  ReportLevel();
+  recorder.Finish();
+  recorder.Report();
+  replay.Report();
+  broadcast.Stop();
+  broadcast.Report();
+  spectator.Report();
+  snapshot.Report();
+  scheduler.Report();
+  history.Report();
+  governor.Report();
+  latency.Report();
+  audio.Close();
+  audio.Report();
+  jobs.Report();
+  jobs.Stop();
+  state.bullets.grid.Report("player bullets");
+  state.enemyBullets.grid.Report("enemy bullets");
+  state.collisions.Report();
+  int failures = 0;
+  if (goldenScript != NULL) { failures = golden.Finish(); }
   SDL_Quit();
+  return failures;
 }
 
 int main(int argc, char* argv[]) {
+  // --capture <file> records the session, .y4m for video or anything else for raw rgba
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+      capturePath = argv[++i];
+    }
+    // --golden <script> <dir> checks frames against <dir>, add --update-golden to rewrite them
+    else if (strcmp(argv[i], "--golden") == 0 && i + 2 < argc) {
+      goldenScript = argv[++i];
+      goldenDir = argv[++i];
+    }
+    else if (strcmp(argv[i], "--update-golden") == 0) {
+      goldenUpdate = true;
+    }
+    // --latency measures input to photon on every key press, this waits on the gpu each frame
+    else if (strcmp(argv[i], "--latency") == 0) {
+      latency.isRunning = true;
+    }
+    // --jobs <n> sets how many threads run the simulation, 1 keeps it all on the main thread
+    else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+      jobWorkers = atoi(argv[++i]);
+    }
+    // --time-scale <x> runs the game x times as fast as the clock, [ and ] change it while playing
+    else if (strcmp(argv[i], "--time-scale") == 0 && i + 1 < argc) {
+      SetTimeScale((float)atof(argv[++i]));
+    }
+    // --batch <steps> runs that many steps with made up input as fast as possible and exits
+    else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+      batchSteps = atoi(argv[++i]);
+    }
+    // --record <file> logs every step's input so the session can be played back with --replay
+    else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+      recordPath = argv[++i];
+    }
+    // --replay <file> plays a recording instead of reading the keyboard, --seek <step> starts it
+    // that many steps in
+    else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+      replayPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+      seekStep = atoi(argv[++i]);
+    }
+    // --catch-up <drop|slow> is what happens to the steps over --max-steps <n> in a frame after a
+    // stall, drop skips them and slow runs them over the next few frames
+    else if (strcmp(argv[i], "--catch-up") == 0 && i + 1 < argc) {
+      scheduler.policy = strcmp(argv[++i], "drop") == 0 ? DROP_TIME : SLOW_DOWN;
+    }
+    else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc) {
+      scheduler.maxStepsPerFrame = atoi(argv[++i]);
+      if (scheduler.maxStepsPerFrame < 1) { scheduler.maxStepsPerFrame = 1; }
+    }
+    // --resume <file> starts from a snapshot F5 wrote, F5 and F9 then use that file too
+    else if (strcmp(argv[i], "--resume") == 0 && i + 1 < argc) {
+      snapshotPath = argv[++i];
+      resumeSnapshot = true;
+    }
+    // --broadcast <port> sends the game to spectators started with --spectate <port> <broadcast port>
+    else if (strcmp(argv[i], "--broadcast") == 0 && i + 1 < argc) {
+      broadcastPort = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "--spectate") == 0 && i + 2 < argc) {
+      spectatePort = atoi(argv[++i]);
+      spectateServerPort = atoi(argv[++i]);
+    }
+    // --level <file> plays a level compiled with --compile-level <text file> <level file>, which
+    // writes the level and exits
+    else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+      levelPath = argv[++i];
+    }
+    else if (strcmp(argv[i], "--compile-level") == 0 && i + 2 < argc) {
+      const char *sourcePath = argv[++i];
+      return CompileLevel(sourcePath, argv[++i]) ? 0 : 1;
+    }
+    // --quality <level> pins the quality level instead of following the frame time
+    else if (strcmp(argv[i], "--quality") == 0 && i + 1 < argc) {
+      pinnedQuality = atoi(argv[++i]);
+    }
+    // --particle-bench times the particle update on its own and exits
+    else if (strcmp(argv[i], "--particle-bench") == 0) {
+      BenchmarkParticles(100000, 600);
+      return 0;
+    }
+    // --sim-bench times movement and collision with floats and with fixed point and exits
+    else if (strcmp(argv[i], "--sim-bench") == 0) {
+      BenchmarkSimulation(2000, 3000);
+      return 0;
+    }
+  }
+
+  if (levelPath != NULL) {
+    if (levelFile.Open(levelPath) == false) { return 1; }
+    level = &levelFile.level;
+  }
+  //a recording starts from the level's first step, that is where playback starts it too
+  if (resumeSnapshot && (recordPath != NULL || replayPath != NULL)) {
+    std::cout << "--resume can't be used with --record or --replay, recordings start from the level's first step\n";
+    return 1;
+  }
+  if (broadcastPort > 0 && broadcast.Start(broadcastPort) == false) { return 1; }
+  if (batchSteps > 0) {
+    if (spectatePort > 0) { RunSpectator(batchSteps); }
+    else { RunBatch(batchSteps); }
+    return 0;
+  }
+
   Initialize();
+  if (spectatePort > 0 && spectator.Start(spectatePort, spectateServerPort) == false) { gameIsRunning = false; }
+  //pick up where a snapshot on disk left off
+  if (resumeSnapshot) { RestoreSnapshot(); }
   
   while (gameIsRunning) {
+    frameStart = SDL_GetPerformanceCounter();
     ProcessInput();
     Update();
     Render();
   }
   
-  Shutdown();
-  return 0;
+  return Shutdown() == 0 ? 0 : 1;
 }
 
@@ -0,0 +1,39 @@
+// has to match Lighting.h
+#define LIGHT_MAX 64
+#define LIGHT_TILE_SIZE 32.0
+#define LIGHT_TILE_MAX 7
+
+// 2 texels per tile: count, then up to 7 light indices, all as bytes
+uniform sampler2D tileLights;
+uniform vec2 tileTextureSize;
+
+// xy = window position, z = radius, w = intensity
+uniform vec4 lights[LIGHT_MAX];
+uniform vec3 lightColors[LIGHT_MAX];
+
+void main() {
+    vec2 tile = floor(gl_FragCoord.xy / LIGHT_TILE_SIZE);
+    float row = (tile.y + 0.5) / tileTextureSize.y;
+    vec4 head = texture2D(tileLights, vec2((tile.x * 2.0 + 0.5) / tileTextureSize.x, row));
+    vec4 tail = texture2D(tileLights, vec2((tile.x * 2.0 + 1.5) / tileTextureSize.x, row));
+
+    float ids[LIGHT_TILE_MAX];
+    ids[0] = head.g;
+    ids[1] = head.b;
+    ids[2] = head.a;
+    ids[3] = tail.r;
+    ids[4] = tail.g;
+    ids[5] = tail.b;
+    ids[6] = tail.a;
+
+    int count = int(head.r * 255.0 + 0.5);
+    vec3 total = vec3(0.0);
+    for (int i = 0; i < LIGHT_TILE_MAX; i++) {
+        if (i >= count) { break; }
+        int index = int(ids[i] * 255.0 + 0.5);
+        vec4 light = lights[index];
+        float falloff = clamp(1.0 - distance(gl_FragCoord.xy, light.xy) / light.z, 0.0, 1.0);
+        total += lightColors[index] * light.w * falloff * falloff;
+    }
+    gl_FragColor = vec4(total, 1.0);
+}
@@ -0,0 +1,8 @@
+varying vec2 texCoordVar;
+varying vec4 colorVar;
+
+void main() {
+    // soft round dot, no texture needed
+    float d = length(texCoordVar - vec2(0.5)) * 2.0;
+    gl_FragColor = vec4(colorVar.rgb, colorVar.a * clamp(1.0 - d, 0.0, 1.0));
+}